@@ -2,6 +2,7 @@
 
 #include <SDL3/SDL.h>
 
+#include "Core/JobSystem.h"
 #include "Utils/Log.h"
 #include "Utils/StartupHelper.h"
 #include "IO/VFS.h"
@@ -19,6 +20,8 @@ bool Application::Init()
 {
     LogMsg("Application Initialize.");
 
+    JobSystem::Init();
+
     VFS::Mount("", "Sandbox/");
 
     WindowInfo windowInfo;
@@ -58,7 +61,7 @@ void Application::Run()
     auto actor = Scene::CreateActor<Actor>();
 
     auto sprite = Scene::CreateComponent<SpriteComponent>();
-    sprite->SetTexture(m_ResourceManager->LoadTexture("res/textures/texture.jpg"));
+    sprite->SetTexture(m_ResourceManager->LoadTextureAsync("res/textures/texture.jpg"));
     sprite->SetLocalTransform(glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, 1.0f, 1.0f)));
 
     actor->SetRootComponent(sprite.get());
@@ -76,6 +79,7 @@ void Application::Run()
             float deltaTime = static_cast<float>((currentTicks - m_PreviousTicks) / m_PerformanceFrequency);
             m_PreviousTicks = currentTicks;
 
+            m_ResourceManager->Update();
             m_Scene->Update(deltaTime);
             m_RenderSystem->Render(m_Scene);
 
@@ -88,6 +92,9 @@ void Application::Shutdown()
 {
     LogMsg("Application Shutdown.");
 
+    // Pending read callbacks may still reach into the systems below.
+    VFS::Shutdown();
+
     if (m_RenderSystem != nullptr)
     {
         delete m_RenderSystem;
@@ -113,6 +120,8 @@ void Application::Shutdown()
         delete m_Window;
         m_Window = nullptr;
     }
+
+    JobSystem::Shutdown();
 }
 
 } // namespace aero3d
\ No newline at end of file
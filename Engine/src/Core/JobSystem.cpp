@@ -0,0 +1,223 @@
+#include "Core/JobSystem.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Utils/Log.h"
+
+namespace aero3d {
+
+struct Job
+{
+    JobSystem::JobFunc func;
+    JobCounter* counter = nullptr;
+};
+
+// Owner pushes and pops at the back, thieves take from the front so they
+// grab the oldest (usually largest) pieces of work.
+struct WorkQueue
+{
+    std::mutex mutex;
+    std::deque<Job> jobs;
+
+    void Push(Job&& job)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+
+    bool Pop(Job& job)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty())
+            return false;
+        job = std::move(jobs.back());
+        jobs.pop_back();
+        return true;
+    }
+
+    bool Steal(Job& job)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty())
+            return false;
+        job = std::move(jobs.front());
+        jobs.pop_front();
+        return true;
+    }
+};
+
+static std::vector<std::unique_ptr<WorkQueue>> s_Queues;
+static std::vector<std::thread> s_Workers;
+
+static std::atomic<bool> s_Running = false;
+static std::atomic<uint32_t> s_QueuedJobs = 0;
+static std::mutex s_WakeMutex;
+static std::condition_variable s_WakeCondition;
+
+static thread_local uint32_t t_ThreadIndex = 0;
+
+static bool TryGetJob(uint32_t threadIndex, Job& job)
+{
+    if (s_Queues[threadIndex]->Pop(job))
+    {
+        s_QueuedJobs--;
+        return true;
+    }
+
+    uint32_t queueCount = static_cast<uint32_t>(s_Queues.size());
+    for (uint32_t i = 1; i < queueCount; ++i)
+    {
+        if (s_Queues[(threadIndex + i) % queueCount]->Steal(job))
+        {
+            s_QueuedJobs--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void RunJob(Job& job)
+{
+    job.func();
+    job.counter->pending--;
+}
+
+static void WorkerLoop(uint32_t threadIndex)
+{
+    t_ThreadIndex = threadIndex;
+
+    while (s_Running)
+    {
+        Job job;
+        if (TryGetJob(threadIndex, job))
+        {
+            RunJob(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(s_WakeMutex);
+        s_WakeCondition.wait(lock, []() { return !s_Running || s_QueuedJobs > 0; });
+    }
+}
+
+static void Submit(Job&& job)
+{
+    job.counter->pending++;
+
+    if (s_Workers.empty())
+    {
+        RunJob(job);
+        return;
+    }
+
+    s_Queues[t_ThreadIndex]->Push(std::move(job));
+    s_QueuedJobs++;
+
+    {
+        std::lock_guard<std::mutex> lock(s_WakeMutex);
+    }
+    s_WakeCondition.notify_one();
+}
+
+void JobSystem::Init(uint32_t workerCount)
+{
+    if (workerCount == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    LogMsg("Job System Initialize. Workers: %u", workerCount);
+
+    s_Running = true;
+
+    for (uint32_t i = 0; i < workerCount + 1; ++i)
+    {
+        s_Queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    for (uint32_t i = 1; i < workerCount + 1; ++i)
+    {
+        s_Workers.emplace_back(WorkerLoop, i);
+    }
+}
+
+void JobSystem::Shutdown()
+{
+    LogMsg("Job System Shutdown.");
+
+    {
+        std::lock_guard<std::mutex> lock(s_WakeMutex);
+        s_Running = false;
+    }
+    s_WakeCondition.notify_all();
+
+    for (auto& worker : s_Workers)
+    {
+        worker.join();
+    }
+
+    s_Workers.clear();
+    s_Queues.clear();
+}
+
+void JobSystem::Execute(JobCounter& counter, JobFunc job)
+{
+    Submit({ std::move(job), &counter });
+}
+
+void JobSystem::Dispatch(JobCounter& counter, uint32_t jobCount, uint32_t groupSize, DispatchFunc job)
+{
+    if (jobCount == 0 || groupSize == 0)
+        return;
+
+    auto shared = std::make_shared<DispatchFunc>(std::move(job));
+
+    for (uint32_t groupStart = 0; groupStart < jobCount; groupStart += groupSize)
+    {
+        uint32_t groupEnd = std::min(groupStart + groupSize, jobCount);
+
+        Submit({ [shared, groupStart, groupEnd]()
+        {
+            for (uint32_t i = groupStart; i < groupEnd; ++i)
+            {
+                (*shared)(i);
+            }
+        }, &counter });
+    }
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+    while (counter.pending > 0)
+    {
+        Job job;
+        if (!s_Queues.empty() && TryGetJob(t_ThreadIndex, job))
+        {
+            RunJob(job);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+uint32_t JobSystem::GetThreadCount()
+{
+    return static_cast<uint32_t>(s_Workers.size()) + 1;
+}
+
+uint32_t JobSystem::GetThreadIndex()
+{
+    return t_ThreadIndex;
+}
+
+} // namespace aero3d
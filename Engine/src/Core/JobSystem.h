@@ -0,0 +1,40 @@
+#ifndef AERO3D_CORE_JOBSYSTEM_H_
+#define AERO3D_CORE_JOBSYSTEM_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace aero3d {
+
+struct JobCounter
+{
+    std::atomic<uint32_t> pending = 0;
+};
+
+class JobSystem
+{
+public:
+    using JobFunc = std::function<void()>;
+    using DispatchFunc = std::function<void(uint32_t index)>;
+
+public:
+    // Spawns worker threads. Zero picks one worker per hardware thread,
+    // leaving a core for the calling thread.
+    static void Init(uint32_t workerCount = 0);
+    static void Shutdown();
+
+    static void Execute(JobCounter& counter, JobFunc job);
+    static void Dispatch(JobCounter& counter, uint32_t jobCount, uint32_t groupSize, DispatchFunc job);
+
+    // Runs queued jobs on the calling thread until the counter drains.
+    static void Wait(JobCounter& counter);
+
+    static uint32_t GetThreadCount();
+    static uint32_t GetThreadIndex();
+
+};
+
+} // namespace aero3d
+
+#endif // AERO3D_CORE_JOBSYSTEM_H_
@@ -0,0 +1,96 @@
+#include "Graphics/BindlessTextureTable.h"
+
+#include "Utils/Log.h"
+
+namespace aero3d {
+
+BindlessTextureTable::BindlessTextureTable(GraphicsDevice* graphicsDevice, ResourceFactory* resourceFactory,
+    uint32_t capacity)
+{
+    m_GraphicsDevice = graphicsDevice;
+    m_Capacity = capacity;
+
+    ResourceLayoutDesc layoutDescription;
+    layoutDescription.bindings =
+    {
+        { BINDLESS_SAMPLER_BINDING, ResourceKind::Sampler, STAGE_FRAGMENT },
+        { BINDLESS_TEXTURE_BINDING, ResourceKind::TextureReadOnlyArray, STAGE_FRAGMENT, capacity, true },
+    };
+
+    m_ResourceLayout = resourceFactory->CreateResourceLayout(layoutDescription);
+
+    SamplerDesc samplerDescription;
+    m_Sampler = resourceFactory->CreateSampler(samplerDescription);
+
+    ResourceSetDesc setDescription;
+    setDescription.layout = m_ResourceLayout;
+    setDescription.resources = { m_Sampler, std::vector<Ref<TextureView>>{} };
+
+    m_ResourceSet = resourceFactory->CreateResourceSet(setDescription);
+}
+
+uint32_t BindlessTextureTable::Register(Ref<TextureView> textureView)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (textureView->m_BindlessIndex != INVALID_BINDLESS_INDEX)
+        return textureView->m_BindlessIndex;
+
+    uint32_t index = INVALID_BINDLESS_INDEX;
+
+    if (!m_FreeSlots.empty())
+    {
+        index = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+    }
+    else if (m_Slots.size() < m_Capacity)
+    {
+        index = static_cast<uint32_t>(m_Slots.size());
+        m_Slots.emplace_back();
+    }
+    else
+    {
+        LogErr(ERROR_INFO, "Bindless texture table is full (%u textures).", m_Capacity);
+        return INVALID_BINDLESS_INDEX;
+    }
+
+    m_Slots[index].textureView = textureView;
+    m_Slots[index].occupied = true;
+    textureView->m_BindlessIndex = index;
+
+    m_GraphicsDevice->UpdateResourceSet(m_ResourceSet, BINDLESS_TEXTURE_BINDING, index, textureView);
+
+    return index;
+}
+
+void BindlessTextureTable::Update()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    uint64_t frameNumber = m_GraphicsDevice->GetFrameNumber();
+
+    for (auto it = m_PendingSlots.begin(); it != m_PendingSlots.end(); )
+    {
+        if (frameNumber >= it->frameNumber + MAX_FRAMES_IN_FLIGHT)
+        {
+            m_FreeSlots.push_back(it->index);
+            it = m_PendingSlots.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    for (uint32_t i = 0; i < m_Slots.size(); ++i)
+    {
+        if (m_Slots[i].occupied && m_Slots[i].textureView.expired())
+        {
+            m_Slots[i].textureView.reset();
+            m_Slots[i].occupied = false;
+            m_PendingSlots.push_back({ i, frameNumber });
+        }
+    }
+}
+
+} // namespace aero3d
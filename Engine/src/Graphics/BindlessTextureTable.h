@@ -0,0 +1,66 @@
+#ifndef AERO3D_GRAPHICS_BINDLESSTEXTURETABLE_H_
+#define AERO3D_GRAPHICS_BINDLESSTEXTURETABLE_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Graphics/GraphicsDevice.h"
+#include "Graphics/ResourceFactory.h"
+#include "Graphics/Resources.h"
+#include "Utils/Common.h"
+
+namespace aero3d {
+
+constexpr uint32_t BINDLESS_SAMPLER_BINDING = 0;
+constexpr uint32_t BINDLESS_TEXTURE_BINDING = 1;
+
+// One large texture array every registered view gets a stable index in.
+// Shaders index it directly, so draws never need to rebind textures.
+class BindlessTextureTable
+{
+public:
+    BindlessTextureTable(GraphicsDevice* graphicsDevice, ResourceFactory* resourceFactory, uint32_t capacity);
+    ~BindlessTextureTable() = default;
+
+    uint32_t Register(Ref<TextureView> textureView);
+
+    // Recycles slots of destroyed views once no frame in flight can use them.
+    void Update();
+
+    Ref<ResourceLayout> GetResourceLayout() { return m_ResourceLayout; }
+    Ref<ResourceSet> GetResourceSet() { return m_ResourceSet; }
+    uint32_t GetCapacity() const { return m_Capacity; }
+
+private:
+    struct Slot
+    {
+        std::weak_ptr<TextureView> textureView;
+        bool occupied = false;
+    };
+
+    struct PendingSlot
+    {
+        uint32_t index;
+        uint64_t frameNumber;
+    };
+
+private:
+    GraphicsDevice* m_GraphicsDevice = nullptr;
+    uint32_t m_Capacity = 0;
+
+    Ref<ResourceLayout> m_ResourceLayout = nullptr;
+    Ref<ResourceSet> m_ResourceSet = nullptr;
+    Ref<Sampler> m_Sampler = nullptr;
+
+    std::mutex m_Mutex;
+    std::vector<Slot> m_Slots;
+    std::vector<uint32_t> m_FreeSlots;
+    std::vector<PendingSlot> m_PendingSlots;
+
+};
+
+} // namespace aero3d
+
+#endif // AERO3D_GRAPHICS_BINDLESSTEXTURETABLE_H_
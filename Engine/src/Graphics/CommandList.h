@@ -2,23 +2,38 @@
 #define AERO3D_GRAPHICS_COMMANDLIST_H_
 
 #include <cstdint>
+#include <vector>
 
 #include "Graphics/Resources.h"
 #include "Utils/Common.h"
 
 namespace aero3d {
 
+enum class CommandListLevel
+{
+    Primary,
+    Secondary
+};
+
 class CommandList 
 {
 public:
     virtual ~CommandList() = default;
 
     virtual void Begin() = 0;
+    // Secondary lists draw into the framebuffer bound by the primary that
+    // executes them, so they need it when recording starts.
+    virtual void BeginSecondary(Ref<Framebuffer> framebuffer) = 0;
     virtual void End() = 0;
 
-    virtual void SetFramebuffer(Ref<Framebuffer> framebuffer) = 0;
+    // Clears folded into the pass are free on tiled GPUs, unlike ClearRenderTargets.
+    virtual void BeginRenderPass(const RenderPassDesc& renderPass) = 0;
+    virtual void EndRenderPass() = 0;
+
+    // Starts a pass that keeps the framebuffer contents.
+    virtual void SetFramebuffer(Ref<Framebuffer> framebuffer, bool secondaryContents = false) = 0;
     virtual void SetPipeline(Ref<Pipeline> pipeline) = 0;
-    virtual void SetVertexBuffer(Ref<DeviceBuffer> buffer, uint32_t offset = 0) = 0;
+    virtual void SetVertexBuffer(uint32_t index, Ref<DeviceBuffer> buffer, uint32_t offset = 0) = 0;
     virtual void SetIndexBuffer(Ref<DeviceBuffer> buffer, IndexFormat format, uint32_t offset = 0) = 0;
     virtual void SetResourceSet(uint32_t slot, Ref<ResourceSet> resourceSet) = 0;
 
@@ -30,6 +45,12 @@ public:
     virtual void ClearRenderTargets(float r, float g, float b, float a) = 0;
     virtual void ClearDepthStencil() = 0;
 
+    virtual void ExecuteCommands(const std::vector<Ref<CommandList>>& commandLists) = 0;
+
+    // Must be recorded outside of render passes. All barriers go out as one
+    // batch.
+    virtual void Barrier(const std::vector<TextureBarrier>& barriers) = 0;
+
 };
 
 } // namespace aero3d
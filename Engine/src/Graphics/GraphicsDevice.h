@@ -1,6 +1,8 @@
 #ifndef AERO3D_GRAPHICS_GRAPHICSDEVICE_H_
 #define AERO3D_GRAPHICS_GRAPHICSDEVICE_H_
 
+#include <functional>
+
 #include "Graphics/CommandList.h"
 #include "Graphics/Resources.h"
 #include "Graphics/Swapchain.h"
@@ -11,6 +13,10 @@ class SDL_Window;
 
 namespace aero3d {
 
+class BindlessTextureTable;
+
+constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+
 enum class RenderingAPI
 {
     DirectX12,
@@ -48,15 +54,39 @@ class GraphicsDevice
 public:
     virtual ~GraphicsDevice() = default;
 
-    virtual Ref<CommandList> CreateCommandList() = 0;
+    // Secondary lists may be recorded on any job system thread.
+    virtual Ref<CommandList> CreateCommandList(CommandListLevel level = CommandListLevel::Primary) = 0;
     virtual ResourceFactory* GetResourceFactory() = 0;
     virtual Swapchain* GetSwapchain() = 0;
 
+    // Returns false when no swapchain image could be acquired, in which case
+    // the frame should be skipped and EndFrame not called.
+    virtual bool BeginFrame() = 0;
+    virtual void EndFrame() = 0;
+    virtual void WaitIdle() = 0;
+    virtual uint64_t GetFrameNumber() = 0;
+
     virtual void SubmitCommands(Ref<CommandList> commandList) = 0;
-    virtual void Present() = 0;
 
     virtual void UpdateBuffer(Ref<DeviceBuffer> buffer, void* data, size_t size, size_t offset = 0) = 0;
+    virtual void* MapBuffer(Ref<DeviceBuffer> buffer) = 0;
     virtual void UpdateTexture(Ref<Texture> texture, void* data, size_t size) = 0;
+    // Queues the upload without waiting for it. The texture must not be
+    // sampled before IsUploadComplete returned true for the returned value.
+    virtual uint64_t UploadTextureAsync(Ref<Texture> texture, const void* data, size_t size) = 0;
+    // Same, but write fills size bytes of staging memory itself, so the
+    // data never needs an intermediate copy.
+    virtual uint64_t UploadTextureAsync(Ref<Texture> texture, size_t size,
+        const std::function<void(void*)>& write) = 0;
+    virtual bool IsUploadComplete(uint64_t upload) = 0;
+    virtual void UpdateResourceSet(Ref<ResourceSet> resourceSet, uint32_t binding, uint32_t arrayElement,
+        Ref<TextureView> textureView) = 0;
+
+    // Whether textures of this format can be created and sampled.
+    virtual bool IsFormatSupported(TextureFormat format) = 0;
+
+    // Null when the device has no descriptor indexing support.
+    virtual BindlessTextureTable* GetBindlessTextureTable() = 0;
 
 };
 
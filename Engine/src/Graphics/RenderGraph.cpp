@@ -0,0 +1,354 @@
+#include "Graphics/RenderGraph.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "Utils/Assert.h"
+#include "Utils/Log.h"
+
+namespace aero3d {
+
+static bool IsCompatible(const TextureDesc& a, const TextureDesc& b)
+{
+    return a.width == b.width && a.height == b.height && a.depth == b.depth &&
+        a.mipLevels == b.mipLevels && a.arrayLayers == b.arrayLayers &&
+        a.format == b.format && a.usage == b.usage;
+}
+
+RenderGraphPass& RenderGraphPass::Read(RenderGraphResource resource, ResourceState state)
+{
+    AddAccess(resource, state, false);
+    return *this;
+}
+
+RenderGraphPass& RenderGraphPass::Write(RenderGraphResource resource, ResourceState state)
+{
+    AddAccess(resource, state, true);
+    return *this;
+}
+
+void RenderGraphPass::AddAccess(RenderGraphResource resource, ResourceState state, bool write)
+{
+    // A pass uses a resource in one state, a write decides it.
+    for (auto& access : m_Accesses)
+    {
+        if (access.resource != resource)
+            continue;
+
+        if (write || !access.write)
+        {
+            access.state = state;
+        }
+        access.write |= write;
+        return;
+    }
+
+    m_Accesses.push_back({ resource, state, write });
+}
+
+RenderGraph::RenderGraph(GraphicsDevice* graphicsDevice, ResourceFactory* resourceFactory)
+{
+    m_GraphicsDevice = graphicsDevice;
+    m_ResourceFactory = resourceFactory;
+}
+
+RenderGraphResource RenderGraph::ImportTexture(Ref<Texture> texture, ResourceState initialState,
+    ResourceState finalState, bool preserveContents)
+{
+    Resource resource;
+    resource.texture = texture;
+    resource.desc = texture->GetDescription();
+    resource.state = initialState;
+    resource.finalState = finalState;
+    resource.imported = true;
+    resource.preserveContents = preserveContents;
+
+    m_Resources.push_back(resource);
+    return static_cast<RenderGraphResource>(m_Resources.size() - 1);
+}
+
+RenderGraphResource RenderGraph::CreateTexture(const TextureDesc& desc)
+{
+    Resource resource;
+    resource.desc = desc;
+    resource.preserveContents = false;
+
+    m_Resources.push_back(resource);
+    return static_cast<RenderGraphResource>(m_Resources.size() - 1);
+}
+
+RenderGraphPass& RenderGraph::AddPass(const std::string& name, std::function<void(Ref<CommandList>)> execute)
+{
+    auto pass = std::make_unique<RenderGraphPass>();
+    pass->m_Name = name;
+    pass->m_Execute = std::move(execute);
+
+    m_Passes.push_back(std::move(pass));
+    return *m_Passes.back();
+}
+
+void RenderGraph::Execute(Ref<CommandList> commandList)
+{
+    for (uint32_t i = 0; i < m_Passes.size(); i++)
+    {
+        for (const auto& access : m_Passes[i]->m_Accesses)
+        {
+            if (access.resource >= m_Resources.size())
+            {
+                LogErr(ERROR_INFO, "Pass '%s' uses an unknown resource.", m_Passes[i]->m_Name.c_str());
+                continue;
+            }
+            Resource& resource = m_Resources[access.resource];
+            resource.firstPass = std::min(resource.firstPass, i);
+            resource.lastPass = i;
+        }
+    }
+
+    PlaceTransients();
+
+    std::vector<TextureBarrier> barriers;
+
+    for (uint32_t i = 0; i < m_Passes.size(); i++)
+    {
+        RenderGraphPass& pass = *m_Passes[i];
+
+        barriers.clear();
+        for (const auto& access : pass.m_Accesses)
+        {
+            if (access.resource >= m_Resources.size())
+                continue;
+
+            Resource& resource = m_Resources[access.resource];
+
+            if (!resource.accessed && !resource.imported && !access.write)
+            {
+                LogErr(ERROR_INFO, "Pass '%s' reads a transient texture before anything wrote it.",
+                    pass.m_Name.c_str());
+            }
+
+            // Read after read in the same state needs no barrier, everything
+            // else has to wait for the previous access.
+            if (resource.state != access.state || resource.lastAccessWrite || access.write)
+            {
+                TextureBarrier barrier;
+                barrier.texture = resource.texture;
+                barrier.before = resource.state;
+                barrier.after = access.state;
+                barrier.discard = !resource.accessed && !resource.preserveContents;
+                barrier.aliased = !resource.accessed && resource.aliased;
+                barriers.push_back(barrier);
+            }
+
+            resource.state = access.state;
+            resource.lastAccessWrite = access.write;
+            resource.accessed = true;
+        }
+
+        if (!barriers.empty())
+        {
+            commandList->Barrier(barriers);
+        }
+
+        pass.m_Execute(commandList);
+    }
+
+    barriers.clear();
+    for (auto& resource : m_Resources)
+    {
+        if (resource.placementIndex < m_Placements.size())
+        {
+            m_Placements[resource.placementIndex].state = resource.state;
+        }
+
+        if (!resource.imported || resource.state == resource.finalState)
+            continue;
+
+        TextureBarrier barrier;
+        barrier.texture = resource.texture;
+        barrier.before = resource.state;
+        barrier.after = resource.finalState;
+        barrier.discard = !resource.accessed && !resource.preserveContents;
+        barriers.push_back(barrier);
+    }
+
+    if (!barriers.empty())
+    {
+        commandList->Barrier(barriers);
+    }
+
+    Reset();
+}
+
+Ref<Texture> RenderGraph::GetTexture(RenderGraphResource resource)
+{
+    if (resource >= m_Resources.size())
+    {
+        LogErr(ERROR_INFO, "Unknown render graph resource %u.", resource);
+        return nullptr;
+    }
+    return m_Resources[resource].texture;
+}
+
+void RenderGraph::Reset()
+{
+    m_Passes.clear();
+    m_Resources.clear();
+}
+
+void RenderGraph::PlaceTransients()
+{
+    std::vector<uint32_t> transients;
+    for (uint32_t i = 0; i < m_Resources.size(); i++)
+    {
+        if (!m_Resources[i].imported && m_Resources[i].firstPass != UINT32_MAX)
+        {
+            transients.push_back(i);
+        }
+    }
+
+    if (!IsPlanCurrent(transients))
+    {
+        // The textures hold the old heap, it goes once they are gone.
+        m_Placements.clear();
+        m_TransientHeap = nullptr;
+
+        for (uint32_t index : transients)
+        {
+            const Resource& resource = m_Resources[index];
+
+            TransientPlacement placement;
+            placement.desc = resource.desc;
+            placement.firstPass = resource.firstPass;
+            placement.lastPass = resource.lastPass;
+            placement.texture = m_ResourceFactory->CreatePlacedTexture(placement.desc);
+            Assert(ERROR_INFO, placement.texture->IsValid(), "Failed to create a transient texture!");
+            placement.size = placement.texture->GetMemoryInfo().size;
+
+            m_Placements.push_back(placement);
+        }
+
+        // Largest first, smaller textures then fill the gaps between them.
+        std::vector<uint32_t> order(m_Placements.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+        {
+            return m_Placements[a].size > m_Placements[b].size;
+        });
+
+        TextureMemoryInfo heapInfo;
+        heapInfo.memoryTypeMask = UINT32_MAX;
+
+        std::vector<uint32_t> placed;
+        std::vector<const TransientPlacement*> conflicts;
+
+        for (uint32_t index : order)
+        {
+            TransientPlacement& placement = m_Placements[index];
+            TextureMemoryInfo info = placement.texture->GetMemoryInfo();
+
+            // Textures that can't share a memory type with the rest get their own.
+            if ((heapInfo.memoryTypeMask & info.memoryTypeMask) == 0)
+                continue;
+
+            // Only textures alive at the same time compete for memory.
+            conflicts.clear();
+            for (uint32_t other : placed)
+            {
+                const TransientPlacement& otherPlacement = m_Placements[other];
+                if (otherPlacement.firstPass <= placement.lastPass && placement.firstPass <= otherPlacement.lastPass)
+                {
+                    conflicts.push_back(&otherPlacement);
+                }
+            }
+
+            std::sort(conflicts.begin(), conflicts.end(), [](const TransientPlacement* a, const TransientPlacement* b)
+            {
+                return a->offset < b->offset;
+            });
+
+            uint64_t offset = 0;
+            for (const TransientPlacement* conflict : conflicts)
+            {
+                if (offset + info.size <= conflict->offset)
+                    break;
+
+                uint64_t end = conflict->offset + conflict->size;
+                offset = std::max(offset, (end + info.alignment - 1) & ~(info.alignment - 1));
+            }
+
+            placement.offset = offset;
+            placement.placed = true;
+            placed.push_back(index);
+
+            heapInfo.size = std::max(heapInfo.size, offset + info.size);
+            heapInfo.alignment = std::max(heapInfo.alignment, info.alignment);
+            heapInfo.memoryTypeMask &= info.memoryTypeMask;
+        }
+
+        for (uint32_t a = 0; a < placed.size(); a++)
+        {
+            for (uint32_t b = a + 1; b < placed.size(); b++)
+            {
+                TransientPlacement& first = m_Placements[placed[a]];
+                TransientPlacement& second = m_Placements[placed[b]];
+                if (first.offset < second.offset + second.size && second.offset < first.offset + first.size)
+                {
+                    first.aliased = true;
+                    second.aliased = true;
+                }
+            }
+        }
+
+        if (!placed.empty())
+        {
+            m_TransientHeap = m_ResourceFactory->CreateTextureHeap(heapInfo);
+            Assert(ERROR_INFO, m_TransientHeap->IsValid(), "Failed to allocate the transient texture heap!");
+        }
+
+        for (auto& placement : m_Placements)
+        {
+            if (placement.placed)
+            {
+                bool bound = m_TransientHeap->Place(placement.texture, placement.offset);
+                Assert(ERROR_INFO, bound, "Failed to place a transient texture!");
+                continue;
+            }
+
+            placement.texture = m_ResourceFactory->CreateTexture(placement.desc);
+            Assert(ERROR_INFO, placement.texture->IsValid(), "Failed to create a transient texture!");
+        }
+    }
+
+    for (uint32_t i = 0; i < transients.size(); i++)
+    {
+        Resource& resource = m_Resources[transients[i]];
+        const TransientPlacement& placement = m_Placements[i];
+
+        // Aliased memory may hold another texture's data, whatever state
+        // this one was left in last frame no longer applies.
+        resource.texture = placement.texture;
+        resource.aliased = placement.aliased;
+        resource.state = placement.aliased ? ResourceState::Undefined : placement.state;
+        resource.placementIndex = i;
+    }
+}
+
+bool RenderGraph::IsPlanCurrent(const std::vector<uint32_t>& transients) const
+{
+    if (transients.size() != m_Placements.size())
+        return false;
+
+    for (uint32_t i = 0; i < transients.size(); i++)
+    {
+        const Resource& resource = m_Resources[transients[i]];
+        const TransientPlacement& placement = m_Placements[i];
+
+        if (!IsCompatible(placement.desc, resource.desc) || placement.firstPass != resource.firstPass ||
+            placement.lastPass != resource.lastPass)
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace aero3d
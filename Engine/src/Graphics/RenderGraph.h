@@ -0,0 +1,123 @@
+#ifndef AERO3D_GRAPHICS_RENDERGRAPH_H_
+#define AERO3D_GRAPHICS_RENDERGRAPH_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Graphics/CommandList.h"
+#include "Graphics/GraphicsDevice.h"
+#include "Graphics/ResourceFactory.h"
+#include "Graphics/Resources.h"
+#include "Utils/Common.h"
+
+namespace aero3d {
+
+using RenderGraphResource = uint32_t;
+
+constexpr RenderGraphResource INVALID_RENDER_GRAPH_RESOURCE = UINT32_MAX;
+
+class RenderGraphPass
+{
+public:
+    RenderGraphPass& Read(RenderGraphResource resource, ResourceState state = ResourceState::ShaderRead);
+    RenderGraphPass& Write(RenderGraphResource resource, ResourceState state = ResourceState::RenderTarget);
+
+private:
+    friend class RenderGraph;
+
+    struct Access
+    {
+        RenderGraphResource resource = INVALID_RENDER_GRAPH_RESOURCE;
+        ResourceState state = ResourceState::Undefined;
+        bool write = false;
+    };
+
+    void AddAccess(RenderGraphResource resource, ResourceState state, bool write);
+
+private:
+    std::string m_Name;
+    std::vector<Access> m_Accesses;
+    std::function<void(Ref<CommandList>)> m_Execute;
+
+};
+
+// Built every frame: passes declare what they read and write, and Execute
+// records them in order with the barriers and layout transitions between
+// them. Transient textures are only alive between their first and last use,
+// those that are never alive at once share memory in one heap.
+class RenderGraph
+{
+public:
+    RenderGraph(GraphicsDevice* graphicsDevice, ResourceFactory* resourceFactory);
+    ~RenderGraph() = default;
+
+    // Without preserveContents the first use may discard what the texture
+    // held, e.g. a swapchain image that is cleared anyway.
+    RenderGraphResource ImportTexture(Ref<Texture> texture, ResourceState initialState,
+        ResourceState finalState, bool preserveContents = true);
+    RenderGraphResource CreateTexture(const TextureDesc& desc);
+
+    RenderGraphPass& AddPass(const std::string& name, std::function<void(Ref<CommandList>)> execute);
+
+    // Records all passes into the open command list, then resets the graph.
+    void Execute(Ref<CommandList> commandList);
+
+    // Only valid while the graph executes.
+    Ref<Texture> GetTexture(RenderGraphResource resource);
+
+    void Reset();
+
+private:
+    struct Resource
+    {
+        Ref<Texture> texture = nullptr;
+        TextureDesc desc = {};
+        ResourceState state = ResourceState::Undefined;
+        ResourceState finalState = ResourceState::Undefined;
+        bool imported = false;
+        bool preserveContents = true;
+        bool lastAccessWrite = true;
+        bool accessed = false;
+        bool aliased = false;
+        uint32_t firstPass = UINT32_MAX;
+        uint32_t lastPass = 0;
+        uint32_t placementIndex = UINT32_MAX;
+    };
+
+    // A transient's range in the heap. The plan is kept while the graph
+    // declares the same transients for the same passes.
+    struct TransientPlacement
+    {
+        Ref<Texture> texture = nullptr;
+        TextureDesc desc = {};
+        uint32_t firstPass = 0;
+        uint32_t lastPass = 0;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        // Shares memory with another placement, or has its own if unplaced.
+        bool aliased = false;
+        bool placed = false;
+        // Left from the previous frame, only tracked when not aliased.
+        ResourceState state = ResourceState::Undefined;
+    };
+
+    void PlaceTransients();
+    bool IsPlanCurrent(const std::vector<uint32_t>& transients) const;
+
+private:
+    GraphicsDevice* m_GraphicsDevice = nullptr;
+    ResourceFactory* m_ResourceFactory = nullptr;
+
+    std::vector<Resource> m_Resources;
+    std::vector<Scope<RenderGraphPass>> m_Passes;
+
+    Ref<TextureHeap> m_TransientHeap = nullptr;
+    std::vector<TransientPlacement> m_Placements;
+
+};
+
+} // namespace aero3d
+
+#endif // AERO3D_GRAPHICS_RENDERGRAPH_H_
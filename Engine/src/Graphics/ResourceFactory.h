@@ -14,6 +14,11 @@ public:
     virtual Ref<Pipeline> CreatePipeline(PipelineDesc& desc) = 0;
     virtual Ref<DeviceBuffer> CreateBuffer(BufferDesc& desc) = 0;
     virtual Ref<Texture> CreateTexture(TextureDesc& desc) = 0;
+    // The texture gets no memory until it is placed in a heap.
+    virtual Ref<Texture> CreatePlacedTexture(TextureDesc& desc) = 0;
+    // Sized and aligned for the textures it will hold, whose memory type
+    // masks must all contain one of info.memoryTypeMask.
+    virtual Ref<TextureHeap> CreateTextureHeap(const TextureMemoryInfo& info) = 0;
     virtual Ref<TextureView> CreateTextureView(TextureViewDesc& desc) = 0;
     virtual Ref<Sampler> CreateSampler(SamplerDesc& desc) = 0;
     virtual Ref<ResourceLayout> CreateResourceLayout(ResourceLayoutDesc& desc) = 0;
@@ -0,0 +1,151 @@
+#include "Graphics/ResourceSetCache.h"
+
+#include <type_traits>
+#include <variant>
+
+#include "Utils/Hash.h"
+
+namespace aero3d {
+
+// Flattens every resource of the description, returns false if the set
+// cannot be cached.
+static bool CollectResources(const ResourceSetDesc& desc, std::vector<const void*>& key,
+    std::vector<std::weak_ptr<void>>& resources)
+{
+    bool cacheable = true;
+
+    auto add = [&](const auto& resource)
+    {
+        key.push_back(resource.get());
+        if (resource)
+            resources.push_back(resource);
+    };
+
+    key.push_back(desc.layout.get());
+    resources.push_back(desc.layout);
+
+    for (const auto& ref : desc.resources)
+    {
+        std::visit([&](const auto& value)
+        {
+            using T = std::decay_t<decltype(value)>;
+
+            if constexpr (std::is_same_v<T, Ref<DeviceBuffer>>)
+            {
+                // Dynamic buffers are bound at the current frame's region,
+                // which the cache knows nothing about.
+                if (value && value->GetDescription().dynamic)
+                    cacheable = false;
+                add(value);
+            }
+            else if constexpr (std::is_same_v<T, Ref<TextureView>> || std::is_same_v<T, Ref<Sampler>>)
+            {
+                add(value);
+            }
+            else if constexpr (std::is_same_v<T, std::pair<Ref<TextureView>, Ref<Sampler>>>)
+            {
+                add(value.first);
+                add(value.second);
+            }
+            else if constexpr (std::is_same_v<T, std::vector<std::pair<Ref<TextureView>, Ref<Sampler>>>>)
+            {
+                for (const auto& pair : value)
+                {
+                    add(pair.first);
+                    add(pair.second);
+                }
+            }
+            else
+            {
+                for (const auto& resource : value)
+                {
+                    add(resource);
+                }
+            }
+        }, ref);
+
+        // Separates array elements from the next binding.
+        key.push_back(nullptr);
+    }
+
+    return cacheable;
+}
+
+ResourceSetCache::ResourceSetCache(ResourceFactory* resourceFactory, uint32_t capacity)
+{
+    m_ResourceFactory = resourceFactory;
+    m_Capacity = capacity;
+}
+
+Ref<ResourceSet> ResourceSetCache::GetOrCreate(ResourceSetDesc& desc)
+{
+    std::vector<const void*> key;
+    std::vector<std::weak_ptr<void>> resources;
+
+    if (!CollectResources(desc, key, resources))
+        return m_ResourceFactory->CreateResourceSet(desc);
+
+    uint64_t hash = HashFNV1a(key.data(), key.size() * sizeof(const void*));
+
+    auto lookupIt = m_Lookup.find(hash);
+    if (lookupIt != m_Lookup.end())
+    {
+        auto entryIt = lookupIt->second;
+        if (IsValid(*entryIt, key))
+        {
+            m_Entries.splice(m_Entries.begin(), m_Entries, entryIt);
+            return entryIt->resourceSet;
+        }
+
+        Evict(entryIt);
+    }
+
+    Entry entry;
+    entry.hash = hash;
+    entry.key = std::move(key);
+    entry.resources = std::move(resources);
+    entry.resourceSet = m_ResourceFactory->CreateResourceSet(desc);
+
+    m_Entries.push_front(std::move(entry));
+    m_Lookup[hash] = m_Entries.begin();
+
+    while (m_Entries.size() > m_Capacity)
+    {
+        Evict(std::prev(m_Entries.end()));
+    }
+
+    return m_Entries.front().resourceSet;
+}
+
+void ResourceSetCache::Clear()
+{
+    m_Lookup.clear();
+    m_Entries.clear();
+}
+
+bool ResourceSetCache::IsValid(const Entry& entry, const std::vector<const void*>& key) const
+{
+    if (entry.key != key)
+        return false;
+
+    for (const auto& resource : entry.resources)
+    {
+        if (resource.expired())
+            return false;
+    }
+
+    return true;
+}
+
+void ResourceSetCache::Evict(std::list<Entry>::iterator it)
+{
+    auto lookupIt = m_Lookup.find(it->hash);
+    if (lookupIt != m_Lookup.end() && lookupIt->second == it)
+    {
+        m_Lookup.erase(lookupIt);
+    }
+
+    m_Entries.erase(it);
+}
+
+} // namespace aero3d
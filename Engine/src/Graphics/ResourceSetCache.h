@@ -0,0 +1,56 @@
+#ifndef AERO3D_GRAPHICS_RESOURCESETCACHE_H_
+#define AERO3D_GRAPHICS_RESOURCESETCACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Graphics/ResourceFactory.h"
+#include "Graphics/Resources.h"
+#include "Utils/Common.h"
+
+namespace aero3d {
+
+constexpr uint32_t DEFAULT_RESOURCE_SET_CACHE_CAPACITY = 256;
+
+// Reuses resource sets whose layout and bound resources match a previous
+// request. Entries only hold weak references, so a destroyed resource whose
+// address gets reused can never produce a false hit.
+class ResourceSetCache
+{
+public:
+    ResourceSetCache(ResourceFactory* resourceFactory, uint32_t capacity = DEFAULT_RESOURCE_SET_CACHE_CAPACITY);
+    ~ResourceSetCache() = default;
+
+    Ref<ResourceSet> GetOrCreate(ResourceSetDesc& desc);
+    void Clear();
+
+    uint32_t GetSize() const { return static_cast<uint32_t>(m_Entries.size()); }
+
+private:
+    struct Entry
+    {
+        uint64_t hash = 0;
+        std::vector<const void*> key;
+        std::vector<std::weak_ptr<void>> resources;
+        Ref<ResourceSet> resourceSet;
+    };
+
+    bool IsValid(const Entry& entry, const std::vector<const void*>& key) const;
+    void Evict(std::list<Entry>::iterator it);
+
+private:
+    ResourceFactory* m_ResourceFactory = nullptr;
+    uint32_t m_Capacity = 0;
+
+    // Most recently used at the front.
+    std::list<Entry> m_Entries;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> m_Lookup;
+
+};
+
+} // namespace aero3d
+
+#endif // AERO3D_GRAPHICS_RESOURCESETCACHE_H_
@@ -1,6 +1,7 @@
 #ifndef AERO3D_GRAPHICS_RESOURCES_H_
 #define AERO3D_GRAPHICS_RESOURCES_H_
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <cstdint>
@@ -28,6 +29,10 @@ enum class IndexFormat
 struct BufferDesc {
     size_t size;
     BufferUsage usage;
+    // Host-visible, with one region per frame in flight. The first
+    // UpdateBuffer fills every region, later writes only reach the current
+    // frame's, so a buffer that changes must then be rewritten each frame it
+    // is used. Data that changes rarely belongs in a static buffer.
     bool dynamic = false;
 };
 
@@ -36,6 +41,10 @@ class DeviceBuffer
 public:
     virtual ~DeviceBuffer() = default;
 
+    // False when creation failed, e.g. out of memory. Such buffers must not
+    // be written or bound.
+    virtual bool IsValid() const = 0;
+
     BufferDesc& GetDescription() { return m_Description; };
 
 protected:
@@ -60,8 +69,72 @@ enum class TextureFormat
     R32FLOAT,
     D32FLOAT,
     D24S8,
-    D32S8
-};
+    D32S8,
+    // Block compressed, 4x4 texels per block.
+    BC1,
+    BC1_SRGB,
+    BC3,
+    BC3_SRGB,
+    BC5,
+    BC7,
+    BC7_SRGB
+};
+
+inline bool IsCompressedFormat(TextureFormat format)
+{
+    switch (format)
+    {
+        case TextureFormat::BC1:
+        case TextureFormat::BC1_SRGB:
+        case TextureFormat::BC3:
+        case TextureFormat::BC3_SRGB:
+        case TextureFormat::BC5:
+        case TextureFormat::BC7:
+        case TextureFormat::BC7_SRGB: return true;
+        default: return false;
+    }
+}
+
+// Bytes per texel, or per 4x4 block for compressed formats.
+inline uint32_t GetFormatBlockSize(TextureFormat format)
+{
+    switch (format)
+    {
+        case TextureFormat::BC1:
+        case TextureFormat::BC1_SRGB: return 8;
+        case TextureFormat::BC3:
+        case TextureFormat::BC3_SRGB:
+        case TextureFormat::BC5:
+        case TextureFormat::BC7:
+        case TextureFormat::BC7_SRGB: return 16;
+        case TextureFormat::D32S8: return 8;
+        default: return 4;
+    }
+}
+
+// Tightly packed size of one mip level.
+inline size_t GetTextureLevelSize(TextureFormat format, uint32_t width, uint32_t height)
+{
+    width = width > 0 ? width : 1;
+    height = height > 0 ? height : 1;
+
+    if (IsCompressedFormat(format))
+    {
+        return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * GetFormatBlockSize(format);
+    }
+    return static_cast<size_t>(width) * height * GetFormatBlockSize(format);
+}
+
+// Levels of a full chain down to 1x1.
+inline uint32_t CalculateMipLevels(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    for (uint32_t size = width > height ? width : height; size > 1; size >>= 1)
+    {
+        levels++;
+    }
+    return levels;
+}
 
 struct TextureDesc 
 {
@@ -72,14 +145,28 @@ struct TextureDesc
     uint32_t arrayLayers = 1;
     TextureFormat format;
     TextureUsage usage;
+    // Allocates the full chain and fills it from level 0 on upload.
     bool generateMipmaps = false;
 };
 
+struct TextureMemoryInfo
+{
+    uint64_t size = 0;
+    uint64_t alignment = 1;
+    // Backend memory types that can hold the texture.
+    uint32_t memoryTypeMask = 0;
+};
+
 class Texture 
 {
 public:
     virtual ~Texture() = default;
 
+    // False when creation failed, e.g. out of memory or an unsupported
+    // format. Such textures must not be uploaded to or viewed.
+    virtual bool IsValid() const = 0;
+    virtual TextureMemoryInfo GetMemoryInfo() const = 0;
+
     TextureDesc& GetDescription() { return m_Description; };
 
 protected:
@@ -87,16 +174,33 @@ protected:
 
 };
 
+// Memory that placed textures are bound into. Textures at overlapping
+// ranges alias, only the one used last holds valid contents.
+class TextureHeap
+{
+public:
+    virtual ~TextureHeap() = default;
+
+    virtual bool IsValid() const = 0;
+    // Binds a texture created without memory. Fails if it doesn't fit.
+    virtual bool Place(Ref<Texture> texture, uint64_t offset) = 0;
+
+};
+
+constexpr uint32_t ALL_MIP_LEVELS = UINT32_MAX;
+
 struct TextureViewDesc 
 {
     Ref<Texture> texture;
     TextureFormat format;
     uint32_t baseMipLevel = 0;
-    uint32_t mipLevels = 1;
+    uint32_t mipLevels = ALL_MIP_LEVELS;
     uint32_t baseArrayLayer = 0;
     uint32_t arrayLayers = 1;
 };
 
+constexpr uint32_t INVALID_BINDLESS_INDEX = UINT32_MAX;
+
 class TextureView 
 {
 public:
@@ -106,9 +210,16 @@ public:
 
     TextureViewDesc& GetDescription() { return m_Description; }
 
+    uint32_t GetBindlessIndex() const { return m_BindlessIndex; }
+
 protected:
     TextureViewDesc m_Description;
 
+private:
+    friend class BindlessTextureTable;
+    // Read by sprite recording jobs while another may register the view.
+    std::atomic<uint32_t> m_BindlessIndex = INVALID_BINDLESS_INDEX;
+
 };
 
 enum class SamplerFilter
@@ -124,13 +235,19 @@ enum class SamplerAddressMode
     ClampToBorder
 };
 
+constexpr float SAMPLER_LOD_CLAMP_NONE = 1000.0f;
+
 struct SamplerDesc
 {
     SamplerFilter filter = SamplerFilter::Linear;
+    SamplerFilter mipmapMode = SamplerFilter::Linear;
     SamplerAddressMode addressModeU = SamplerAddressMode::Repeat;
     SamplerAddressMode addressModeV = SamplerAddressMode::Repeat;
     SamplerAddressMode addressModeW = SamplerAddressMode::Repeat;
     float maxAnisotropy = 1.0f;
+    float mipLodBias = 0.0f;
+    float minLod = 0.0f;
+    float maxLod = SAMPLER_LOD_CLAMP_NONE;
 };
 
 class Sampler
@@ -145,12 +262,63 @@ protected:
 
 };
 
+class Framebuffer;
+
 struct FramebufferDesc 
 {
     std::vector<Ref<Texture>> colorTargets;
     Ref<Texture> depthTarget = nullptr;
 };
 
+enum class LoadOp
+{
+    Load,
+    Clear,
+    DontCare
+};
+
+struct RenderPassDesc
+{
+    Ref<Framebuffer> framebuffer = nullptr;
+
+    LoadOp colorLoadOp = LoadOp::Load;
+    float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    LoadOp depthLoadOp = LoadOp::Load;
+    float clearDepth = 1.0f;
+    uint32_t clearStencil = 0;
+
+    // The pass may then only be filled through ExecuteCommands.
+    bool secondaryContents = false;
+};
+
+// How a texture is used at a point in the frame. Barriers move textures
+// between states, covering layouts as well as execution and memory order.
+enum class ResourceState
+{
+    Undefined,
+    RenderTarget,
+    DepthStencilWrite,
+    DepthStencilRead,
+    ShaderRead,
+    ShaderWrite,
+    TransferSrc,
+    TransferDst,
+    Present
+};
+
+struct TextureBarrier
+{
+    Ref<Texture> texture = nullptr;
+    ResourceState before = ResourceState::Undefined;
+    ResourceState after = ResourceState::Undefined;
+    // Previous contents are not needed, which lets the driver skip them.
+    bool discard = false;
+    // Another texture used the memory before, so all earlier work has to
+    // finish. Implies discard.
+    bool aliased = false;
+};
+
 class Framebuffer 
 {
 public:
@@ -212,6 +380,8 @@ struct ResourceBinding
     ResourceKind kind;
     ShaderStages stages;
     uint32_t count = 1;
+    // Elements may stay unwritten and can be updated while the set is in use.
+    bool bindless = false;
 };
 
 struct ResourceLayoutDesc 
@@ -291,6 +461,7 @@ enum class PolygonMode
 enum class VertexFormat 
 {
     Float, Float2, Float3, Float4, Int, Int2, Int3, Int4,
+    UInt, UByte4Norm, UShort4Norm,
     Bool, Mat2, Mat3, Mat4
 };
 
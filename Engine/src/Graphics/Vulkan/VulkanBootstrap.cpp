@@ -1,5 +1,6 @@
 #include "Graphics/Vulkan/VulkanBootstrap.h"
 
+#include "Core/JobSystem.h"
 #include "Graphics/Vulkan/VulkanGraphicsDevice.h"
 #include "Graphics/Vulkan/VulkanUtils.h"
 
@@ -16,6 +17,10 @@ VulkanDescriptorAllocator::~VulkanDescriptorAllocator()
     {
         vkDestroyDescriptorPool(m_GraphicsDevice->device, pool.pool, nullptr);
     }
+    for (auto& [set, pool] : m_UpdateAfterBindPools)
+    {
+        vkDestroyDescriptorPool(m_GraphicsDevice->device, pool, nullptr);
+    }
 }
 
 VkDescriptorSet VulkanDescriptorAllocator::Allocate(VkDescriptorSetLayout layout) 
@@ -41,8 +46,42 @@ VkDescriptorSet VulkanDescriptorAllocator::Allocate(VkDescriptorSetLayout layout
     return set;
 }
 
+VkDescriptorSet VulkanDescriptorAllocator::AllocateUpdateAfterBind(VkDescriptorSetLayout layout,
+    const std::vector<VkDescriptorPoolSize>& poolSizes)
+{
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    VkDescriptorPool pool;
+    A3D_CHECK_VKRESULT(vkCreateDescriptorPool(m_GraphicsDevice->device, &poolInfo, nullptr, &pool));
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    VkDescriptorSet set;
+    A3D_CHECK_VKRESULT(vkAllocateDescriptorSets(m_GraphicsDevice->device, &allocInfo, &set));
+
+    m_UpdateAfterBindPools[set] = pool;
+    return set;
+}
+
 void VulkanDescriptorAllocator::Free(VkDescriptorSet set) 
 {
+    auto it = m_UpdateAfterBindPools.find(set);
+    if (it != m_UpdateAfterBindPools.end())
+    {
+        vkDestroyDescriptorPool(m_GraphicsDevice->device, it->second, nullptr);
+        m_UpdateAfterBindPools.erase(it);
+        return;
+    }
+
     for (auto& pool : m_Pools) 
     {
         if (pool.activeSets.find(set) != pool.activeSets.end()) 
@@ -90,4 +129,103 @@ DescriptorPool VulkanDescriptorAllocator::CreatePool()
     return result;
 }
 
-} // namespace aero3d
\ No newline at end of file
+VulkanCommandBufferAllocator::VulkanCommandBufferAllocator(VulkanGraphicsDevice* gd)
+{
+    m_GraphicsDevice = gd;
+}
+
+VulkanCommandBufferAllocator::~VulkanCommandBufferAllocator()
+{
+    for (auto& threadPools : m_ThreadPools)
+    {
+        if (!threadPools)
+            continue;
+
+        for (auto& pool : *threadPools)
+        {
+            if (pool.commandPool != VK_NULL_HANDLE)
+            {
+                vkDestroyCommandPool(m_GraphicsDevice->device, pool.commandPool, nullptr);
+            }
+        }
+    }
+}
+
+VkCommandBuffer VulkanCommandBufferAllocator::Allocate(VkCommandBufferLevel level)
+{
+    VulkanThreadCommandPool& pool = AcquirePool();
+
+    bool primary = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    std::vector<VkCommandBuffer>& buffers = primary ? pool.primaryBuffers : pool.secondaryBuffers;
+    uint32_t& used = primary ? pool.primaryUsed : pool.secondaryUsed;
+
+    if (used == buffers.size())
+    {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = pool.commandPool;
+        allocInfo.level = level;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer newCommandBuffer = VK_NULL_HANDLE;
+        A3D_CHECK_VKRESULT(vkAllocateCommandBuffers(m_GraphicsDevice->device, &allocInfo, &newCommandBuffer));
+        buffers.push_back(newCommandBuffer);
+    }
+
+    return buffers[used++];
+}
+
+VulkanThreadCommandPool& VulkanCommandBufferAllocator::AcquirePool()
+{
+    uint32_t threadIndex = JobSystem::GetThreadIndex();
+
+    VulkanThreadCommandPools* threadPools = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (threadIndex >= m_ThreadPools.size())
+        {
+            m_ThreadPools.resize(threadIndex + 1);
+        }
+        if (!m_ThreadPools[threadIndex])
+        {
+            m_ThreadPools[threadIndex] = std::make_unique<VulkanThreadCommandPools>();
+        }
+
+        threadPools = m_ThreadPools[threadIndex].get();
+    }
+
+    VulkanThreadCommandPool& pool = (*threadPools)[m_GraphicsDevice->currentFrame];
+
+    if (pool.commandPool == VK_NULL_HANDLE)
+    {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = m_GraphicsDevice->graphicsQueueIndex;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        A3D_CHECK_VKRESULT(vkCreateCommandPool(m_GraphicsDevice->device, &poolInfo, nullptr, &pool.commandPool));
+        pool.frameNumber = m_GraphicsDevice->frameNumber;
+        return pool;
+    }
+
+    if (pool.frameNumber == m_GraphicsDevice->frameNumber)
+        return pool;
+
+    // Recorded outside BeginFrame/EndFrame the slot's fence has not been
+    // waited on yet, so do it here before recycling its buffers.
+    if (!m_GraphicsDevice->frameStarted)
+    {
+        VkFence inFlightFence = m_GraphicsDevice->frameData[m_GraphicsDevice->currentFrame].inFlightFence;
+        A3D_CHECK_VKRESULT(vkWaitForFences(m_GraphicsDevice->device, 1, &inFlightFence, VK_TRUE, UINT64_MAX));
+    }
+
+    A3D_CHECK_VKRESULT(vkResetCommandPool(m_GraphicsDevice->device, pool.commandPool, 0));
+    pool.primaryUsed = 0;
+    pool.secondaryUsed = 0;
+    pool.frameNumber = m_GraphicsDevice->frameNumber;
+
+    return pool;
+}
+
+} // namespace aero3d
@@ -1,11 +1,17 @@
 #ifndef AERO3D_GRAPHICS_VULKAN_VULKANBOOTSTRAP_H_
 #define AERO3D_GRAPHICS_VULKAN_VULKANBOOTSTRAP_H_
 
+#include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include <volk.h>
 
+#include "Graphics/GraphicsDevice.h"
+
 namespace aero3d {
 
 class VulkanGraphicsDevice;
@@ -24,6 +30,10 @@ public:
     ~VulkanDescriptorAllocator();
 
     VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+    // Update-after-bind sets need a pool created with the matching flag,
+    // each one gets its own pool sized for its bindings.
+    VkDescriptorSet AllocateUpdateAfterBind(VkDescriptorSetLayout layout,
+        const std::vector<VkDescriptorPoolSize>& poolSizes);
     void Free(VkDescriptorSet set);
     void ResetPools();
 
@@ -36,6 +46,43 @@ private:
     std::vector<DescriptorPool> m_Pools;
     DescriptorPool* m_CurrentPool = nullptr;
 
+    std::unordered_map<VkDescriptorSet, VkDescriptorPool> m_UpdateAfterBindPools;
+
+};
+
+// Command buffers one thread recorded during one frame slot. They are
+// recycled once the device has waited for that slot's fence.
+struct VulkanThreadCommandPool
+{
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> primaryBuffers;
+    std::vector<VkCommandBuffer> secondaryBuffers;
+    uint32_t primaryUsed = 0;
+    uint32_t secondaryUsed = 0;
+    uint64_t frameNumber = UINT64_MAX;
+};
+
+using VulkanThreadCommandPools = std::array<VulkanThreadCommandPool, MAX_FRAMES_IN_FLIGHT>;
+
+// Command pools are externally synchronized, so every job system thread
+// records from its own set of per-frame pools.
+class VulkanCommandBufferAllocator
+{
+public:
+    VulkanCommandBufferAllocator(VulkanGraphicsDevice* gd);
+    ~VulkanCommandBufferAllocator();
+
+    VkCommandBuffer Allocate(VkCommandBufferLevel level);
+
+private:
+    VulkanThreadCommandPool& AcquirePool();
+
+private:
+    VulkanGraphicsDevice* m_GraphicsDevice = nullptr;
+
+    std::mutex m_Mutex;
+    std::vector<std::unique_ptr<VulkanThreadCommandPools>> m_ThreadPools;
+
 };
 
 } // namespace aero3d
@@ -2,79 +2,126 @@
 
 #include "Graphics/Vulkan/VulkanGraphicsDevice.h"
 #include "Graphics/Vulkan/VulkanUtils.h"
+#include "Utils/Assert.h"
 
 namespace aero3d {
 
-VulkanCommandList::VulkanCommandList(VulkanGraphicsDevice* gd)
+VulkanCommandList::VulkanCommandList(VulkanGraphicsDevice* gd, CommandListLevel level)
 {
     m_GraphicsDevice = gd;
-
-    CreateCommandPool();
-    CreateCommandList();
+    this->level = level;
 }
 
 VulkanCommandList::~VulkanCommandList()
 {
     vkDeviceWaitIdle(m_GraphicsDevice->device);
-    if (m_CommandPool != VK_NULL_HANDLE)
-    {
-        vkDestroyCommandPool(m_GraphicsDevice->device, m_CommandPool, nullptr);
-        m_CommandPool = VK_NULL_HANDLE;
-    }
 }
 
 void VulkanCommandList::Begin()
 {
+    if (level != CommandListLevel::Primary)
+    {
+        LogErr(ERROR_INFO, "Secondary command lists have to be started with BeginSecondary.");
+        return;
+    }
+
+    commandBuffer = m_GraphicsDevice->commandBufferAllocator->Allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = 0;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-    A3D_CHECK_VKRESULT(vkResetCommandBuffer(commandBuffer, 0));
-    A3D_CHECK_VKRESULT(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+    BeginCommandBuffer(beginInfo);
+}
 
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(m_GraphicsDevice->swapchain->extent.width);
-    viewport.height = static_cast<float>(m_GraphicsDevice->swapchain->extent.height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
+void VulkanCommandList::BeginSecondary(Ref<Framebuffer> framebuffer)
+{
+    if (level != CommandListLevel::Secondary)
+    {
+        LogErr(ERROR_INFO, "Primary command lists have to be started with Begin.");
+        return;
+    }
 
-    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    m_CurrentFramebuffer = std::static_pointer_cast<VulkanFramebuffer>(framebuffer);
 
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = { m_GraphicsDevice->swapchain->extent };
+    commandBuffer = m_GraphicsDevice->commandBufferAllocator->Allocate(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
 
-    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    std::vector<VkFormat> colorFormats;
+    for (auto& frame : m_CurrentFramebuffer->frames)
+    {
+        colorFormats.push_back(frame->vkFormat);
+    }
+
+    VkCommandBufferInheritanceRenderingInfo renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+    renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorFormats.size());
+    renderingInfo.pColorAttachmentFormats = colorFormats.data();
+    renderingInfo.depthAttachmentFormat = m_CurrentFramebuffer->depthStencil
+        ? m_CurrentFramebuffer->depthStencil->vkFormat
+        : VK_FORMAT_UNDEFINED;
+    renderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.pNext = &renderingInfo;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    BeginCommandBuffer(beginInfo);
 }
 
 void VulkanCommandList::End()
 {
-    if (m_CurrentFramebuffer)
+    // Secondary lists only continue the primary's rendering.
+    if (m_CurrentFramebuffer && level == CommandListLevel::Primary)
     {
         EndRendering();
-
-        m_CurrentFramebuffer = nullptr;
     }
 
+    m_CurrentFramebuffer = nullptr;
+
     A3D_CHECK_VKRESULT(vkEndCommandBuffer(commandBuffer));
 }
 
-void VulkanCommandList::SetFramebuffer(Ref<Framebuffer> framebuffer)
+void VulkanCommandList::BeginRenderPass(const RenderPassDesc& renderPass)
 {
-    Ref<VulkanFramebuffer> vfb = std::static_pointer_cast<VulkanFramebuffer>(framebuffer);
+    if (level != CommandListLevel::Primary)
+    {
+        LogErr(ERROR_INFO, "Secondary command lists inherit the render pass of their primary.");
+        return;
+    }
 
-    if (m_CurrentFramebuffer != vfb && m_CurrentFramebuffer != nullptr)
+    if (m_CurrentFramebuffer != nullptr)
     {
         EndRendering();
     }
 
-    m_CurrentFramebuffer = vfb;
+    m_CurrentFramebuffer = std::static_pointer_cast<VulkanFramebuffer>(renderPass.framebuffer);
+    m_CurrentRenderPass = renderPass;
 
     BeginRendering();
 }
 
+void VulkanCommandList::EndRenderPass()
+{
+    if (m_CurrentFramebuffer != nullptr && level == CommandListLevel::Primary)
+    {
+        EndRendering();
+    }
+}
+
+void VulkanCommandList::SetFramebuffer(Ref<Framebuffer> framebuffer, bool secondaryContents)
+{
+    RenderPassDesc renderPass;
+    renderPass.framebuffer = framebuffer;
+    renderPass.secondaryContents = secondaryContents;
+
+    BeginRenderPass(renderPass);
+}
+
 void VulkanCommandList::SetPipeline(Ref<Pipeline> pipeline)
 {
     Ref<VulkanPipeline> vulkanPipeline = std::static_pointer_cast<VulkanPipeline>(pipeline);
@@ -82,11 +129,14 @@ void VulkanCommandList::SetPipeline(Ref<Pipeline> pipeline)
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkanPipeline->pipeline);
 }
 
-void VulkanCommandList::SetVertexBuffer(Ref<DeviceBuffer> buffer, uint32_t offset)
+void VulkanCommandList::SetVertexBuffer(uint32_t index, Ref<DeviceBuffer> buffer, uint32_t offset)
 {
     Ref<VulkanDeviceBuffer> vulkanDeviceVulkan = std::static_pointer_cast<VulkanDeviceBuffer>(buffer);
-    VkDeviceSize offsets[] = { offset };
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vulkanDeviceVulkan->buffer, offsets);
+#ifdef A3D_DEBUG
+    Assert(ERROR_INFO, vulkanDeviceVulkan->IsFrameDataCurrent(), "Dynamic buffer was not rewritten this frame!");
+#endif
+    VkDeviceSize offsets[] = { offset + vulkanDeviceVulkan->GetFrameOffset() };
+    vkCmdBindVertexBuffers(commandBuffer, index, 1, &vulkanDeviceVulkan->buffer, offsets);
 }
 
 static VkIndexType IndexFormatToVkIndexType(IndexFormat format)
@@ -102,14 +152,21 @@ static VkIndexType IndexFormatToVkIndexType(IndexFormat format)
 void VulkanCommandList::SetIndexBuffer(Ref<DeviceBuffer> buffer, IndexFormat format, uint32_t offset)
 {
     Ref<VulkanDeviceBuffer> vulkanDeviceVulkan = std::static_pointer_cast<VulkanDeviceBuffer>(buffer);
+#ifdef A3D_DEBUG
+    Assert(ERROR_INFO, vulkanDeviceVulkan->IsFrameDataCurrent(), "Dynamic buffer was not rewritten this frame!");
+#endif
 
-    vkCmdBindIndexBuffer(commandBuffer, vulkanDeviceVulkan->buffer, offset, IndexFormatToVkIndexType(format));
+    vkCmdBindIndexBuffer(commandBuffer, vulkanDeviceVulkan->buffer, offset + vulkanDeviceVulkan->GetFrameOffset(),
+        IndexFormatToVkIndexType(format));
 }
 
 void VulkanCommandList::SetResourceSet(uint32_t slot, Ref<ResourceSet> resourceSet)
 {
     Ref<VulkanResourceSet> vulkanResourceSet = std::static_pointer_cast<VulkanResourceSet>(resourceSet);
 
+    // Keep the descriptor set alive until the frame that uses it has finished.
+    m_CurrentFrameResources->boundResourceSets.push_back(resourceSet);
+
     vkCmdBindDescriptorSets(
         commandBuffer,
         VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -170,25 +227,179 @@ void VulkanCommandList::ClearDepthStencil()
     vkCmdClearAttachments(commandBuffer, 1, &clearAttachment, 1, &clearRect);
 }
 
-void VulkanCommandList::CreateCommandPool()
+void VulkanCommandList::ExecuteCommands(const std::vector<Ref<CommandList>>& commandLists)
 {
-    VkCommandPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.queueFamilyIndex = m_GraphicsDevice->graphicsQueueIndex;
-    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    std::vector<VkCommandBuffer> commandBuffers;
+    commandBuffers.reserve(commandLists.size());
 
-    A3D_CHECK_VKRESULT(vkCreateCommandPool(m_GraphicsDevice->device, &poolInfo, nullptr, &m_CommandPool));
+    for (auto& commandList : commandLists)
+    {
+        commandBuffers.push_back(std::static_pointer_cast<VulkanCommandList>(commandList)->commandBuffer);
+    }
+
+    if (!commandBuffers.empty())
+    {
+        vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+    }
 }
 
-void VulkanCommandList::CreateCommandList()
+struct VulkanResourceStateInfo
 {
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = m_CommandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = 1;
+    VkPipelineStageFlags2 stage;
+    VkAccessFlags2 access;
+    VkImageLayout layout;
+};
 
-    A3D_CHECK_VKRESULT(vkAllocateCommandBuffers(m_GraphicsDevice->device, &allocInfo, &commandBuffer));
+static VulkanResourceStateInfo GetResourceStateInfo(ResourceState state, bool source)
+{
+    switch (state)
+    {
+        case ResourceState::RenderTarget:
+            return { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+        case ResourceState::DepthStencilWrite:
+            return { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+        case ResourceState::DepthStencilRead:
+            return { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT |
+                VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+        case ResourceState::ShaderRead:
+            return { VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        case ResourceState::ShaderWrite:
+            return { VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_IMAGE_LAYOUT_GENERAL };
+        case ResourceState::TransferSrc:
+            return { VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL };
+        case ResourceState::TransferDst:
+            return { VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL };
+        case ResourceState::Present:
+            // Leaving Present has to chain with the image-available semaphore,
+            // which the frame waits on at color attachment output.
+            return { source ? VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT : VK_PIPELINE_STAGE_2_NONE,
+                VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR };
+        case ResourceState::Undefined:
+        default:
+            return { VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_UNDEFINED };
+    }
+}
+
+static VkImageAspectFlags GetImageAspect(TextureFormat format)
+{
+    switch (format)
+    {
+        case TextureFormat::D24S8:
+        case TextureFormat::D32S8: return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        case TextureFormat::D32FLOAT: return VK_IMAGE_ASPECT_DEPTH_BIT;
+        default: return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+void VulkanCommandList::Barrier(const std::vector<TextureBarrier>& barriers)
+{
+    std::vector<VkImageMemoryBarrier2> imageBarriers;
+    imageBarriers.reserve(barriers.size());
+
+    for (const auto& barrier : barriers)
+    {
+        auto* texture = static_cast<VulkanTexture*>(barrier.texture.get());
+
+        VulkanResourceStateInfo before = GetResourceStateInfo(barrier.before, true);
+        VulkanResourceStateInfo after = GetResourceStateInfo(barrier.after, false);
+
+        // Whatever used the memory last is unknown here, so wait for all of it.
+        if (barrier.aliased)
+        {
+            before.stage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+            before.access = VK_ACCESS_2_MEMORY_WRITE_BIT;
+        }
+
+        VkImageMemoryBarrier2 imageBarrier{};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+        imageBarrier.srcStageMask = before.stage;
+        imageBarrier.srcAccessMask = before.access;
+        imageBarrier.dstStageMask = after.stage;
+        imageBarrier.dstAccessMask = after.access;
+        imageBarrier.oldLayout = barrier.discard || barrier.aliased ? VK_IMAGE_LAYOUT_UNDEFINED : before.layout;
+        imageBarrier.newLayout = after.layout;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = texture->image;
+        imageBarrier.subresourceRange.aspectMask = GetImageAspect(texture->format);
+        imageBarrier.subresourceRange.baseMipLevel = 0;
+        imageBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        imageBarrier.subresourceRange.baseArrayLayer = 0;
+        imageBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+        imageBarriers.push_back(imageBarrier);
+    }
+
+    if (imageBarriers.empty())
+        return;
+
+    VkDependencyInfo dependencyInfo{};
+    dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+    dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+
+    vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+}
+
+void VulkanCommandList::BeginCommandBuffer(VkCommandBufferBeginInfo& beginInfo)
+{
+    // The allocator has waited for the frame slot, so the resources the
+    // slot's last commands referenced can be let go.
+    m_CurrentFrameResources = &AcquireFrameResources();
+
+    A3D_CHECK_VKRESULT(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(m_GraphicsDevice->swapchain->extent.width);
+    viewport.height = static_cast<float>(m_GraphicsDevice->swapchain->extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+    VkRect2D scissor{};
+    scissor.offset = {0, 0};
+    scissor.extent = { m_GraphicsDevice->swapchain->extent };
+
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
+VulkanFrameResources& VulkanCommandList::AcquireFrameResources()
+{
+    VulkanFrameResources& frame = m_FrameResources[m_GraphicsDevice->currentFrame];
+
+    if (frame.frameNumber != m_GraphicsDevice->frameNumber)
+    {
+        frame.frameNumber = m_GraphicsDevice->frameNumber;
+        frame.boundResourceSets.clear();
+    }
+
+    return frame;
+}
+
+static VkAttachmentLoadOp ToVkLoadOp(LoadOp loadOp)
+{
+    switch (loadOp)
+    {
+        case LoadOp::Load: return VK_ATTACHMENT_LOAD_OP_LOAD;
+        case LoadOp::Clear: return VK_ATTACHMENT_LOAD_OP_CLEAR;
+        case LoadOp::DontCare: return VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        default: return VK_ATTACHMENT_LOAD_OP_LOAD;
+    }
 }
 
 void VulkanCommandList::BeginRendering()
@@ -198,35 +409,13 @@ void VulkanCommandList::BeginRendering()
 
     for (int i = 0; i < m_CurrentFramebuffer->frames.size(); i++)
     {
-        VkImageMemoryBarrier barrier{};
-        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-        barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.image = m_CurrentFramebuffer->frames[i]->image;
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.baseMipLevel = 0;
-        barrier.subresourceRange.levelCount = 1;
-        barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount = 1;
-        barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-        barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-        vkCmdPipelineBarrier(
-            commandBuffer,
-            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-            0,
-            0, nullptr,
-            0, nullptr,
-            1, &barrier);
-
         VkRenderingAttachmentInfo colorAttachment = {};
         colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
         colorAttachment.imageView = m_CurrentFramebuffer->imageViews[i];
         colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        colorAttachment.loadOp = ToVkLoadOp(m_CurrentRenderPass.colorLoadOp);
+        colorAttachment.clearValue.color = { { m_CurrentRenderPass.clearColor[0], m_CurrentRenderPass.clearColor[1],
+            m_CurrentRenderPass.clearColor[2], m_CurrentRenderPass.clearColor[3] } };
         colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 
         colorAttachments[i] = colorAttachment;
@@ -239,37 +428,19 @@ void VulkanCommandList::BeginRendering()
     renderingInfo.colorAttachmentCount = colorAttachments.size();
     renderingInfo.pColorAttachments = colorAttachments.data();
 
+    if (m_CurrentRenderPass.secondaryContents)
+    {
+        renderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+    }
+
     VkRenderingAttachmentInfo depthAttachment = {};
     if (m_CurrentFramebuffer->depthStencil)
     {
-        VkImageMemoryBarrier depthBarrier{};
-        depthBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-        depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-        depthBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        depthBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        depthBarrier.image = m_CurrentFramebuffer->depthStencil->image;
-        depthBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
-        depthBarrier.subresourceRange.baseMipLevel = 0;
-        depthBarrier.subresourceRange.levelCount = 1;
-        depthBarrier.subresourceRange.baseArrayLayer = 0;
-        depthBarrier.subresourceRange.layerCount = 1;
-        depthBarrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-        depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-        vkCmdPipelineBarrier(
-            commandBuffer,
-            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-            0,
-            0, nullptr,
-            0, nullptr,
-            1, &depthBarrier);
-
         depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
         depthAttachment.imageView = m_CurrentFramebuffer->depthStencilImageView;
         depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        depthAttachment.loadOp = ToVkLoadOp(m_CurrentRenderPass.depthLoadOp);
+        depthAttachment.clearValue.depthStencil = { m_CurrentRenderPass.clearDepth, m_CurrentRenderPass.clearStencil };
         depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 
         renderingInfo.pDepthAttachment = &depthAttachment;
@@ -282,61 +453,6 @@ void VulkanCommandList::EndRendering()
 {
     vkCmdEndRenderingKHR(commandBuffer);
 
-    for (int i = 0; i < m_CurrentFramebuffer->frames.size(); i++)
-    {
-        VkImageMemoryBarrier barrier{};
-        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.image = m_CurrentFramebuffer->frames[i]->image;
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.baseMipLevel = 0;
-        barrier.subresourceRange.levelCount = 1;
-        barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount = 1;
-        barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-        barrier.dstAccessMask = 0;
-
-        vkCmdPipelineBarrier(
-            commandBuffer,
-            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-            0,
-            0, nullptr,
-            0, nullptr,
-            1, &barrier
-        );
-    }
-
-    if (m_CurrentFramebuffer->depthStencil)
-    {
-        VkImageMemoryBarrier depthBarrierEnd{};
-        depthBarrierEnd.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        depthBarrierEnd.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-        depthBarrierEnd.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-        depthBarrierEnd.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        depthBarrierEnd.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        depthBarrierEnd.image = m_CurrentFramebuffer->depthStencil->image;
-        depthBarrierEnd.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
-        depthBarrierEnd.subresourceRange.baseMipLevel = 0;
-        depthBarrierEnd.subresourceRange.levelCount = 1;
-        depthBarrierEnd.subresourceRange.baseArrayLayer = 0;
-        depthBarrierEnd.subresourceRange.layerCount = 1;
-        depthBarrierEnd.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-        depthBarrierEnd.dstAccessMask = 0;
-
-        vkCmdPipelineBarrier(
-            commandBuffer,
-            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-            0,
-            0, nullptr,
-            0, nullptr,
-            1, &depthBarrierEnd);
-    }
-
     m_CurrentFramebuffer = nullptr;
 }
 
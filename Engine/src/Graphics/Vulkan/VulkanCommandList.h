@@ -1,29 +1,45 @@
 #ifndef AERO3D_GRAPHICS_VULKAN_VULKANCOMMANDLIST_H_
 #define AERO3D_GRAPHICS_VULKAN_VULKANCOMMANDLIST_H_
 
+#include <array>
 #include <cstdint>
+#include <vector>
 
 #include <volk.h>
 
 #include "Graphics/CommandList.h"
+#include "Graphics/GraphicsDevice.h"
 #include "Graphics/Vulkan/VulkanResources.h"
 
 namespace aero3d {
 
 class VulkanGraphicsDevice;
 
+// Resources referenced by the commands recorded during one frame slot,
+// released once the device has waited for that slot's fence.
+struct VulkanFrameResources
+{
+    uint64_t frameNumber = UINT64_MAX;
+
+    std::vector<Ref<ResourceSet>> boundResourceSets;
+};
+
 class VulkanCommandList : public CommandList
 {
 public:
-    VulkanCommandList(VulkanGraphicsDevice* gd);
+    VulkanCommandList(VulkanGraphicsDevice* gd, CommandListLevel level);
     ~VulkanCommandList();
 
     virtual void Begin() override;
+    virtual void BeginSecondary(Ref<Framebuffer> framebuffer) override;
     virtual void End() override;
 
-    virtual void SetFramebuffer(Ref<Framebuffer> framebuffer) override;
+    virtual void BeginRenderPass(const RenderPassDesc& renderPass) override;
+    virtual void EndRenderPass() override;
+
+    virtual void SetFramebuffer(Ref<Framebuffer> framebuffer, bool secondaryContents = false) override;
     virtual void SetPipeline(Ref<Pipeline> pipeline) override;
-    virtual void SetVertexBuffer(Ref<DeviceBuffer> buffer, uint32_t offset = 0) override;
+    virtual void SetVertexBuffer(uint32_t index, Ref<DeviceBuffer> buffer, uint32_t offset = 0) override;
     virtual void SetIndexBuffer(Ref<DeviceBuffer> buffer, IndexFormat format, uint32_t offset = 0) override;
     virtual void SetResourceSet(uint32_t slot, Ref<ResourceSet> resourceSet) override;
 
@@ -35,12 +51,17 @@ public:
     virtual void ClearRenderTargets(float r, float g, float b, float a) override;
     virtual void ClearDepthStencil() override;
 
+    virtual void ExecuteCommands(const std::vector<Ref<CommandList>>& commandLists) override;
+
+    virtual void Barrier(const std::vector<TextureBarrier>& barriers) override;
+
 public:
     VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    CommandListLevel level = CommandListLevel::Primary;
 
 private:
-    void CreateCommandPool();
-    void CreateCommandList();
+    void BeginCommandBuffer(VkCommandBufferBeginInfo& beginInfo);
+    VulkanFrameResources& AcquireFrameResources();
 
     void BeginRendering();
     void EndRendering();
@@ -48,9 +69,11 @@ private:
 private:
     VulkanGraphicsDevice* m_GraphicsDevice = nullptr;
 
-    VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+    std::array<VulkanFrameResources, MAX_FRAMES_IN_FLIGHT> m_FrameResources;
+    VulkanFrameResources* m_CurrentFrameResources = nullptr;
 
     Ref<VulkanFramebuffer> m_CurrentFramebuffer = nullptr;
+    RenderPassDesc m_CurrentRenderPass;
     Ref<VulkanPipeline> m_CurrentPipeline = nullptr;
 
 };
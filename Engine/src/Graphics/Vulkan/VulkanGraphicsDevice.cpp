@@ -1,15 +1,37 @@
 #include "Graphics/Vulkan/VulkanGraphicsDevice.h"
 
+#include <algorithm>
 #include <set>
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_vulkan.h>
 
+#include "Graphics/BindlessTextureTable.h"
 #include "Graphics/Vulkan/VulkanUtils.h"
 #include "Graphics/Vulkan/VulkanCommandList.h"
+#include "IO/VFS.h"
 
 namespace aero3d {
 
+constexpr const char* PIPELINE_CACHE_PATH = "cache/pipeline.bin";
+constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x43503341; // "A3PC"
+constexpr uint32_t PIPELINE_CACHE_VERSION = 1;
+
+constexpr uint32_t MAX_BINDLESS_TEXTURES = 4096;
+
+// Written in front of the driver's blob. Drivers are supposed to reject
+// foreign data themselves, but not all of them do so gracefully.
+struct PipelineCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t dataSize;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+};
+
 VulkanGraphicsDevice::VulkanGraphicsDevice(RenderSurfaceCreateInfo& renderSurfaceInfo)
 {
     LogMsg("Creating Vulkan Graphics Device...");
@@ -24,10 +46,19 @@ VulkanGraphicsDevice::VulkanGraphicsDevice(RenderSurfaceCreateInfo& renderSurfac
     CreateQueues();
     CreateCommandBuffers();
     CreateLocks();
+    CreatePipelineCache();
 
+    memoryAllocator = new VulkanMemoryAllocator(this);
     swapchain = new VulkanSwapchain(this);
     descriptorAllocator = new VulkanDescriptorAllocator(this);
+    commandBufferAllocator = new VulkanCommandBufferAllocator(this);
     resourceFactory = new VulkanResourceFactory(this);
+    uploadQueue = new VulkanUploadQueue(this);
+
+    if (bindlessSupported)
+    {
+        bindlessTable = new BindlessTextureTable(this, resourceFactory, bindlessTextureCapacity);
+    }
 }
 
 VulkanGraphicsDevice::~VulkanGraphicsDevice() 
@@ -36,11 +67,26 @@ VulkanGraphicsDevice::~VulkanGraphicsDevice()
 
     vkDeviceWaitIdle(device);
 
+    if (uploadQueue != nullptr)
+    {
+        delete uploadQueue;
+        uploadQueue = nullptr;
+    }
+    if (bindlessTable != nullptr)
+    {
+        delete bindlessTable;
+        bindlessTable = nullptr;
+    }
     if (resourceFactory != nullptr)
     {
         delete resourceFactory;
         resourceFactory = nullptr;
     }
+    if (commandBufferAllocator != nullptr)
+    {
+        delete commandBufferAllocator;
+        commandBufferAllocator = nullptr;
+    }
     if (descriptorAllocator != nullptr)
     {
         delete descriptorAllocator;
@@ -51,6 +97,18 @@ VulkanGraphicsDevice::~VulkanGraphicsDevice()
         delete swapchain;
         swapchain = nullptr;
     }
+    if (memoryAllocator != nullptr)
+    {
+        memoryAllocator->LogStats();
+        delete memoryAllocator;
+        memoryAllocator = nullptr;
+    }
+    if (pipelineCache != VK_NULL_HANDLE)
+    {
+        SavePipelineCache();
+        vkDestroyPipelineCache(device, pipelineCache, nullptr);
+        pipelineCache = VK_NULL_HANDLE;
+    }
     if (commandPool != VK_NULL_HANDLE)
     {
         vkDestroyCommandPool(device, commandPool, nullptr);
@@ -61,10 +119,17 @@ VulkanGraphicsDevice::~VulkanGraphicsDevice()
         vkDestroyFence(device, transferFinishedFence, nullptr);
         transferFinishedFence = VK_NULL_HANDLE;
     }
-    if (renderFinishedFence != VK_NULL_HANDLE)
+    if (submitFinishedFence != VK_NULL_HANDLE)
     {
-        vkDestroyFence(device, renderFinishedFence, nullptr);
-        renderFinishedFence = VK_NULL_HANDLE;
+        vkDestroyFence(device, submitFinishedFence, nullptr);
+        submitFinishedFence = VK_NULL_HANDLE;
+    }
+    for (auto& frame : frameData)
+    {
+        vkDestroySemaphore(device, frame.imageAvailableSemaphore, nullptr);
+        vkDestroySemaphore(device, frame.renderFinishedSemaphore, nullptr);
+        vkDestroyFence(device, frame.inFlightFence, nullptr);
+        frame = {};
     }
     if (device != VK_NULL_HANDLE)
     {
@@ -83,9 +148,9 @@ VulkanGraphicsDevice::~VulkanGraphicsDevice()
     }
 }
 
-Ref<CommandList> VulkanGraphicsDevice::CreateCommandList() 
+Ref<CommandList> VulkanGraphicsDevice::CreateCommandList(CommandListLevel level) 
 {
-    return std::make_shared<VulkanCommandList>(this);
+    return std::make_shared<VulkanCommandList>(this, level);
 }
 
 ResourceFactory* VulkanGraphicsDevice::GetResourceFactory() 
@@ -98,49 +163,166 @@ Swapchain* VulkanGraphicsDevice::GetSwapchain()
     return swapchain;
 }
 
-void VulkanGraphicsDevice::SubmitCommands(Ref<CommandList> commandList) 
+bool VulkanGraphicsDevice::BeginFrame()
 {
-    Ref<VulkanCommandList> vcl = std::static_pointer_cast<VulkanCommandList>(commandList);
+    VulkanFrameData& frame = frameData[currentFrame];
 
-    VkPipelineStageFlags waitFlags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    A3D_CHECK_VKRESULT(vkWaitForFences(device, 1, &frame.inFlightFence, VK_TRUE, UINT64_MAX));
 
-	VkSubmitInfo submitInfo{};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.pNext = nullptr;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &vcl->commandBuffer;
+    if (!swapchain->AcquireNextImage(frame.imageAvailableSemaphore))
+        return false;
 
-	A3D_CHECK_VKRESULT(vkQueueSubmit(graphicsQueue, 1, &submitInfo, renderFinishedFence));
+    A3D_CHECK_VKRESULT(vkResetFences(device, 1, &frame.inFlightFence));
 
-    A3D_CHECK_VKRESULT(vkWaitForFences(device, 1, &renderFinishedFence, VK_TRUE, UINT64_MAX));
-    A3D_CHECK_VKRESULT(vkResetFences(device, 1, &renderFinishedFence));
+    frameStarted = true;
+    frameCommandBuffers.clear();
+
+    if (bindlessTable != nullptr)
+    {
+        bindlessTable->Update();
+    }
+
+    return true;
 }
 
-void VulkanGraphicsDevice::Present() 
+void VulkanGraphicsDevice::EndFrame()
 {
+    VulkanFrameData& frame = frameData[currentFrame];
+
+    uploadQueue->Flush();
+
+    // Textures whose uploads finished may be sampled this frame, ownership
+    // moves to the graphics queue ahead of everything else.
+    if (uploadQueue->HasPendingAcquires())
+    {
+        VkCommandBuffer acquireBuffer = commandBufferAllocator->Allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+        BeginCommandBuffer(acquireBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        uploadQueue->RecordAcquires(acquireBuffer);
+        A3D_CHECK_VKRESULT(vkEndCommandBuffer(acquireBuffer));
+
+        frameCommandBuffers.insert(frameCommandBuffers.begin(), acquireBuffer);
+    }
+
+    // Everything recorded during the frame goes out in one submission.
+    std::array<VkSemaphore, 2> waitSemaphores = { frame.imageAvailableSemaphore, uploadQueue->timelineSemaphore };
+    std::array<VkPipelineStageFlags, 2> waitStages =
+        { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+    std::array<uint64_t, 2> waitValues = { 0, uploadQueue->GetCompletedValue() };
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+    timelineInfo.pWaitSemaphoreValues = waitValues.data();
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+    submitInfo.commandBufferCount = static_cast<uint32_t>(frameCommandBuffers.size());
+    submitInfo.pCommandBuffers = frameCommandBuffers.data();
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &frame.renderFinishedSemaphore;
+
+    A3D_CHECK_VKRESULT(vkQueueSubmit(graphicsQueue, 1, &submitInfo, frame.inFlightFence));
+    frameCommandBuffers.clear();
+
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = &frame.renderFinishedSemaphore;
     presentInfo.swapchainCount = 1;
     presentInfo.pSwapchains = &swapchain->swapchain;
     presentInfo.pImageIndices = &swapchain->currentImageIndex;
 
     VkResult result = vkQueuePresentKHR(presentQueue, &presentInfo);
 
+    frameStarted = false;
+    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    frameNumber++;
+
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
     {
         swapchain->Resize();
-        return;
     }
     else
     {
         A3D_CHECK_VKRESULT(result);
     }
+}
 
-    swapchain->AcquireNextImage();
+void VulkanGraphicsDevice::WaitIdle()
+{
+    uploadQueue->Flush();
+    A3D_CHECK_VKRESULT(vkDeviceWaitIdle(device));
+}
+
+uint64_t VulkanGraphicsDevice::GetFrameNumber()
+{
+    return frameNumber;
+}
+
+void VulkanGraphicsDevice::SubmitCommands(Ref<CommandList> commandList) 
+{
+    Ref<VulkanCommandList> vcl = std::static_pointer_cast<VulkanCommandList>(commandList);
+
+    if (vcl->level != CommandListLevel::Primary)
+    {
+        LogErr(ERROR_INFO, "Secondary command lists can only be run through ExecuteCommands.");
+        return;
+    }
+
+    // Inside a frame, submission is deferred to EndFrame so the frame costs
+    // a single vkQueueSubmit and no CPU waits.
+    if (frameStarted)
+    {
+        frameCommandBuffers.push_back(vcl->commandBuffer);
+        return;
+    }
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &vcl->commandBuffer;
+
+    A3D_CHECK_VKRESULT(vkQueueSubmit(graphicsQueue, 1, &submitInfo, submitFinishedFence));
+
+    A3D_CHECK_VKRESULT(vkWaitForFences(device, 1, &submitFinishedFence, VK_TRUE, UINT64_MAX));
+    A3D_CHECK_VKRESULT(vkResetFences(device, 1, &submitFinishedFence));
 }
 
 void VulkanGraphicsDevice::UpdateBuffer(Ref<DeviceBuffer> buffer, void* data, size_t size, size_t offset)
 {
+    Ref<VulkanDeviceBuffer> vulkanBuffer = std::static_pointer_cast<VulkanDeviceBuffer>(buffer);
+
+    if (!vulkanBuffer->IsValid())
+    {
+        LogErr(ERROR_INFO, "Can't update a buffer that failed to be created.");
+        return;
+    }
+
+    if (vulkanBuffer->GetDescription().dynamic)
+    {
+        // No frame can read the buffer before its first write, so that one
+        // seeds every region and one-shot uploads stay valid.
+        if (!vulkanBuffer->written)
+        {
+            for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++)
+            {
+                memcpy(static_cast<uint8_t*>(vulkanBuffer->mappedData) + vulkanBuffer->regionSize * frame + offset,
+                    data, size);
+            }
+            vulkanBuffer->written = true;
+            return;
+        }
+
+        memcpy(static_cast<uint8_t*>(vulkanBuffer->GetFrameData()) + offset, data, size);
+        vulkanBuffer->regionsDiverged = true;
+        vulkanBuffer->lastWriteFrame = frameNumber;
+        return;
+    }
+
     BufferDesc stagingBufferDescription;
     stagingBufferDescription.size = size;
     stagingBufferDescription.usage = USAGE_STAGING;
@@ -148,10 +330,10 @@ void VulkanGraphicsDevice::UpdateBuffer(Ref<DeviceBuffer> buffer, void* data, si
     Ref<VulkanDeviceBuffer> stagingBuffer = 
         std::static_pointer_cast<VulkanDeviceBuffer>(resourceFactory->CreateBuffer(stagingBufferDescription));
 
-    void* mappedData;
-    A3D_CHECK_VKRESULT(vkMapMemory(device, stagingBuffer->memory, 0, size, 0, &mappedData));
-    memcpy(mappedData, data, (size_t)size);
-    vkUnmapMemory(device, stagingBuffer->memory);
+    if (!stagingBuffer->IsValid())
+        return;
+
+    memcpy(stagingBuffer->mappedData, data, size);
 
     VkCommandBufferBeginInfo beginInfo {};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -161,10 +343,9 @@ void VulkanGraphicsDevice::UpdateBuffer(Ref<DeviceBuffer> buffer, void* data, si
 
     VkBufferCopy copyRegion;
     copyRegion.srcOffset = 0;
-    copyRegion.dstOffset = 0;
+    copyRegion.dstOffset = offset;
     copyRegion.size = size;
-    vkCmdCopyBuffer(transferCommandBuffer, stagingBuffer->buffer,
-        std::static_pointer_cast<VulkanDeviceBuffer>(buffer)->buffer, 1, &copyRegion);
+    vkCmdCopyBuffer(transferCommandBuffer, stagingBuffer->buffer, vulkanBuffer->buffer, 1, &copyRegion);
 
     A3D_CHECK_VKRESULT(vkEndCommandBuffer(transferCommandBuffer));
 
@@ -179,10 +360,34 @@ void VulkanGraphicsDevice::UpdateBuffer(Ref<DeviceBuffer> buffer, void* data, si
     A3D_CHECK_VKRESULT(vkResetFences(device, 1, &transferFinishedFence));
 }
 
+void* VulkanGraphicsDevice::MapBuffer(Ref<DeviceBuffer> buffer)
+{
+    Ref<VulkanDeviceBuffer> vulkanBuffer = std::static_pointer_cast<VulkanDeviceBuffer>(buffer);
+
+    if (!vulkanBuffer->GetDescription().dynamic || !vulkanBuffer->IsValid())
+    {
+        LogErr(ERROR_INFO, "Only valid dynamic buffers can be mapped.");
+        return nullptr;
+    }
+
+    // Mapping is taken as a write of the current region.
+    vulkanBuffer->written = true;
+    vulkanBuffer->regionsDiverged = true;
+    vulkanBuffer->lastWriteFrame = frameNumber;
+
+    return vulkanBuffer->GetFrameData();
+}
+
 void VulkanGraphicsDevice::UpdateTexture(Ref<Texture> texture, void* data, size_t size)
 {
     Ref<VulkanTexture> vulkanTexture = std::static_pointer_cast<VulkanTexture>(texture);
 
+    if (!vulkanTexture->IsValid())
+    {
+        LogErr(ERROR_INFO, "Can't update a texture that failed to be created.");
+        return;
+    }
+
     BufferDesc stagingBufferDescription;
     stagingBufferDescription.size = size;
     stagingBufferDescription.usage = USAGE_STAGING;
@@ -190,10 +395,10 @@ void VulkanGraphicsDevice::UpdateTexture(Ref<Texture> texture, void* data, size_
     Ref<VulkanDeviceBuffer> stagingBuffer = 
         std::static_pointer_cast<VulkanDeviceBuffer>(resourceFactory->CreateBuffer(stagingBufferDescription));
 
-    void* mappedData;
-    A3D_CHECK_VKRESULT(vkMapMemory(device, stagingBuffer->memory, 0, size, 0, &mappedData));
-    memcpy(mappedData, data, size);
-    vkUnmapMemory(device, stagingBuffer->memory);
+    if (!stagingBuffer->IsValid())
+        return;
+
+    memcpy(stagingBuffer->mappedData, data, size);
 
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -210,7 +415,7 @@ void VulkanGraphicsDevice::UpdateTexture(Ref<Texture> texture, void* data, size_
     barrier.image = vulkanTexture->image;
     barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.levelCount = vulkanTexture->mipLevels;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = 1;
     barrier.srcAccessMask = 0;
@@ -223,35 +428,30 @@ void VulkanGraphicsDevice::UpdateTexture(Ref<Texture> texture, void* data, size_
         1, &barrier
     );
 
-    VkBufferImageCopy copyRegion{};
-    copyRegion.bufferOffset = 0;
-    copyRegion.bufferRowLength = 0;
-    copyRegion.bufferImageHeight = 0;
-    copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    copyRegion.imageSubresource.mipLevel = 0;
-    copyRegion.imageSubresource.baseArrayLayer = 0;
-    copyRegion.imageSubresource.layerCount = 1;
-    copyRegion.imageOffset = { 0, 0, 0 };
-    copyRegion.imageExtent = {
-        vulkanTexture->width,
-        vulkanTexture->height,
-        1
-    };
+    std::vector<VkBufferImageCopy> copyRegions = vulkanTexture->GetUploadRegions(0, size);
 
     vkCmdCopyBufferToImage(transferCommandBuffer, stagingBuffer->buffer, vulkanTexture->image,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
-
-    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
 
-    vkCmdPipelineBarrier(
-        transferCommandBuffer,
-        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        0, 0, nullptr, 0, nullptr,
-        1, &barrier
-    );
+    if (vulkanTexture->GetDescription().generateMipmaps)
+    {
+        GenerateMipmaps(transferCommandBuffer, vulkanTexture->image,
+            vulkanTexture->width, vulkanTexture->height, vulkanTexture->mipLevels);
+    }
+    else
+    {
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(
+            transferCommandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr,
+            1, &barrier
+        );
+    }
 
     A3D_CHECK_VKRESULT(vkEndCommandBuffer(transferCommandBuffer));
 
@@ -266,92 +466,62 @@ void VulkanGraphicsDevice::UpdateTexture(Ref<Texture> texture, void* data, size_
     A3D_CHECK_VKRESULT(vkResetFences(device, 1, &transferFinishedFence));
 }
 
-uint32_t VulkanGraphicsDevice::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+uint64_t VulkanGraphicsDevice::UploadTextureAsync(Ref<Texture> texture, const void* data, size_t size)
 {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(physDevice, &memProperties);
-
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) 
-    {
-        if ((typeFilter & (1 << i)) && 
-            (memProperties.memoryTypes[i].propertyFlags & properties) == properties) 
-        {
-            return i;
-        }
-    }
-
-    return 0;
+    return uploadQueue->UploadTexture(std::static_pointer_cast<VulkanTexture>(texture), data, size);
 }
 
-void VulkanGraphicsDevice::TransitionImageLayout(VkImage image, VkFormat format,
-    VkImageLayout oldLayout, VkImageLayout newLayout, VkImageAspectFlags aspectMask)
+uint64_t VulkanGraphicsDevice::UploadTextureAsync(Ref<Texture> texture, size_t size,
+    const std::function<void(void*)>& write)
 {
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-    A3D_CHECK_VKRESULT(vkBeginCommandBuffer(transferCommandBuffer, &beginInfo));
-
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = oldLayout;
-    barrier.newLayout = newLayout;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = image;
+    return uploadQueue->UploadTexture(std::static_pointer_cast<VulkanTexture>(texture), size, write);
+}
 
-    barrier.subresourceRange.aspectMask = aspectMask;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
+bool VulkanGraphicsDevice::IsUploadComplete(uint64_t upload)
+{
+    return uploadQueue->IsComplete(upload);
+}
 
-    VkPipelineStageFlags sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    VkPipelineStageFlags destinationStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+void VulkanGraphicsDevice::UpdateResourceSet(Ref<ResourceSet> resourceSet, uint32_t binding, uint32_t arrayElement,
+    Ref<TextureView> textureView)
+{
+    Ref<VulkanResourceSet> vulkanSet = std::static_pointer_cast<VulkanResourceSet>(resourceSet);
 
-    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+    if (!vulkanSet->layout->updateAfterBind)
     {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-        destinationStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        // Without update-after-bind the set must not be in use by any frame.
+        WaitIdle();
     }
-    else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-    {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
-        destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    }
-    else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-    {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    }
+    vulkanSet->WriteTexture(binding, arrayElement, static_cast<VulkanTextureView*>(textureView.get()));
+}
 
-    vkCmdPipelineBarrier(
-        transferCommandBuffer,
-        sourceStage,
-        destinationStage,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &barrier
-    );
+bool VulkanGraphicsDevice::IsFormatSupported(TextureFormat format)
+{
+    // The uncompressed formats are all mandatory for sampling.
+    return !IsCompressedFormat(format) || physDeviceFeatures.textureCompressionBC;
+}
 
-    A3D_CHECK_VKRESULT(vkEndCommandBuffer(transferCommandBuffer));
+BindlessTextureTable* VulkanGraphicsDevice::GetBindlessTextureTable()
+{
+    return bindlessTable;
+}
 
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &transferCommandBuffer;
+uint32_t VulkanGraphicsDevice::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+{
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physDevice, &memProperties);
 
-    A3D_CHECK_VKRESULT(vkQueueSubmit(graphicsQueue, 1, &submitInfo, transferFinishedFence));
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) 
+    {
+        if ((typeFilter & (1 << i)) && 
+            (memProperties.memoryTypes[i].propertyFlags & properties) == properties) 
+        {
+            return i;
+        }
+    }
 
-    A3D_CHECK_VKRESULT(vkWaitForFences(device, 1, &transferFinishedFence, VK_TRUE, UINT64_MAX));
-    A3D_CHECK_VKRESULT(vkResetFences(device, 1, &transferFinishedFence));
+    return 0;
 }
 
 void VulkanGraphicsDevice::CreateInstance()
@@ -483,6 +653,7 @@ void VulkanGraphicsDevice::CreatePhysDevice()
             physDevice = vkDevice;
             graphicsQueueIndex = graphicsIndex;
             presentQueueIndex = presentIndex;
+            physDeviceQueueFamilyProperties = queueProps;
 
             vkGetPhysicalDeviceProperties(physDevice, &physDeviceProperties);
             vkGetPhysicalDeviceFeatures(physDevice, &physDeviceFeatures);
@@ -495,32 +666,100 @@ void VulkanGraphicsDevice::CreatePhysDevice()
 
 void VulkanGraphicsDevice::CreateDevice()
 {
+    // Uploads prefer a transfer-only family, which usually maps to the
+    // copy engines, then a second queue of the graphics family.
+    transferQueueIndex = graphicsQueueIndex;
+    transferQueueSlot = physDeviceQueueFamilyProperties[graphicsQueueIndex].queueCount > 1 ? 1 : 0;
+
+    for (uint32_t i = 0; i < physDeviceQueueFamilyProperties.size(); ++i)
+    {
+        VkQueueFlags flags = physDeviceQueueFamilyProperties[i].queueFlags;
+        if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+        {
+            transferQueueIndex = i;
+            transferQueueSlot = 0;
+            break;
+        }
+    }
+
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = 
     {
-        graphicsQueueIndex, presentQueueIndex
+        graphicsQueueIndex, presentQueueIndex, transferQueueIndex
     };
 
-    float queuePriority = 1.0f;
+    float queuePriorities[] = { 1.0f, 1.0f };
 
     for (uint32_t queueFamily : uniqueQueueFamilies) 
     {
         VkDeviceQueueCreateInfo queueCreateInfo{};
         queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
         queueCreateInfo.queueFamilyIndex = queueFamily;
-        queueCreateInfo.queueCount = 1;
-        queueCreateInfo.pQueuePriorities = &queuePriority;
+        queueCreateInfo.queueCount = queueFamily == transferQueueIndex ? transferQueueSlot + 1 : 1;
+        queueCreateInfo.pQueuePriorities = queuePriorities;
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
     VkPhysicalDeviceFeatures deviceFeatures{};
+    deviceFeatures.textureCompressionBC = physDeviceFeatures.textureCompressionBC;
+
+    VkPhysicalDeviceDescriptorIndexingFeatures supportedIndexing = {};
+    supportedIndexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+    VkPhysicalDeviceFeatures2 supportedFeatures = {};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures.pNext = &supportedIndexing;
+    vkGetPhysicalDeviceFeatures2(physDevice, &supportedFeatures);
+
+    bindlessSupported = supportedIndexing.shaderSampledImageArrayNonUniformIndexing &&
+        supportedIndexing.descriptorBindingSampledImageUpdateAfterBind &&
+        supportedIndexing.descriptorBindingPartiallyBound &&
+        supportedIndexing.runtimeDescriptorArray;
+
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexing = {};
+    descriptorIndexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+    if (bindlessSupported)
+    {
+        descriptorIndexing.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        descriptorIndexing.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        descriptorIndexing.descriptorBindingPartiallyBound = VK_TRUE;
+        descriptorIndexing.runtimeDescriptorArray = VK_TRUE;
+
+        VkPhysicalDeviceDescriptorIndexingProperties indexingProperties = {};
+        indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+        VkPhysicalDeviceProperties2 properties = {};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties.pNext = &indexingProperties;
+        vkGetPhysicalDeviceProperties2(physDevice, &properties);
+
+        bindlessTextureCapacity = std::min({ MAX_BINDLESS_TEXTURES,
+            indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+            indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages });
+    }
+    else
+    {
+        LogMsg("Descriptor indexing is not supported, sprites fall back to bound texture slots.");
+    }
 
     VkPhysicalDeviceDynamicRenderingFeatures dynamicRendering = {};
     dynamicRendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
     dynamicRendering.dynamicRendering = VK_TRUE;
+    dynamicRendering.pNext = bindlessSupported ? &descriptorIndexing : nullptr;
+
+    VkPhysicalDeviceSynchronization2Features synchronization2 = {};
+    synchronization2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+    synchronization2.synchronization2 = VK_TRUE;
+    synchronization2.pNext = &dynamicRendering;
+
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphore = {};
+    timelineSemaphore.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    timelineSemaphore.timelineSemaphore = VK_TRUE;
+    timelineSemaphore.pNext = &synchronization2;
 
     VkDeviceCreateInfo createInfo{};
-    createInfo.pNext = &dynamicRendering;
+    createInfo.pNext = &timelineSemaphore;
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -530,6 +769,13 @@ void VulkanGraphicsDevice::CreateDevice()
 
     deviceExtensions.push_back("VK_KHR_swapchain");
     deviceExtensions.push_back("VK_KHR_dynamic_rendering");
+    deviceExtensions.push_back("VK_KHR_synchronization2");
+    deviceExtensions.push_back("VK_KHR_timeline_semaphore");
+
+    if (bindlessSupported && physDeviceProperties.apiVersion < VK_API_VERSION_1_2)
+    {
+        deviceExtensions.push_back("VK_EXT_descriptor_indexing");
+    }
 
     createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
     createInfo.ppEnabledExtensionNames = deviceExtensions.data();
@@ -544,6 +790,7 @@ void VulkanGraphicsDevice::CreateQueues()
 {
     vkGetDeviceQueue(device, graphicsQueueIndex, 0, &graphicsQueue);
     vkGetDeviceQueue(device, presentQueueIndex, 0, &presentQueue);
+    vkGetDeviceQueue(device, transferQueueIndex, transferQueueSlot, &transferQueue);
 }
 
 void VulkanGraphicsDevice::CreateCommandBuffers()
@@ -573,8 +820,85 @@ void VulkanGraphicsDevice::CreateLocks()
     A3D_CHECK_VKRESULT(vkCreateFence(device, &fenceInfo, nullptr, &transferFinishedFence));
     A3D_CHECK_VKRESULT(vkResetFences(device, 1, &transferFinishedFence));
 
-    A3D_CHECK_VKRESULT(vkCreateFence(device, &fenceInfo, nullptr, &renderFinishedFence));
-    A3D_CHECK_VKRESULT(vkResetFences(device, 1, &renderFinishedFence));
+    A3D_CHECK_VKRESULT(vkCreateFence(device, &fenceInfo, nullptr, &submitFinishedFence));
+    A3D_CHECK_VKRESULT(vkResetFences(device, 1, &submitFinishedFence));
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    for (auto& frame : frameData)
+    {
+        A3D_CHECK_VKRESULT(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &frame.imageAvailableSemaphore));
+        A3D_CHECK_VKRESULT(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &frame.renderFinishedSemaphore));
+        A3D_CHECK_VKRESULT(vkCreateFence(device, &fenceInfo, nullptr, &frame.inFlightFence));
+    }
+}
+
+void VulkanGraphicsDevice::CreatePipelineCache()
+{
+    std::vector<uint8_t> initialData;
+
+    if (VFS::FileExists(PIPELINE_CACHE_PATH))
+    {
+        Ref<VFile> file = VFS::ReadFile(PIPELINE_CACHE_PATH);
+
+        PipelineCacheHeader header{};
+        if (file && file->GetLength() >= sizeof(header))
+        {
+            file->ReadBytes(&header, sizeof(header));
+        }
+
+        bool valid =
+            header.magic == PIPELINE_CACHE_MAGIC &&
+            header.version == PIPELINE_CACHE_VERSION &&
+            header.vendorID == physDeviceProperties.vendorID &&
+            header.deviceID == physDeviceProperties.deviceID &&
+            header.driverVersion == physDeviceProperties.driverVersion &&
+            memcmp(header.pipelineCacheUUID, physDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0 &&
+            header.dataSize == file->GetLength() - sizeof(header);
+
+        if (valid)
+        {
+            initialData.resize(header.dataSize);
+            file->ReadBytes(initialData.data(), initialData.size(), sizeof(header));
+        }
+        else
+        {
+            LogMsg("Pipeline cache is stale or from another device, starting empty.");
+        }
+    }
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = initialData.size();
+    createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+    A3D_CHECK_VKRESULT(vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache));
+}
+
+void VulkanGraphicsDevice::SavePipelineCache()
+{
+    size_t dataSize = 0;
+    A3D_CHECK_VKRESULT(vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr));
+
+    std::vector<uint8_t> data(sizeof(PipelineCacheHeader) + dataSize);
+    A3D_CHECK_VKRESULT(vkGetPipelineCacheData(device, pipelineCache, &dataSize,
+        data.data() + sizeof(PipelineCacheHeader)));
+
+    PipelineCacheHeader header{};
+    header.magic = PIPELINE_CACHE_MAGIC;
+    header.version = PIPELINE_CACHE_VERSION;
+    header.dataSize = dataSize;
+    header.vendorID = physDeviceProperties.vendorID;
+    header.deviceID = physDeviceProperties.deviceID;
+    header.driverVersion = physDeviceProperties.driverVersion;
+    memcpy(header.pipelineCacheUUID, physDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+    memcpy(data.data(), &header, sizeof(header));
+
+    if (!VFS::WriteFile(PIPELINE_CACHE_PATH, data.data(), sizeof(header) + dataSize))
+    {
+        LogErr(ERROR_INFO, "Failed to write pipeline cache: %s", PIPELINE_CACHE_PATH);
+    }
 }
 
 } // namespace aero3d
@@ -1,35 +1,59 @@
 #ifndef AERO3D_GRAPHICS_VULKAN_VULKANGRAPHICSDEVICE_H_
 #define AERO3D_GRAPHICS_VULKAN_VULKANGRAPHICSDEVICE_H_
 
+#include <array>
+
 #include <volk.h>
 
 #include "Utils/Common.h"
 #include "Graphics/Vulkan/VulkanBootstrap.h"
+#include "Graphics/Vulkan/VulkanMemoryAllocator.h"
 #include "Graphics/GraphicsDevice.h"
 #include "Graphics/Vulkan/VulkanResourceFactory.h"
 #include "Graphics/Vulkan/VulkanSwapchain.h"
+#include "Graphics/Vulkan/VulkanUploadQueue.h"
 
 namespace aero3d {
 
+struct VulkanFrameData
+{
+    VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
+    VkSemaphore renderFinishedSemaphore = VK_NULL_HANDLE;
+    VkFence inFlightFence = VK_NULL_HANDLE;
+};
+
 class VulkanGraphicsDevice : public GraphicsDevice
 {
 public:
     VulkanGraphicsDevice(RenderSurfaceCreateInfo& renderSurfaceInfo);
     ~VulkanGraphicsDevice();
 
-    virtual Ref<CommandList> CreateCommandList() override;
+    virtual Ref<CommandList> CreateCommandList(CommandListLevel level = CommandListLevel::Primary) override;
     virtual ResourceFactory* GetResourceFactory() override;
     virtual Swapchain* GetSwapchain() override;
 
+    virtual bool BeginFrame() override;
+    virtual void EndFrame() override;
+    virtual void WaitIdle() override;
+    virtual uint64_t GetFrameNumber() override;
+
     virtual void SubmitCommands(Ref<CommandList> commandList) override;
-    virtual void Present() override;
 
     virtual void UpdateBuffer(Ref<DeviceBuffer> buffer, void* data, size_t size, size_t offset = 0) override;
+    virtual void* MapBuffer(Ref<DeviceBuffer> buffer) override;
     virtual void UpdateTexture(Ref<Texture> texture, void* data, size_t size) override;
+    virtual uint64_t UploadTextureAsync(Ref<Texture> texture, const void* data, size_t size) override;
+    virtual uint64_t UploadTextureAsync(Ref<Texture> texture, size_t size,
+        const std::function<void(void*)>& write) override;
+    virtual bool IsUploadComplete(uint64_t upload) override;
+    virtual void UpdateResourceSet(Ref<ResourceSet> resourceSet, uint32_t binding, uint32_t arrayElement,
+        Ref<TextureView> textureView) override;
+
+    virtual bool IsFormatSupported(TextureFormat format) override;
+
+    virtual BindlessTextureTable* GetBindlessTextureTable() override;
 
     uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
-    void TransitionImageLayout(VkImage image, VkFormat format,
-        VkImageLayout oldLayout, VkImageLayout newLayout, VkImageAspectFlags aspectMask);
 
 public:
     RenderSurfaceCreateInfo surfaceInfo;
@@ -44,21 +68,41 @@ public:
     std::vector<VkQueueFamilyProperties> physDeviceQueueFamilyProperties;
     uint32_t graphicsQueueIndex = 0;
     uint32_t presentQueueIndex = 0;
+    uint32_t transferQueueIndex = 0;
+    // Index of the transfer queue within its family, it is the graphics
+    // queue itself when no other queue is available.
+    uint32_t transferQueueSlot = 0;
+
+    bool bindlessSupported = false;
+    uint32_t bindlessTextureCapacity = 0;
 
     VkDevice device = VK_NULL_HANDLE;
 
     VkQueue graphicsQueue = VK_NULL_HANDLE;
     VkQueue presentQueue = VK_NULL_HANDLE;
+    VkQueue transferQueue = VK_NULL_HANDLE;
+
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
 
     VkCommandPool commandPool = VK_NULL_HANDLE;
     VkCommandBuffer transferCommandBuffer = VK_NULL_HANDLE;
 
     VkFence transferFinishedFence = VK_NULL_HANDLE;
-    VkFence renderFinishedFence = VK_NULL_HANDLE;
+    VkFence submitFinishedFence = VK_NULL_HANDLE;
+
+    std::array<VulkanFrameData, MAX_FRAMES_IN_FLIGHT> frameData;
+    uint32_t currentFrame = 0;
+    uint64_t frameNumber = 0;
+    bool frameStarted = false;
+    std::vector<VkCommandBuffer> frameCommandBuffers;
 
+    VulkanMemoryAllocator* memoryAllocator = nullptr;
     VulkanSwapchain* swapchain = nullptr;
     VulkanDescriptorAllocator* descriptorAllocator = nullptr;
+    VulkanCommandBufferAllocator* commandBufferAllocator = nullptr;
     VulkanResourceFactory* resourceFactory = nullptr;
+    VulkanUploadQueue* uploadQueue = nullptr;
+    BindlessTextureTable* bindlessTable = nullptr;
 
 private:
     void CreateInstance();
@@ -68,6 +112,8 @@ private:
     void CreateQueues();
     void CreateCommandBuffers();
     void CreateLocks();
+    void CreatePipelineCache();
+    void SavePipelineCache();
 
 };
 
@@ -0,0 +1,366 @@
+#include "Graphics/Vulkan/VulkanMemoryAllocator.h"
+
+#include <algorithm>
+
+#include "Graphics/Vulkan/VulkanGraphicsDevice.h"
+#include "Graphics/Vulkan/VulkanUtils.h"
+#include "Utils/Log.h"
+
+namespace aero3d {
+
+constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+constexpr VkDeviceSize MIN_NODE_SIZE = 256;
+
+static VkDeviceSize NextPowerOfTwo(VkDeviceSize value)
+{
+    VkDeviceSize result = 1;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+static uint32_t Log2(VkDeviceSize value)
+{
+    uint32_t result = 0;
+    while (value >>= 1)
+    {
+        result++;
+    }
+    return result;
+}
+
+static bool AllocateNode(VulkanMemoryBlock& block, VkDeviceSize nodeSize, VkDeviceSize& offset)
+{
+    uint32_t level = Log2(block.size / nodeSize);
+
+    int32_t freeLevel = static_cast<int32_t>(level);
+    while (freeLevel >= 0 && block.freeNodes[freeLevel].empty())
+    {
+        freeLevel--;
+    }
+
+    if (freeLevel < 0)
+        return false;
+
+    auto it = block.freeNodes[freeLevel].begin();
+    offset = *it;
+    block.freeNodes[freeLevel].erase(it);
+
+    // Split the larger node, keeping the upper halves free.
+    for (uint32_t l = static_cast<uint32_t>(freeLevel); l < level; ++l)
+    {
+        block.freeNodes[l + 1].insert(offset + (block.size >> (l + 1)));
+    }
+
+    block.allocatedNodes[offset] = level;
+    block.allocatedBytes += nodeSize;
+
+    return true;
+}
+
+static void FreeNode(VulkanMemoryBlock& block, VkDeviceSize offset)
+{
+    auto it = block.allocatedNodes.find(offset);
+    if (it == block.allocatedNodes.end())
+    {
+        LogErr(ERROR_INFO, "Freeing memory that was not allocated from this block.");
+        return;
+    }
+
+    uint32_t level = it->second;
+    block.allocatedNodes.erase(it);
+    block.allocatedBytes -= block.size >> level;
+
+    while (level > 0)
+    {
+        VkDeviceSize buddy = offset ^ (block.size >> level);
+
+        auto buddyIt = block.freeNodes[level].find(buddy);
+        if (buddyIt == block.freeNodes[level].end())
+            break;
+
+        block.freeNodes[level].erase(buddyIt);
+        offset = std::min(offset, buddy);
+        level--;
+    }
+
+    block.freeNodes[level].insert(offset);
+}
+
+static VkDeviceSize LargestFreeNode(const VulkanMemoryBlock& block)
+{
+    for (uint32_t level = 0; level < block.freeNodes.size(); ++level)
+    {
+        if (!block.freeNodes[level].empty())
+            return block.size >> level;
+    }
+    return 0;
+}
+
+VulkanMemoryAllocator::VulkanMemoryAllocator(VulkanGraphicsDevice* gd)
+{
+    m_GraphicsDevice = gd;
+}
+
+VulkanMemoryAllocator::~VulkanMemoryAllocator()
+{
+    if (m_AllocationCount > 0)
+    {
+        LogErr(ERROR_INFO, "%u device memory allocations were not freed.", m_AllocationCount);
+    }
+
+    for (auto& pool : m_Pools)
+    {
+        for (auto& block : pool->blocks)
+        {
+            DestroyBlock(block.get());
+        }
+    }
+    m_Pools.clear();
+
+    for (auto& [memory, size] : m_DedicatedAllocations)
+    {
+        vkFreeMemory(m_GraphicsDevice->device, memory, nullptr);
+    }
+    m_DedicatedAllocations.clear();
+}
+
+bool VulkanMemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+    bool linear, VulkanAllocation& allocation)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    uint32_t memoryTypeIndex = m_GraphicsDevice->FindMemoryType(requirements.memoryTypeBits, properties);
+    VulkanMemoryPool* pool = GetPool(memoryTypeIndex, linear);
+
+    VkDeviceSize nodeSize = std::max({ NextPowerOfTwo(requirements.size),
+        NextPowerOfTwo(requirements.alignment), MIN_NODE_SIZE });
+
+    allocation = {};
+    allocation.size = requirements.size;
+    allocation.pool = pool;
+
+    // Requests that would take over most of a block get their own memory.
+    if (nodeSize > pool->blockSize / 2)
+    {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = requirements.size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+        VkResult result = vkAllocateMemory(m_GraphicsDevice->device, &allocInfo, nullptr, &allocation.memory);
+        if (result != VK_SUCCESS)
+        {
+            LogErr(ERROR_INFO, "Dedicated allocation of %llu bytes failed: %s",
+                static_cast<unsigned long long>(requirements.size), VkResultToString(result));
+            return false;
+        }
+
+        if (pool->hostVisible)
+        {
+            A3D_CHECK_VKRESULT(vkMapMemory(m_GraphicsDevice->device, allocation.memory, 0, VK_WHOLE_SIZE, 0,
+                &allocation.mappedData));
+        }
+
+        m_DedicatedAllocations[allocation.memory] = requirements.size;
+        m_RequestedBytes += requirements.size;
+        m_AllocationCount++;
+        return true;
+    }
+
+    VulkanMemoryBlock* block = nullptr;
+    VkDeviceSize offset = 0;
+
+    for (auto& candidate : pool->blocks)
+    {
+        if (AllocateNode(*candidate, nodeSize, offset))
+        {
+            block = candidate.get();
+            break;
+        }
+    }
+
+    if (block == nullptr)
+    {
+        block = CreateBlock(pool, pool->blockSize);
+        if (block == nullptr || !AllocateNode(*block, nodeSize, offset))
+            return false;
+    }
+
+    allocation.memory = block->memory;
+    allocation.offset = offset;
+    allocation.block = block;
+    if (block->mappedData != nullptr)
+    {
+        allocation.mappedData = static_cast<uint8_t*>(block->mappedData) + offset;
+    }
+
+    m_RequestedBytes += requirements.size;
+    m_AllocationCount++;
+    return true;
+}
+
+void VulkanMemoryAllocator::Free(VulkanAllocation& allocation)
+{
+    if (allocation.memory == VK_NULL_HANDLE)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_RequestedBytes -= allocation.size;
+    m_AllocationCount--;
+
+    if (allocation.block == nullptr)
+    {
+        m_DedicatedAllocations.erase(allocation.memory);
+        vkFreeMemory(m_GraphicsDevice->device, allocation.memory, nullptr);
+        allocation = {};
+        return;
+    }
+
+    VulkanMemoryPool* pool = allocation.pool;
+    VulkanMemoryBlock* block = allocation.block;
+
+    FreeNode(*block, allocation.offset);
+
+    // Keep one empty block around so a pool does not thrash on alloc/free.
+    if (block->allocatedBytes == 0 && pool->blocks.size() > 1)
+    {
+        DestroyBlock(block);
+        pool->blocks.erase(std::remove_if(pool->blocks.begin(), pool->blocks.end(),
+            [block](const std::unique_ptr<VulkanMemoryBlock>& b) { return b.get() == block; }),
+            pool->blocks.end());
+    }
+
+    allocation = {};
+}
+
+VulkanMemoryStats VulkanMemoryAllocator::GetStats()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    VulkanMemoryStats stats;
+    stats.allocationCount = m_AllocationCount;
+    stats.requestedBytes = m_RequestedBytes;
+
+    VkDeviceSize freeBytes = 0;
+    VkDeviceSize largestFreeBytes = 0;
+
+    for (auto& pool : m_Pools)
+    {
+        for (auto& block : pool->blocks)
+        {
+            VkDeviceSize largest = LargestFreeNode(*block);
+
+            stats.blockCount++;
+            stats.reservedBytes += block->size;
+            stats.allocatedBytes += block->allocatedBytes;
+            stats.largestFreeRange = std::max(stats.largestFreeRange, largest);
+
+            freeBytes += block->size - block->allocatedBytes;
+            largestFreeBytes += largest;
+        }
+    }
+
+    for (auto& [memory, size] : m_DedicatedAllocations)
+    {
+        stats.dedicatedCount++;
+        stats.reservedBytes += size;
+        stats.allocatedBytes += size;
+    }
+
+    if (freeBytes > 0)
+    {
+        stats.fragmentation = 1.0f - static_cast<float>(largestFreeBytes) / static_cast<float>(freeBytes);
+    }
+
+    return stats;
+}
+
+void VulkanMemoryAllocator::LogStats()
+{
+    VulkanMemoryStats stats = GetStats();
+
+    LogMsg("Device Memory: %u allocations in %u blocks (+%u dedicated), %.2f/%.2f MiB used, "
+        "largest free range %.2f MiB, fragmentation %.1f%%",
+        stats.allocationCount, stats.blockCount, stats.dedicatedCount,
+        stats.allocatedBytes / (1024.0 * 1024.0), stats.reservedBytes / (1024.0 * 1024.0),
+        stats.largestFreeRange / (1024.0 * 1024.0), stats.fragmentation * 100.0f);
+}
+
+VulkanMemoryPool* VulkanMemoryAllocator::GetPool(uint32_t memoryTypeIndex, bool linear)
+{
+    for (auto& pool : m_Pools)
+    {
+        if (pool->memoryTypeIndex == memoryTypeIndex && pool->linear == linear)
+            return pool.get();
+    }
+
+    const VkPhysicalDeviceMemoryProperties& memoryProperties = m_GraphicsDevice->physDeviceMemoryProperties;
+    const VkMemoryType& memoryType = memoryProperties.memoryTypes[memoryTypeIndex];
+    VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryType.heapIndex].size;
+
+    auto pool = std::make_unique<VulkanMemoryPool>();
+    pool->memoryTypeIndex = memoryTypeIndex;
+    pool->linear = linear;
+    pool->hostVisible = memoryType.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
+    // Small heaps (e.g. a 256 MiB BAR) get proportionally smaller blocks.
+    pool->blockSize = DEFAULT_BLOCK_SIZE;
+    while (pool->blockSize > MIN_NODE_SIZE && pool->blockSize > heapSize / 8)
+    {
+        pool->blockSize >>= 1;
+    }
+
+    m_Pools.push_back(std::move(pool));
+    return m_Pools.back().get();
+}
+
+VulkanMemoryBlock* VulkanMemoryAllocator::CreateBlock(VulkanMemoryPool* pool, VkDeviceSize size)
+{
+    auto block = std::make_unique<VulkanMemoryBlock>();
+    block->size = size;
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = pool->memoryTypeIndex;
+
+    VkResult result = vkAllocateMemory(m_GraphicsDevice->device, &allocInfo, nullptr, &block->memory);
+    if (result != VK_SUCCESS)
+    {
+        LogErr(ERROR_INFO, "Failed to allocate a %llu byte memory block: %s",
+            static_cast<unsigned long long>(size), VkResultToString(result));
+        return nullptr;
+    }
+
+    if (pool->hostVisible)
+    {
+        A3D_CHECK_VKRESULT(vkMapMemory(m_GraphicsDevice->device, block->memory, 0, VK_WHOLE_SIZE, 0,
+            &block->mappedData));
+    }
+
+    block->freeNodes.resize(Log2(size / MIN_NODE_SIZE) + 1);
+    block->freeNodes[0].insert(0);
+
+    pool->blocks.push_back(std::move(block));
+    return pool->blocks.back().get();
+}
+
+void VulkanMemoryAllocator::DestroyBlock(VulkanMemoryBlock* block)
+{
+    if (block->mappedData != nullptr)
+    {
+        vkUnmapMemory(m_GraphicsDevice->device, block->memory);
+        block->mappedData = nullptr;
+    }
+    if (block->memory != VK_NULL_HANDLE)
+    {
+        vkFreeMemory(m_GraphicsDevice->device, block->memory, nullptr);
+        block->memory = VK_NULL_HANDLE;
+    }
+}
+
+} // namespace aero3d
@@ -0,0 +1,98 @@
+#ifndef AERO3D_GRAPHICS_VULKAN_VULKANMEMORYALLOCATOR_H_
+#define AERO3D_GRAPHICS_VULKAN_VULKANMEMORYALLOCATOR_H_
+
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include <volk.h>
+
+namespace aero3d {
+
+class VulkanGraphicsDevice;
+
+// One VkDeviceMemory split with a buddy allocator. Level 0 is the whole
+// block, every following level halves the node size.
+struct VulkanMemoryBlock
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    void* mappedData = nullptr;
+
+    std::vector<std::set<VkDeviceSize>> freeNodes;
+    std::unordered_map<VkDeviceSize, uint32_t> allocatedNodes;
+    VkDeviceSize allocatedBytes = 0;
+};
+
+// Linear (buffers) and optimal (images) resources get separate pools so
+// bufferImageGranularity never has to be considered inside a block.
+struct VulkanMemoryPool
+{
+    uint32_t memoryTypeIndex = 0;
+    bool linear = true;
+    bool hostVisible = false;
+    VkDeviceSize blockSize = 0;
+
+    std::vector<std::unique_ptr<VulkanMemoryBlock>> blocks;
+};
+
+struct VulkanAllocation
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mappedData = nullptr;
+
+    VulkanMemoryPool* pool = nullptr;
+    VulkanMemoryBlock* block = nullptr;
+};
+
+struct VulkanMemoryStats
+{
+    uint32_t blockCount = 0;
+    uint32_t dedicatedCount = 0;
+    uint32_t allocationCount = 0;
+
+    VkDeviceSize reservedBytes = 0;
+    VkDeviceSize requestedBytes = 0;
+    VkDeviceSize allocatedBytes = 0;
+    VkDeviceSize largestFreeRange = 0;
+
+    // Share of free memory outside each block's largest free range.
+    float fragmentation = 0.0f;
+};
+
+class VulkanMemoryAllocator
+{
+public:
+    VulkanMemoryAllocator(VulkanGraphicsDevice* gd);
+    ~VulkanMemoryAllocator();
+
+    bool Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+        bool linear, VulkanAllocation& allocation);
+    void Free(VulkanAllocation& allocation);
+
+    VulkanMemoryStats GetStats();
+    void LogStats();
+
+private:
+    VulkanMemoryPool* GetPool(uint32_t memoryTypeIndex, bool linear);
+    VulkanMemoryBlock* CreateBlock(VulkanMemoryPool* pool, VkDeviceSize size);
+    void DestroyBlock(VulkanMemoryBlock* block);
+
+private:
+    VulkanGraphicsDevice* m_GraphicsDevice = nullptr;
+
+    std::mutex m_Mutex;
+    std::vector<std::unique_ptr<VulkanMemoryPool>> m_Pools;
+    std::unordered_map<VkDeviceMemory, VkDeviceSize> m_DedicatedAllocations;
+    VkDeviceSize m_RequestedBytes = 0;
+    uint32_t m_AllocationCount = 0;
+
+};
+
+} // namespace aero3d
+
+#endif // AERO3D_GRAPHICS_VULKAN_VULKANMEMORYALLOCATOR_H_
@@ -33,6 +33,16 @@ Ref<Texture> VulkanResourceFactory::CreateTexture(TextureDesc& desc)
     return std::make_shared<VulkanTexture>(m_GraphicsDevice, desc);;
 }
 
+Ref<Texture> VulkanResourceFactory::CreatePlacedTexture(TextureDesc& desc)
+{
+    return std::make_shared<VulkanTexture>(m_GraphicsDevice, desc, false);
+}
+
+Ref<TextureHeap> VulkanResourceFactory::CreateTextureHeap(const TextureMemoryInfo& info)
+{
+    return std::make_shared<VulkanTextureHeap>(m_GraphicsDevice, info);
+}
+
 Ref<TextureView> VulkanResourceFactory::CreateTextureView(TextureViewDesc& desc) 
 {
     return std::make_shared<VulkanTextureView>(m_GraphicsDevice, desc);
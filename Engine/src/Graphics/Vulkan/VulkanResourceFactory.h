@@ -17,6 +17,8 @@ public:
     virtual Ref<Pipeline> CreatePipeline(PipelineDesc& desc) override;
     virtual Ref<DeviceBuffer> CreateBuffer(BufferDesc& desc) override;
     virtual Ref<Texture> CreateTexture(TextureDesc& desc) override;
+    virtual Ref<Texture> CreatePlacedTexture(TextureDesc& desc) override;
+    virtual Ref<TextureHeap> CreateTextureHeap(const TextureMemoryInfo& info) override;
     virtual Ref<TextureView> CreateTextureView(TextureViewDesc& desc) override;
     virtual Ref<Sampler> CreateSampler(SamplerDesc& desc) override;
     virtual Ref<ResourceLayout> CreateResourceLayout(ResourceLayoutDesc& desc) override;
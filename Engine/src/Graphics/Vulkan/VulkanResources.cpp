@@ -1,8 +1,12 @@
 #include "Graphics/Vulkan/VulkanResources.h"
 
+#include <algorithm>
+#include <cstdio>
+
 #include "Graphics/Vulkan/VulkanGraphicsDevice.h"
 #include "Graphics/Vulkan/VulkanUtils.h"
 #include "IO/VFS.h"
+#include "Utils/Hash.h"
 
 namespace aero3d {
 
@@ -24,9 +28,21 @@ VulkanDeviceBuffer::VulkanDeviceBuffer(VulkanGraphicsDevice* gd, BufferDesc desc
     if (desc.usage & USAGE_STORAGE)
         usageFlags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 
+    regionSize = desc.size;
+    VkDeviceSize bufferSize = desc.size;
+
+    if (desc.dynamic)
+    {
+        const VkPhysicalDeviceLimits& limits = m_GraphicsDevice->physDeviceProperties.limits;
+        VkDeviceSize alignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+
+        regionSize = (desc.size + alignment - 1) & ~(alignment - 1);
+        bufferSize = regionSize * MAX_FRAMES_IN_FLIGHT;
+    }
+
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferInfo.size = desc.size;
+    bufferInfo.size = bufferSize;
     bufferInfo.usage = usageFlags;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
@@ -41,17 +57,18 @@ VulkanDeviceBuffer::VulkanDeviceBuffer(VulkanGraphicsDevice* gd, BufferDesc desc
         ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
         : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memoryRequirements.size;
-    allocInfo.memoryTypeIndex = m_GraphicsDevice->FindMemoryType(
-        memoryRequirements.memoryTypeBits,
-        memoryPropertyFlags
-    );
+    if (!m_GraphicsDevice->memoryAllocator->Allocate(memoryRequirements, memoryPropertyFlags, true, allocation))
+    {
+        LogErr(ERROR_INFO, "Failed to allocate memory for a buffer of %llu bytes.",
+            static_cast<unsigned long long>(bufferSize));
+        vkDestroyBuffer(m_GraphicsDevice->device, buffer, nullptr);
+        buffer = VK_NULL_HANDLE;
+        return;
+    }
 
-    A3D_CHECK_VKRESULT(vkAllocateMemory(m_GraphicsDevice->device, &allocInfo, nullptr, &memory));
+    A3D_CHECK_VKRESULT(vkBindBufferMemory(m_GraphicsDevice->device, buffer, allocation.memory, allocation.offset));
 
-    A3D_CHECK_VKRESULT(vkBindBufferMemory(m_GraphicsDevice->device, buffer, memory, 0));
+    mappedData = allocation.mappedData;
 }
 
 VulkanDeviceBuffer::~VulkanDeviceBuffer() 
@@ -61,11 +78,27 @@ VulkanDeviceBuffer::~VulkanDeviceBuffer()
         vkDestroyBuffer(m_GraphicsDevice->device, buffer, nullptr);
         buffer = VK_NULL_HANDLE;
     }
-    if (memory != VK_NULL_HANDLE)
-    {
-        vkFreeMemory(m_GraphicsDevice->device, memory, nullptr);
-        memory = VK_NULL_HANDLE;
-    }
+    m_GraphicsDevice->memoryAllocator->Free(allocation);
+    mappedData = nullptr;
+}
+
+VkDeviceSize VulkanDeviceBuffer::GetFrameOffset() const
+{
+    if (!m_Description.dynamic)
+        return 0;
+    return regionSize * m_GraphicsDevice->currentFrame;
+}
+
+void* VulkanDeviceBuffer::GetFrameData() const
+{
+    return static_cast<uint8_t*>(mappedData) + GetFrameOffset();
+}
+
+bool VulkanDeviceBuffer::IsFrameDataCurrent() const
+{
+    if (!m_Description.dynamic || !regionsDiverged)
+        return true;
+    return lastWriteFrame == m_GraphicsDevice->frameNumber;
 }
 
 inline VkFormat ToVkFormat(TextureFormat format) 
@@ -80,11 +113,18 @@ inline VkFormat ToVkFormat(TextureFormat format)
         case TextureFormat::D32FLOAT:      return VK_FORMAT_D32_SFLOAT;
         case TextureFormat::D24S8:         return VK_FORMAT_D24_UNORM_S8_UINT;
         case TextureFormat::D32S8:         return VK_FORMAT_D32_SFLOAT_S8_UINT;
+        case TextureFormat::BC1:           return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case TextureFormat::BC1_SRGB:      return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        case TextureFormat::BC3:           return VK_FORMAT_BC3_UNORM_BLOCK;
+        case TextureFormat::BC3_SRGB:      return VK_FORMAT_BC3_SRGB_BLOCK;
+        case TextureFormat::BC5:           return VK_FORMAT_BC5_UNORM_BLOCK;
+        case TextureFormat::BC7:           return VK_FORMAT_BC7_UNORM_BLOCK;
+        case TextureFormat::BC7_SRGB:      return VK_FORMAT_BC7_SRGB_BLOCK;
         default:                           return VK_FORMAT_R8G8B8A8_UNORM;
     }
 }
 
-VulkanTexture::VulkanTexture(VulkanGraphicsDevice* gd, TextureDesc desc) 
+VulkanTexture::VulkanTexture(VulkanGraphicsDevice* gd, TextureDesc desc, bool allocateMemory) 
 {
     m_GraphicsDevice = gd;
     m_Description = desc;
@@ -95,6 +135,36 @@ VulkanTexture::VulkanTexture(VulkanGraphicsDevice* gd, TextureDesc desc)
     format = desc.format;
     usage = desc.usage;
 
+    if (!m_GraphicsDevice->IsFormatSupported(desc.format))
+    {
+        LogErr(ERROR_INFO, "Block compressed textures are not supported by this device.");
+        return;
+    }
+
+    if (desc.generateMipmaps)
+    {
+        // Levels are blitted from one another with linear filtering.
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(m_GraphicsDevice->physDevice, vkFormat, &formatProperties);
+
+        VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+            VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+        if ((formatProperties.optimalTilingFeatures & required) == required)
+        {
+            desc.mipLevels = CalculateMipLevels(desc.width, desc.height);
+            desc.generateMipmaps = desc.mipLevels > 1;
+        }
+        else
+        {
+            LogMsg("Format %d can't be blitted, mipmaps are not generated.", static_cast<int>(desc.format));
+            desc.generateMipmaps = false;
+            desc.mipLevels = 1;
+        }
+        m_Description = desc;
+    }
+    mipLevels = desc.mipLevels;
+
     VkImageUsageFlags usageFlags = 0;
     switch (desc.usage)
     {
@@ -112,6 +182,11 @@ VulkanTexture::VulkanTexture(VulkanGraphicsDevice* gd, TextureDesc desc)
             break;
     }
 
+    if (desc.generateMipmaps)
+    {
+        usageFlags |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -129,17 +204,20 @@ VulkanTexture::VulkanTexture(VulkanGraphicsDevice* gd, TextureDesc desc)
 
     A3D_CHECK_VKRESULT(vkCreateImage(m_GraphicsDevice->device, &imageInfo, nullptr, &image));
 
-    VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements(m_GraphicsDevice->device, image, &memRequirements);
+    vkGetImageMemoryRequirements(m_GraphicsDevice->device, image, &memoryRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = m_GraphicsDevice->FindMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (!allocateMemory)
+        return;
 
-    A3D_CHECK_VKRESULT(vkAllocateMemory(m_GraphicsDevice->device, &allocInfo, nullptr, &memory));
+    if (!m_GraphicsDevice->memoryAllocator->Allocate(memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, allocation))
+    {
+        LogErr(ERROR_INFO, "Failed to allocate memory for a %ux%u texture.", desc.width, desc.height);
+        vkDestroyImage(m_GraphicsDevice->device, image, nullptr);
+        image = VK_NULL_HANDLE;
+        return;
+    }
 
-    vkBindImageMemory(m_GraphicsDevice->device, image, memory, 0);
+    A3D_CHECK_VKRESULT(vkBindImageMemory(m_GraphicsDevice->device, image, allocation.memory, allocation.offset));
 }
 
 VulkanTexture::VulkanTexture(VulkanGraphicsDevice* gd, TextureDesc desc, VkImage existingImage) 
@@ -166,12 +244,104 @@ VulkanTexture::~VulkanTexture()
             vkDestroyImage(m_GraphicsDevice->device, image, nullptr);
             image = VK_NULL_HANDLE;
         }
-        if (memory != VK_NULL_HANDLE)
+        m_GraphicsDevice->memoryAllocator->Free(allocation);
+    }
+}
+
+TextureMemoryInfo VulkanTexture::GetMemoryInfo() const
+{
+    TextureMemoryInfo info;
+    info.size = memoryRequirements.size;
+    info.alignment = memoryRequirements.alignment;
+    info.memoryTypeMask = memoryRequirements.memoryTypeBits;
+    return info;
+}
+
+std::vector<VkBufferImageCopy> VulkanTexture::GetUploadRegions(VkDeviceSize bufferOffset, size_t size) const
+{
+    uint32_t levels = m_Description.generateMipmaps ? 1 : mipLevels;
+
+    std::vector<VkBufferImageCopy> regions;
+    regions.reserve(levels);
+
+    size_t offset = 0;
+    for (uint32_t level = 0; level < levels; level++)
+    {
+        uint32_t levelWidth = std::max(width >> level, 1u);
+        uint32_t levelHeight = std::max(height >> level, 1u);
+        size_t levelSize = GetTextureLevelSize(format, levelWidth, levelHeight);
+
+        if (offset + levelSize > size)
         {
-            vkFreeMemory(m_GraphicsDevice->device, memory, nullptr);
-            memory = VK_NULL_HANDLE;
+            LogErr(ERROR_INFO, "Texture data holds %zu bytes, level %u needs %zu more.",
+                size, level, offset + levelSize - size);
+            break;
         }
+
+        // Extents of compressed levels smaller than a block stay in texels,
+        // the buffer side is rounded up to whole blocks implicitly.
+        VkBufferImageCopy region{};
+        region.bufferOffset = bufferOffset + offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { levelWidth, levelHeight, 1 };
+        regions.push_back(region);
+
+        offset += levelSize;
+    }
+
+    return regions;
+}
+
+VulkanTextureHeap::VulkanTextureHeap(VulkanGraphicsDevice* gd, const TextureMemoryInfo& info)
+{
+    m_GraphicsDevice = gd;
+
+    VkMemoryRequirements requirements{};
+    requirements.size = info.size;
+    requirements.alignment = info.alignment;
+    requirements.memoryTypeBits = info.memoryTypeMask;
+
+    if (!m_GraphicsDevice->memoryAllocator->Allocate(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, allocation))
+    {
+        LogErr(ERROR_INFO, "Failed to allocate a texture heap of %llu bytes.",
+            static_cast<unsigned long long>(info.size));
+    }
+}
+
+VulkanTextureHeap::~VulkanTextureHeap()
+{
+    // Placed textures keep the heap alive, so none of them is left.
+    m_GraphicsDevice->memoryAllocator->Free(allocation);
+}
+
+bool VulkanTextureHeap::Place(Ref<Texture> texture, uint64_t offset)
+{
+    auto vulkanTexture = std::static_pointer_cast<VulkanTexture>(texture);
+    const VkMemoryRequirements& requirements = vulkanTexture->memoryRequirements;
+
+    bool placeable = IsValid() && vulkanTexture->IsValid() && !vulkanTexture->heap &&
+        vulkanTexture->allocation.memory == VK_NULL_HANDLE;
+
+    bool fits = placeable && offset % requirements.alignment == 0 &&
+        offset + requirements.size <= allocation.size &&
+        (requirements.memoryTypeBits & (1u << allocation.pool->memoryTypeIndex)) != 0;
+
+    if (!fits)
+    {
+        LogErr(ERROR_INFO, "Texture can't be placed at offset %llu of the heap.",
+            static_cast<unsigned long long>(offset));
+        return false;
     }
+
+    A3D_CHECK_VKRESULT(vkBindImageMemory(m_GraphicsDevice->device, vulkanTexture->image,
+        allocation.memory, allocation.offset + offset));
+
+    vulkanTexture->heap = shared_from_this();
+    return true;
 }
 
 VulkanTextureView::VulkanTextureView(VulkanGraphicsDevice* gd, TextureViewDesc desc)
@@ -189,7 +359,7 @@ VulkanTextureView::VulkanTextureView(VulkanGraphicsDevice* gd, TextureViewDesc d
 
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = desc.baseMipLevel;
-    viewInfo.subresourceRange.levelCount = desc.mipLevels;
+    viewInfo.subresourceRange.levelCount = desc.mipLevels == ALL_MIP_LEVELS ? VK_REMAINING_MIP_LEVELS : desc.mipLevels;
     viewInfo.subresourceRange.baseArrayLayer = desc.baseArrayLayer;
     viewInfo.subresourceRange.layerCount = desc.arrayLayers;
 
@@ -243,7 +413,11 @@ VulkanSampler::VulkanSampler(VulkanGraphicsDevice* gd, SamplerDesc& desc)
     samplerInfo.unnormalizedCoordinates = VK_FALSE;
 
     samplerInfo.compareEnable = VK_FALSE;
-    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.mipmapMode = (desc.mipmapMode == SamplerFilter::Linear)
+        ? VK_SAMPLER_MIPMAP_MODE_LINEAR : VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.mipLodBias = desc.mipLodBias;
+    samplerInfo.minLod = desc.minLod;
+    samplerInfo.maxLod = desc.maxLod;
 
     A3D_CHECK_VKRESULT(vkCreateSampler(m_GraphicsDevice->device, &samplerInfo, nullptr, &sampler));
 }
@@ -290,13 +464,6 @@ VulkanFramebuffer::VulkanFramebuffer(VulkanGraphicsDevice* gd, FramebufferDesc d
         viewInfo.subresourceRange.layerCount = 1;
 
         A3D_CHECK_VKRESULT(vkCreateImageView(m_GraphicsDevice->device, &viewInfo, nullptr, &imageViews[i]));
-
-        m_GraphicsDevice->TransitionImageLayout(
-            vt->image,
-            vt->vkFormat,
-            VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-            VK_IMAGE_ASPECT_COLOR_BIT);
     }
 
     renderArea = { frames[0]->width, frames[0]->height };
@@ -324,13 +491,6 @@ VulkanFramebuffer::VulkanFramebuffer(VulkanGraphicsDevice* gd, FramebufferDesc d
         viewInfo.subresourceRange.layerCount = 1;
 
         A3D_CHECK_VKRESULT(vkCreateImageView(m_GraphicsDevice->device, &viewInfo, nullptr, &depthStencilImageView));
-        
-        m_GraphicsDevice->TransitionImageLayout(
-            depthStencil->image,
-            depthStencil->vkFormat,
-            VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-            aspectMask);
     }
 }
 
@@ -354,6 +514,7 @@ VulkanFramebuffer::~VulkanFramebuffer()
     frames.clear();
 }
 
+#ifndef A3D_DIST
 static shaderc_shader_kind ShaderStageToShaderCKind(ShaderStages stage)
 {
     switch (stage)
@@ -365,16 +526,51 @@ static shaderc_shader_kind ShaderStageToShaderCKind(ShaderStages stage)
     }
 }
 
+// Bump when compile options change so stale cache entries are not reused.
+constexpr uint32_t SHADER_CACHE_VERSION = 1;
+#endif
+
 VulkanShader::VulkanShader(VulkanGraphicsDevice* gd, ShaderDesc desc) 
 {
     m_GraphicsDevice = gd;
     m_Description = desc;
 
-    std::string filePath = desc.path + ".glsl";
+    std::vector<uint32_t> spirv;
+
+#ifdef A3D_DIST
+    spirv = LoadSPIRV(desc.path + ".spv");
+#else
+    std::string sourcePath = desc.path + ".glsl";
+
+    if (!VFS::FileExists(sourcePath))
+    {
+        spirv = LoadSPIRV(desc.path + ".spv");
+    }
+    else
+    {
+        std::string source = VFS::ReadFile(sourcePath)->ReadString();
+
+        uint64_t hash = HashFNV1a(source.data(), source.size());
+        hash = HashFNV1a(&desc.stage, sizeof(desc.stage), hash);
+        hash = HashFNV1a(&SHADER_CACHE_VERSION, sizeof(SHADER_CACHE_VERSION), hash);
 
-    std::string source = VFS::ReadFile(filePath)->ReadString();
+        char cachePath[64];
+        snprintf(cachePath, sizeof(cachePath), "cache/shaders/%016llx.spv", static_cast<unsigned long long>(hash));
 
-    std::vector<uint32_t> spirv = CompileGLSL(source, ShaderStageToShaderCKind(desc.stage), desc.path);
+        if (VFS::FileExists(cachePath))
+        {
+            spirv = LoadSPIRV(cachePath);
+        }
+        else
+        {
+            spirv = CompileGLSL(source, ShaderStageToShaderCKind(desc.stage), desc.path);
+            if (!spirv.empty())
+            {
+                VFS::WriteFile(cachePath, spirv.data(), spirv.size() * sizeof(uint32_t));
+            }
+        }
+    }
+#endif
 
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -394,20 +590,41 @@ VulkanShader::~VulkanShader()
     }
 }
 
+std::vector<uint32_t> VulkanShader::LoadSPIRV(const std::string& path)
+{
+    Ref<VFile> file = VFS::ReadFile(path);
+    if (!file || file->GetLength() == 0 || file->GetLength() % sizeof(uint32_t) != 0)
+    {
+        LogErr(ERROR_INFO, "Invalid SPIR-V file: %s", path.c_str());
+        return {};
+    }
+
+    std::vector<uint32_t> spirv(file->GetLength() / sizeof(uint32_t));
+    file->ReadBytes(spirv.data(), file->GetLength());
+
+    return spirv;
+}
+
+#ifndef A3D_DIST
 std::vector<uint32_t> VulkanShader::CompileGLSL(const std::string& source,
     shaderc_shader_kind kind, const std::string& name)
 {
-    shaderc::Compiler compiler;
+    // Compiling is thread-safe, so one compiler serves every shader.
+    static shaderc::Compiler compiler;
+
     shaderc::CompileOptions options;
+    options.SetOptimizationLevel(shaderc_optimization_level_performance);
 
     shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(source, kind, name.c_str(), options);
 
     if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
-        LogErr(ERROR_INFO, "Failed to compile Vulkan Shader");
+        LogErr(ERROR_INFO, "Failed to compile Vulkan Shader %s: %s", name.c_str(), result.GetErrorMessage().c_str());
+        return {};
     }
 
     return { result.cbegin(), result.cend() };
 }
+#endif
 
 static VkDescriptorType ToDescriptorType(ResourceKind kind) 
 {
@@ -434,6 +651,7 @@ VulkanResourceLayout::VulkanResourceLayout(VulkanGraphicsDevice* gd, ResourceLay
     bindings = desc.bindings;
 
     std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+    std::vector<VkDescriptorBindingFlags> bindingFlags;
     for (const auto& binding : desc.bindings)
     {
         VkDescriptorSetLayoutBinding layoutBinding{};
@@ -456,13 +674,32 @@ VulkanResourceLayout::VulkanResourceLayout(VulkanGraphicsDevice* gd, ResourceLay
             layoutBinding.stageFlags |= VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
 
         layoutBindings.push_back(layoutBinding);
+
+        VkDescriptorBindingFlags flags = 0;
+        if (binding.bindless)
+        {
+            flags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+            updateAfterBind = true;
+        }
+        bindingFlags.push_back(flags);
     }
 
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+    bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
     VkDescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
     layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
     layoutInfo.pBindings = layoutBindings.data();
 
+    if (updateAfterBind)
+    {
+        layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        layoutInfo.pNext = &bindingFlagsInfo;
+    }
+
     A3D_CHECK_VKRESULT(vkCreateDescriptorSetLayout(m_GraphicsDevice->device, &layoutInfo, nullptr, &descriptorSetLayout));
 }
 
@@ -480,8 +717,23 @@ VulkanResourceSet::VulkanResourceSet(VulkanGraphicsDevice* gd, ResourceSetDesc d
     m_GraphicsDevice = gd;
 
     Ref<VulkanResourceLayout> vulkanLayout = std::static_pointer_cast<VulkanResourceLayout>(desc.layout);
+    layout = vulkanLayout;
 
-    descriptorSet = m_GraphicsDevice->descriptorAllocator->Allocate(vulkanLayout->descriptorSetLayout);
+    if (vulkanLayout->updateAfterBind)
+    {
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        for (const auto& binding : vulkanLayout->bindings)
+        {
+            poolSizes.push_back({ ToDescriptorType(binding.kind), binding.count });
+        }
+
+        descriptorSet = m_GraphicsDevice->descriptorAllocator->AllocateUpdateAfterBind(
+            vulkanLayout->descriptorSetLayout, poolSizes);
+    }
+    else
+    {
+        descriptorSet = m_GraphicsDevice->descriptorAllocator->Allocate(vulkanLayout->descriptorSetLayout);
+    }
 
     std::vector<VkWriteDescriptorSet> writes;
     std::vector<VkDescriptorBufferInfo> bufferInfos;
@@ -587,7 +839,11 @@ VulkanResourceSet::VulkanResourceSet(VulkanGraphicsDevice* gd, ResourceSetDesc d
             }
         }, resource);
 
-        writes.push_back(write);
+        // Bindless arrays may start out empty and get filled in later.
+        if (write.descriptorCount > 0)
+        {
+            writes.push_back(write);
+        }
     }
 
     vkUpdateDescriptorSets(m_GraphicsDevice->device,
@@ -603,13 +859,39 @@ VulkanResourceSet::~VulkanResourceSet()
     }
 }
 
+void VulkanResourceSet::WriteTexture(uint32_t binding, uint32_t arrayElement, VulkanTextureView* textureView)
+{
+    for (const auto& layoutBinding : layout->bindings)
+    {
+        if (layoutBinding.binding != binding)
+            continue;
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = descriptorSet;
+        write.dstBinding = binding;
+        write.dstArrayElement = arrayElement;
+        write.descriptorCount = 1;
+        write.descriptorType = ToDescriptorType(layoutBinding.kind);
+
+        VkDescriptorImageInfo imageInfo{};
+        PrepareImageWrite(layoutBinding, textureView, write, imageInfo);
+        write.pImageInfo = &imageInfo;
+
+        vkUpdateDescriptorSets(m_GraphicsDevice->device, 1, &write, 0, nullptr);
+        return;
+    }
+
+    LogErr(ERROR_INFO, "Resource set has no binding %u.", binding);
+}
+
 void VulkanResourceSet::PrepareBufferWrite(const ResourceBinding& binding, void* resource,
     VkWriteDescriptorSet& write, VkDescriptorBufferInfo& bufferInfo)
 {
     auto* buffer = static_cast<VulkanDeviceBuffer*>(resource);
     bufferInfo.buffer = buffer->buffer;
-    bufferInfo.offset = 0;
-    bufferInfo.range = VK_WHOLE_SIZE;
+    bufferInfo.offset = buffer->GetFrameOffset();
+    bufferInfo.range = buffer->GetDescription().dynamic ? buffer->regionSize : VK_WHOLE_SIZE;
 }
 
 void VulkanResourceSet::PrepareImageWrite(const ResourceBinding& binding, void* resource,
@@ -675,6 +957,10 @@ static VkFormat VertexFormatToVkFormat(VertexFormat type)
         case VertexFormat::Int3: return VK_FORMAT_R32G32B32_SINT;
         case VertexFormat::Int4: return VK_FORMAT_R32G32B32A32_SINT;
 
+        case VertexFormat::UInt: return VK_FORMAT_R32_UINT;
+        case VertexFormat::UByte4Norm: return VK_FORMAT_R8G8B8A8_UNORM;
+        case VertexFormat::UShort4Norm: return VK_FORMAT_R16G16B16A16_UNORM;
+
         case VertexFormat::Bool: return VK_FORMAT_R8_UINT;
 
         case VertexFormat::Mat2: return VK_FORMAT_R32G32_SFLOAT;
@@ -826,7 +1112,7 @@ VulkanPipeline::VulkanPipeline(VulkanGraphicsDevice* gd, PipelineDesc desc)
     pipelineInfo.renderPass = VK_NULL_HANDLE;
     pipelineInfo.subpass = 0;
 
-    A3D_CHECK_VKRESULT(vkCreateGraphicsPipelines(m_GraphicsDevice->device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline));
+    A3D_CHECK_VKRESULT(vkCreateGraphicsPipelines(m_GraphicsDevice->device, m_GraphicsDevice->pipelineCache, 1, &pipelineInfo, nullptr, &pipeline));
 }
 
 VulkanPipeline::~VulkanPipeline() 
@@ -1,28 +1,50 @@
 #ifndef AERO3D_GRAPHICS_VULKAN_VULKANRESOURCES_H_
 #define AERO3D_GRAPHICS_VULKAN_VULKANRESOURCES_H_
 
+#include <memory>
 #include <vector>
 
 #include <volk.h>
+#ifndef A3D_DIST
 #include <shaderc/shaderc.hpp>
+#endif
 
 #include "Graphics/Resources.h"
+#include "Graphics/Vulkan/VulkanMemoryAllocator.h"
 
 namespace aero3d {
 
 class VulkanGraphicsDevice;
+class VulkanTextureHeap;
 
 class VulkanDeviceBuffer : public DeviceBuffer {
 public:
     VulkanDeviceBuffer(VulkanGraphicsDevice* gd, BufferDesc desc);
     ~VulkanDeviceBuffer();
 
+    virtual bool IsValid() const override { return buffer != VK_NULL_HANDLE; }
+
+    VkDeviceSize GetFrameOffset() const;
+    void* GetFrameData() const;
+    // False when a dynamic buffer's current region may be stale.
+    bool IsFrameDataCurrent() const;
+
 public:
     VkBuffer buffer = VK_NULL_HANDLE;
-    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VulkanAllocation allocation;
     VkMemoryRequirements memoryRequirements;
     uint32_t size = 0;
 
+    // Host-visible buffers stay mapped. Dynamic ones hold one region per
+    // frame in flight.
+    VkDeviceSize regionSize = 0;
+    void* mappedData = nullptr;
+
+    // Until a write reaches a single region, all of them hold the same data.
+    bool written = false;
+    bool regionsDiverged = false;
+    uint64_t lastWriteFrame = 0;
+
 private:
     VulkanGraphicsDevice* m_GraphicsDevice = nullptr;
 
@@ -40,23 +62,42 @@ inline TextureFormat FromVkFormat(VkFormat format)
         case VK_FORMAT_D32_SFLOAT:         return TextureFormat::D32FLOAT;
         case VK_FORMAT_D24_UNORM_S8_UINT:    return TextureFormat::D24S8;
         case VK_FORMAT_D32_SFLOAT_S8_UINT:   return TextureFormat::D32S8;
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: return TextureFormat::BC1;
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:  return TextureFormat::BC1_SRGB;
+        case VK_FORMAT_BC3_UNORM_BLOCK:      return TextureFormat::BC3;
+        case VK_FORMAT_BC3_SRGB_BLOCK:       return TextureFormat::BC3_SRGB;
+        case VK_FORMAT_BC5_UNORM_BLOCK:      return TextureFormat::BC5;
+        case VK_FORMAT_BC7_UNORM_BLOCK:      return TextureFormat::BC7;
+        case VK_FORMAT_BC7_SRGB_BLOCK:       return TextureFormat::BC7_SRGB;
         default:                           return TextureFormat::RGBA8;
     }
 }
 
 class VulkanTexture : public Texture {
 public:
-    VulkanTexture(VulkanGraphicsDevice* gd, TextureDesc desc);
+    // Without allocateMemory the image waits to be placed in a heap.
+    VulkanTexture(VulkanGraphicsDevice* gd, TextureDesc desc, bool allocateMemory = true);
     VulkanTexture(VulkanGraphicsDevice* gd, TextureDesc desc, VkImage existingImage);
     ~VulkanTexture();
 
+    virtual bool IsValid() const override { return image != VK_NULL_HANDLE; }
+    virtual TextureMemoryInfo GetMemoryInfo() const override;
+
+    // Copies for tightly packed levels, largest first, starting at
+    // bufferOffset. Textures that generate their mipmaps only take level 0.
+    std::vector<VkBufferImageCopy> GetUploadRegions(VkDeviceSize bufferOffset, size_t size) const;
+
 public:
     VkImage image = VK_NULL_HANDLE;
-    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VulkanAllocation allocation;
+    VkMemoryRequirements memoryRequirements{};
+    // Set for placed textures, which don't own their memory.
+    Ref<VulkanTextureHeap> heap = nullptr;
     VkFormat vkFormat = VK_FORMAT_UNDEFINED;
 
     uint32_t width = 0;
     uint32_t height = 0;
+    uint32_t mipLevels = 1;
     TextureFormat format = TextureFormat::RGBA8;
     TextureUsage usage = TextureUsage::Storage;
 
@@ -67,6 +108,23 @@ private:
 
 };
 
+class VulkanTextureHeap : public TextureHeap, public std::enable_shared_from_this<VulkanTextureHeap>
+{
+public:
+    VulkanTextureHeap(VulkanGraphicsDevice* gd, const TextureMemoryInfo& info);
+    ~VulkanTextureHeap();
+
+    virtual bool IsValid() const override { return allocation.memory != VK_NULL_HANDLE; }
+    virtual bool Place(Ref<Texture> texture, uint64_t offset) override;
+
+public:
+    VulkanAllocation allocation;
+
+private:
+    VulkanGraphicsDevice* m_GraphicsDevice = nullptr;
+
+};
+
 class VulkanTextureView : public TextureView
 {
 public:
@@ -125,7 +183,10 @@ public:
     VkShaderModule shaderModule = VK_NULL_HANDLE;
 
 private:
+    std::vector<uint32_t> LoadSPIRV(const std::string& path);
+#ifndef A3D_DIST
     std::vector<uint32_t> CompileGLSL(const std::string& source, shaderc_shader_kind kind, const std::string& name);
+#endif
 
 private:
     VulkanGraphicsDevice* m_GraphicsDevice = nullptr;
@@ -140,6 +201,7 @@ public:
 public:
     VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
     std::vector<ResourceBinding> bindings;
+    bool updateAfterBind = false;
 
 private:
     VulkanGraphicsDevice* m_GraphicsDevice = nullptr;
@@ -151,8 +213,11 @@ public:
     VulkanResourceSet(VulkanGraphicsDevice* gd, ResourceSetDesc desc);
     ~VulkanResourceSet();
 
+    void WriteTexture(uint32_t binding, uint32_t arrayElement, VulkanTextureView* textureView);
+
 public:
     VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    Ref<VulkanResourceLayout> layout = nullptr;
 
 private:
     void PrepareBufferWrite(const ResourceBinding& binding, void* resource,
@@ -59,17 +59,11 @@ VulkanSwapchain::VulkanSwapchain(VulkanGraphicsDevice* gd)
 {
     m_GraphicsDevice = gd;
     
-    CreateLocks();
     Create();
 }
 
 VulkanSwapchain::~VulkanSwapchain()
 {
-    if (imageAvailableFence != VK_NULL_HANDLE)
-    {
-        vkDestroyFence(m_GraphicsDevice->device, imageAvailableFence, nullptr);
-        imageAvailableFence = VK_NULL_HANDLE;
-    }
     Destroy();
 }
 
@@ -84,34 +78,22 @@ Ref<Framebuffer> VulkanSwapchain::GetFramebuffer()
     return frameBuffers[currentImageIndex];
 }
 
-uint32_t VulkanSwapchain::AcquireNextImage()
+bool VulkanSwapchain::AcquireNextImage(VkSemaphore imageAvailableSemaphore)
 {
     VkResult result = vkAcquireNextImageKHR(m_GraphicsDevice->device, swapchain,
-        UINT64_MAX, VK_NULL_HANDLE, imageAvailableFence, &currentImageIndex);
+        UINT64_MAX, imageAvailableSemaphore, VK_NULL_HANDLE, &currentImageIndex);
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+    if (result == VK_ERROR_OUT_OF_DATE_KHR)
     {
         Resize();
-    } 
-    else
+        return false;
+    }
+    else if (result != VK_SUBOPTIMAL_KHR)
     {
         A3D_CHECK_VKRESULT(result);
     }
 
-    A3D_CHECK_VKRESULT(vkWaitForFences(m_GraphicsDevice->device, 1, &imageAvailableFence, VK_TRUE, UINT64_MAX));
-    A3D_CHECK_VKRESULT(vkResetFences(m_GraphicsDevice->device, 1, &imageAvailableFence));
-
-    return currentImageIndex;
-}
-
-void VulkanSwapchain::CreateLocks()
-{
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-    A3D_CHECK_VKRESULT(vkCreateFence(m_GraphicsDevice->device, &fenceInfo, nullptr, &imageAvailableFence));
-    A3D_CHECK_VKRESULT(vkResetFences(m_GraphicsDevice->device, 1, &imageAvailableFence));
+    return true;
 }
 
 void VulkanSwapchain::CreateSwapchain()
@@ -209,7 +191,6 @@ void VulkanSwapchain::Create()
 {
     CreateSwapchain();
     CreateFramebuffer();
-    AcquireNextImage();
 }
 
 void VulkanSwapchain::Destroy()
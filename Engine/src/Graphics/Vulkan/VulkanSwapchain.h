@@ -29,11 +29,10 @@ public:
 
     virtual Ref<Framebuffer> GetFramebuffer() override;
 
-    uint32_t AcquireNextImage();
+    // Returns false if the swapchain was out of date and had to be recreated.
+    bool AcquireNextImage(VkSemaphore imageAvailableSemaphore);
 
 public:
-    VkFence imageAvailableFence = VK_NULL_HANDLE;
-
     VkSwapchainKHR swapchain = VK_NULL_HANDLE;
     VkFormat imageFormat = VK_FORMAT_UNDEFINED;
     VkExtent2D extent;
@@ -45,7 +44,6 @@ public:
     Ref<VulkanTexture> depthStencil = nullptr;
 
 private:
-    void CreateLocks();
     void CreateSwapchain();
     void CreateFramebuffer();
 
@@ -0,0 +1,411 @@
+#include "Graphics/Vulkan/VulkanUploadQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Graphics/Vulkan/VulkanGraphicsDevice.h"
+#include "Graphics/Vulkan/VulkanUtils.h"
+#include "Utils/Assert.h"
+
+namespace aero3d {
+
+// Textures with generated mipmaps stay in TRANSFER_DST_OPTIMAL, the
+// graphics queue blits the chain after acquiring them.
+static VkImageMemoryBarrier2 MakeOwnershipBarrier(VulkanGraphicsDevice* gd, VulkanTexture* texture)
+{
+    bool generateMipmaps = texture->GetDescription().generateMipmaps;
+
+    VkImageMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = generateMipmaps ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcQueueFamilyIndex = gd->transferQueueIndex;
+    barrier.dstQueueFamilyIndex = gd->graphicsQueueIndex;
+    barrier.image = texture->image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    return barrier;
+}
+
+static void PipelineBarrier(VkCommandBuffer commandBuffer, const std::vector<VkImageMemoryBarrier2>& barriers)
+{
+    VkDependencyInfo dependencyInfo{};
+    dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size());
+    dependencyInfo.pImageMemoryBarriers = barriers.data();
+
+    vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+}
+
+VulkanUploadQueue::VulkanUploadQueue(VulkanGraphicsDevice* gd)
+{
+    m_GraphicsDevice = gd;
+    m_OwnershipTransfer = gd->transferQueueIndex != gd->graphicsQueueIndex;
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = gd->transferQueueIndex;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+    A3D_CHECK_VKRESULT(vkCreateCommandPool(gd->device, &poolInfo, nullptr, &m_CommandPool));
+
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    A3D_CHECK_VKRESULT(vkCreateSemaphore(gd->device, &semaphoreInfo, nullptr, &timelineSemaphore));
+
+    BufferDesc ringDesc;
+    ringDesc.size = STAGING_RING_SIZE;
+    ringDesc.usage = USAGE_STAGING;
+
+    m_StagingRing = std::static_pointer_cast<VulkanDeviceBuffer>(gd->resourceFactory->CreateBuffer(ringDesc));
+    Assert(ERROR_INFO, m_StagingRing->IsValid(), "Failed to create the staging ring!");
+
+    m_Alignment = std::max<VkDeviceSize>(m_Alignment,
+        gd->physDeviceProperties.limits.optimalBufferCopyOffsetAlignment);
+}
+
+VulkanUploadQueue::~VulkanUploadQueue()
+{
+    if (!m_InFlight.empty())
+    {
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &timelineSemaphore;
+        waitInfo.pValues = &m_InFlight.back().timelineValue;
+
+        A3D_CHECK_VKRESULT(vkWaitSemaphoresKHR(m_GraphicsDevice->device, &waitInfo, UINT64_MAX));
+    }
+
+    m_InFlight.clear();
+    m_PendingAcquires.clear();
+    m_OpenBatch = {};
+    m_StagingRing = nullptr;
+
+    if (m_CommandPool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(m_GraphicsDevice->device, m_CommandPool, nullptr);
+        m_CommandPool = VK_NULL_HANDLE;
+    }
+    if (timelineSemaphore != VK_NULL_HANDLE)
+    {
+        vkDestroySemaphore(m_GraphicsDevice->device, timelineSemaphore, nullptr);
+        timelineSemaphore = VK_NULL_HANDLE;
+    }
+}
+
+uint64_t VulkanUploadQueue::UploadTexture(Ref<VulkanTexture> texture, const void* data, size_t size)
+{
+    return UploadTexture(texture, size, [data, size](void* staging)
+    {
+        memcpy(staging, data, size);
+    });
+}
+
+uint64_t VulkanUploadQueue::UploadTexture(Ref<VulkanTexture> texture, size_t size,
+    const std::function<void(void*)>& write)
+{
+    // Zero is never a pending timeline value, the upload reads as complete.
+    if (!texture->IsValid())
+    {
+        LogErr(ERROR_INFO, "Can't upload to a texture that failed to be created.");
+        return 0;
+    }
+
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceSize stagingOffset = 0;
+
+    if (size > STAGING_RING_SIZE / 2)
+    {
+        BufferDesc stagingDesc;
+        stagingDesc.size = static_cast<uint32_t>(size);
+        stagingDesc.usage = USAGE_STAGING;
+
+        Ref<VulkanDeviceBuffer> dedicated = std::static_pointer_cast<VulkanDeviceBuffer>(
+            m_GraphicsDevice->resourceFactory->CreateBuffer(stagingDesc));
+        if (!dedicated->IsValid())
+            return 0;
+
+        write(dedicated->mappedData);
+
+        BeginBatch();
+        m_OpenBatch.stagingBuffers.push_back(dedicated);
+        stagingBuffer = dedicated->buffer;
+    }
+    else
+    {
+        // Reserve before opening the batch, making room may have to submit
+        // whatever the open batch holds.
+        while (!AllocateStaging(size, stagingOffset))
+        {
+            Flush();
+
+            VkSemaphoreWaitInfo waitInfo{};
+            waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            waitInfo.semaphoreCount = 1;
+            waitInfo.pSemaphores = &timelineSemaphore;
+            waitInfo.pValues = &m_InFlight.front().timelineValue;
+
+            A3D_CHECK_VKRESULT(vkWaitSemaphoresKHR(m_GraphicsDevice->device, &waitInfo, UINT64_MAX));
+            Reclaim();
+        }
+
+        write(static_cast<uint8_t*>(m_StagingRing->mappedData) + stagingOffset);
+
+        BeginBatch();
+        m_OpenBatch.ringEnd = m_RingHead;
+        stagingBuffer = m_StagingRing->buffer;
+    }
+
+    VkCommandBuffer commandBuffer = m_OpenBatch.commandBuffer;
+
+    VkImageMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+    barrier.srcAccessMask = VK_ACCESS_2_NONE;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = texture->image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+    PipelineBarrier(commandBuffer, { barrier });
+
+    std::vector<VkBufferImageCopy> copyRegions = texture->GetUploadRegions(stagingOffset, size);
+
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, texture->image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+
+    if (!m_OwnershipTransfer && texture->GetDescription().generateMipmaps)
+    {
+        // Same family as graphics, so this queue can blit.
+        GenerateMipmaps(commandBuffer, texture->image, texture->width, texture->height, texture->mipLevels);
+    }
+    else
+    {
+        // The graphics queue picks the image up after waiting on the
+        // timeline, so the release needs no destination stage.
+        if (m_OwnershipTransfer)
+        {
+            barrier = MakeOwnershipBarrier(m_GraphicsDevice, texture.get());
+        }
+        else
+        {
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        }
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+        barrier.dstAccessMask = VK_ACCESS_2_NONE;
+
+        PipelineBarrier(commandBuffer, { barrier });
+    }
+
+    m_OpenBatch.textures.push_back(texture);
+
+    return m_OpenBatch.timelineValue;
+}
+
+bool VulkanUploadQueue::IsComplete(uint64_t timelineValue)
+{
+    if (m_BatchOpen && timelineValue == m_OpenBatch.timelineValue)
+    {
+        Flush();
+        return false;
+    }
+
+    if (timelineValue <= m_CompletedValue)
+        return true;
+
+    Reclaim();
+    return timelineValue <= m_CompletedValue;
+}
+
+void VulkanUploadQueue::Flush()
+{
+    if (!m_BatchOpen)
+        return;
+
+    A3D_CHECK_VKRESULT(vkEndCommandBuffer(m_OpenBatch.commandBuffer));
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &m_OpenBatch.timelineValue;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &m_OpenBatch.commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &timelineSemaphore;
+
+    A3D_CHECK_VKRESULT(vkQueueSubmit(m_GraphicsDevice->transferQueue, 1, &submitInfo, VK_NULL_HANDLE));
+
+    m_InFlight.push_back(std::move(m_OpenBatch));
+    m_OpenBatch = {};
+    m_BatchOpen = false;
+}
+
+void VulkanUploadQueue::RecordAcquires(VkCommandBuffer commandBuffer)
+{
+    std::vector<VkImageMemoryBarrier2> barriers;
+    barriers.reserve(m_PendingAcquires.size());
+
+    for (auto& texture : m_PendingAcquires)
+    {
+        VkImageMemoryBarrier2 barrier = MakeOwnershipBarrier(m_GraphicsDevice, texture.get());
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+        barrier.srcAccessMask = VK_ACCESS_2_NONE;
+
+        if (texture->GetDescription().generateMipmaps)
+        {
+            barrier.dstStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+            barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        }
+        else
+        {
+            barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+            barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        }
+        barriers.push_back(barrier);
+    }
+
+    if (!barriers.empty())
+    {
+        PipelineBarrier(commandBuffer, barriers);
+    }
+
+    for (auto& texture : m_PendingAcquires)
+    {
+        if (texture->GetDescription().generateMipmaps)
+        {
+            GenerateMipmaps(commandBuffer, texture->image, texture->width, texture->height, texture->mipLevels);
+        }
+    }
+
+    m_PendingAcquires.clear();
+}
+
+void VulkanUploadQueue::BeginBatch()
+{
+    if (m_BatchOpen)
+        return;
+
+    if (m_FreeCommandBuffers.empty())
+    {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = m_CommandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        A3D_CHECK_VKRESULT(vkAllocateCommandBuffers(m_GraphicsDevice->device, &allocInfo, &commandBuffer));
+        m_FreeCommandBuffers.push_back(commandBuffer);
+    }
+
+    m_OpenBatch = {};
+    m_OpenBatch.commandBuffer = m_FreeCommandBuffers.back();
+    m_OpenBatch.timelineValue = m_NextValue++;
+    m_OpenBatch.ringEnd = m_RingHead;
+    m_FreeCommandBuffers.pop_back();
+
+    A3D_CHECK_VKRESULT(vkResetCommandBuffer(m_OpenBatch.commandBuffer, 0));
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    A3D_CHECK_VKRESULT(vkBeginCommandBuffer(m_OpenBatch.commandBuffer, &beginInfo));
+
+    m_BatchOpen = true;
+}
+
+bool VulkanUploadQueue::AllocateStaging(VkDeviceSize size, VkDeviceSize& offset)
+{
+    Reclaim();
+
+    VkDeviceSize alignedHead = (m_RingHead + m_Alignment - 1) & ~(m_Alignment - 1);
+    bool wrapped = m_RingHead < m_RingTail;
+
+    if (!wrapped)
+    {
+        if (alignedHead + size <= STAGING_RING_SIZE)
+        {
+            offset = alignedHead;
+            m_RingHead = alignedHead + size;
+            return true;
+        }
+        // Wrap around, the head must stay behind the tail so a full ring
+        // is never mistaken for an empty one.
+        if (size < m_RingTail)
+        {
+            offset = 0;
+            m_RingHead = size;
+            return true;
+        }
+        return false;
+    }
+
+    if (alignedHead + size < m_RingTail)
+    {
+        offset = alignedHead;
+        m_RingHead = alignedHead + size;
+        return true;
+    }
+    return false;
+}
+
+void VulkanUploadQueue::Reclaim()
+{
+    if (!m_InFlight.empty())
+    {
+        A3D_CHECK_VKRESULT(vkGetSemaphoreCounterValueKHR(m_GraphicsDevice->device, timelineSemaphore,
+            &m_CompletedValue));
+    }
+
+    while (!m_InFlight.empty() && m_InFlight.front().timelineValue <= m_CompletedValue)
+    {
+        VulkanUploadBatch& batch = m_InFlight.front();
+
+        m_RingTail = batch.ringEnd;
+        m_FreeCommandBuffers.push_back(batch.commandBuffer);
+
+        if (m_OwnershipTransfer)
+        {
+            m_PendingAcquires.insert(m_PendingAcquires.end(), batch.textures.begin(), batch.textures.end());
+        }
+
+        m_InFlight.pop_front();
+    }
+
+    // Nothing is in flight or staged in the open batch, start over at the
+    // front so large uploads find contiguous space.
+    if (m_InFlight.empty() && !m_BatchOpen)
+    {
+        m_RingHead = 0;
+        m_RingTail = 0;
+    }
+}
+
+} // namespace aero3d
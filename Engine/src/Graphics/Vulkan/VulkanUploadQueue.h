@@ -0,0 +1,91 @@
+#ifndef AERO3D_GRAPHICS_VULKAN_VULKANUPLOADQUEUE_H_
+#define AERO3D_GRAPHICS_VULKAN_VULKANUPLOADQUEUE_H_
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include <volk.h>
+
+#include "Graphics/Vulkan/VulkanResources.h"
+#include "Utils/Common.h"
+
+namespace aero3d {
+
+class VulkanGraphicsDevice;
+
+constexpr VkDeviceSize STAGING_RING_SIZE = 32ull * 1024 * 1024;
+
+// Texture uploads recorded together and submitted as one batch on the
+// transfer queue. Every batch signals the next value of the timeline.
+struct VulkanUploadBatch
+{
+    uint64_t timelineValue = 0;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkDeviceSize ringEnd = 0;
+    // Uploads that did not fit into the ring bring their own staging.
+    std::vector<Ref<VulkanDeviceBuffer>> stagingBuffers;
+    // Kept alive until the copies finished and, with a dedicated transfer
+    // family, until the graphics queue acquired them.
+    std::vector<Ref<VulkanTexture>> textures;
+};
+
+// Streams textures through a persistently mapped staging ring without ever
+// blocking on the copies. The ring only waits when it runs out of space.
+// Not thread-safe, uploads are issued from the main thread.
+class VulkanUploadQueue
+{
+public:
+    VulkanUploadQueue(VulkanGraphicsDevice* gd);
+    ~VulkanUploadQueue();
+
+    uint64_t UploadTexture(Ref<VulkanTexture> texture, const void* data, size_t size);
+    // write fills size bytes of mapped staging memory, e.g. straight from a file.
+    uint64_t UploadTexture(Ref<VulkanTexture> texture, size_t size, const std::function<void(void*)>& write);
+    bool IsComplete(uint64_t timelineValue);
+
+    // Submits the open batch, if any.
+    void Flush();
+
+    // Graphics submissions wait for this value, so everything IsComplete
+    // reported is visible to them.
+    uint64_t GetCompletedValue() const { return m_CompletedValue; }
+
+    // With a dedicated transfer family the graphics queue has to acquire
+    // finished images before it samples them, and generates their mipmaps.
+    bool HasPendingAcquires() const { return !m_PendingAcquires.empty(); }
+    void RecordAcquires(VkCommandBuffer commandBuffer);
+
+public:
+    VkSemaphore timelineSemaphore = VK_NULL_HANDLE;
+
+private:
+    void BeginBatch();
+    bool AllocateStaging(VkDeviceSize size, VkDeviceSize& offset);
+    void Reclaim();
+
+private:
+    VulkanGraphicsDevice* m_GraphicsDevice = nullptr;
+
+    VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> m_FreeCommandBuffers;
+
+    Ref<VulkanDeviceBuffer> m_StagingRing = nullptr;
+    VkDeviceSize m_RingHead = 0;
+    VkDeviceSize m_RingTail = 0;
+    VkDeviceSize m_Alignment = 16;
+
+    VulkanUploadBatch m_OpenBatch;
+    bool m_BatchOpen = false;
+    std::deque<VulkanUploadBatch> m_InFlight;
+    std::vector<Ref<VulkanTexture>> m_PendingAcquires;
+
+    uint64_t m_NextValue = 1;
+    uint64_t m_CompletedValue = 0;
+    bool m_OwnershipTransfer = false;
+
+};
+
+} // namespace aero3d
+
+#endif // AERO3D_GRAPHICS_VULKAN_VULKANUPLOADQUEUE_H_
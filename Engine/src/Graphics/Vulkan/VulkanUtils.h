@@ -16,6 +16,12 @@ const char* VkResultToString(VkResult result);
 
 void BeginCommandBuffer(VkCommandBuffer& buffer, VkCommandBufferUsageFlags flags);
 
+// Expects every level in TRANSFER_DST_OPTIMAL with level 0 written by a
+// transfer. Leaves the whole chain in SHADER_READ_ONLY_OPTIMAL, visible to
+// fragment shaders. Needs a graphics queue.
+void GenerateMipmaps(VkCommandBuffer commandBuffer, VkImage image, uint32_t width, uint32_t height,
+    uint32_t mipLevels);
+
 } // namespace aero3d
 
 #endif // AERO3D_GRAPHICS_VULKAN_VULKANUTILS_H_
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef AERO3D_IO_ASYNCFILEREADER_H_
+#define AERO3D_IO_ASYNCFILEREADER_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Core/JobSystem.h"
+#include "IO/VFile.h"
+#include "Utils/Common.h"
+
+namespace aero3d {
+
+struct VFSReadResult
+{
+    std::string path;
+    std::vector<uint8_t> data;
+    bool success = false;
+};
+
+// Runs on whichever thread finished the read, hand heavy work off to the
+// job system.
+using VFSReadCallback = std::function<void(VFSReadResult&& result)>;
+
+struct AsyncReadRequest
+{
+    Ref<VFile> file;
+    VFSReadResult result;
+    VFSReadCallback callback;
+};
+
+// Reads whole files without blocking the submitting thread. Thread-safe.
+class AsyncFileReader
+{
+public:
+    virtual ~AsyncFileReader() = default;
+
+    // Every request gets its callback exactly once, also on failure.
+    virtual void Submit(std::vector<Scope<AsyncReadRequest>>& requests) = 0;
+    // Blocks until every request submitted so far completed.
+    virtual void Flush() = 0;
+
+    // The best reader the platform supports.
+    static Scope<AsyncFileReader> Create();
+
+};
+
+// Fallback: every read is a job on the job system.
+class JobFileReader : public AsyncFileReader
+{
+public:
+    JobFileReader() = default;
+    ~JobFileReader();
+
+    virtual void Submit(std::vector<Scope<AsyncReadRequest>>& requests) override;
+    virtual void Flush() override;
+
+private:
+    JobCounter m_Counter;
+
+};
+
+} // namespace aero3d
+
+#endif // AERO3D_IO_ASYNCFILEREADER_H_
@@ -0,0 +1,16 @@
+#ifndef AERO3D_IO_FILEHANDLE_H_
+#define AERO3D_IO_FILEHANDLE_H_
+
+namespace aero3d {
+
+#ifdef _WIN32
+    using FileHandle = void*;
+    constexpr FileHandle FILE_HANDLE_NULL = nullptr;
+#else
+    using FileHandle = int;
+    constexpr FileHandle FILE_HANDLE_NULL = -1;
+#endif
+
+} // namespace aero3d
+
+#endif // AERO3D_IO_FILEHANDLE_H_
@@ -0,0 +1,40 @@
+#include "IO/AsyncFileReader.h"
+
+#include "Utils/Log.h"
+
+namespace aero3d {
+
+JobFileReader::~JobFileReader()
+{
+    Flush();
+}
+
+void JobFileReader::Submit(std::vector<Scope<AsyncReadRequest>>& requests)
+{
+    for (auto& request : requests)
+    {
+        // Jobs have to be copyable.
+        Ref<AsyncReadRequest> shared = std::move(request);
+
+        JobSystem::Execute(m_Counter, [shared]()
+        {
+            VFSReadResult& result = shared->result;
+            result.data.resize(static_cast<size_t>(shared->file->GetLength()));
+
+            VFileRange range;
+            range.buffer = result.data.data();
+            range.size = result.data.size();
+            result.success = range.size == 0 || shared->file->ReadRanges({ range });
+
+            shared->callback(std::move(result));
+        });
+    }
+    requests.clear();
+}
+
+void JobFileReader::Flush()
+{
+    JobSystem::Wait(m_Counter);
+}
+
+} // namespace aero3d
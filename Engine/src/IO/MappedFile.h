@@ -0,0 +1,46 @@
+#ifndef AERO3D_IO_MAPPEDFILE_H_
+#define AERO3D_IO_MAPPEDFILE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "IO/FileHandle.h"
+
+namespace aero3d {
+
+// Read-only mapping of a whole native file, unmapped on destruction.
+// Shared by everything that points into it.
+class MappedFile
+{
+public:
+    MappedFile(const std::string& path);
+    // Maps an already open file, the handle stays owned by the caller and
+    // may be closed while the mapping lives.
+    MappedFile(FileHandle handle);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool IsValid() const { return m_Data != nullptr; }
+
+    // Hints that the whole file is about to be read front to back, so the
+    // kernel starts reading ahead.
+    void AdviseSequential();
+
+    const uint8_t* GetData() const { return m_Data; }
+    uint64_t GetSize() const { return m_Size; }
+
+private:
+    const uint8_t* m_Data = nullptr;
+    uint64_t m_Size = 0;
+#ifdef _WIN32
+    void* m_File = nullptr;
+    void* m_Mapping = nullptr;
+#endif
+
+};
+
+} // namespace aero3d
+
+#endif // AERO3D_IO_MAPPEDFILE_H_
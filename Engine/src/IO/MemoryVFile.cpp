@@ -0,0 +1,102 @@
+#include "IO/MemoryVFile.h"
+
+#include <cstring>
+
+#include "Utils/Log.h"
+
+namespace aero3d {
+
+MemoryVFile::MemoryVFile(const std::string& virtualPath, Ref<MappedFile> mapping,
+    const uint8_t* data, uint64_t length)
+    : m_VirtualPath(virtualPath), m_Mapping(mapping), m_Data(data), m_Length(length)
+{
+}
+
+MemoryVFile::MemoryVFile(const std::string& virtualPath, std::vector<uint8_t>&& buffer)
+    : m_VirtualPath(virtualPath), m_Buffer(std::move(buffer))
+{
+    m_Data = m_Buffer.data();
+    m_Length = m_Buffer.size();
+}
+
+void MemoryVFile::ReadBytes(void* buffer, size_t size, size_t start)
+{
+    if (!buffer)
+    {
+        LogErr(ERROR_INFO, "Buffer is nullptr in file: %s", m_VirtualPath.c_str());
+        return;
+    }
+
+    if (start > m_Length)
+    {
+        LogErr(ERROR_INFO, "Start is past the end of file: %s", m_VirtualPath.c_str());
+        return;
+    }
+
+    if (start + size > m_Length)
+    {
+        LogErr(ERROR_INFO, "Size is bigger than length in file: %s", m_VirtualPath.c_str());
+        size = static_cast<size_t>(m_Length - start);
+    }
+
+    memcpy(buffer, m_Data + start, size);
+}
+
+bool MemoryVFile::ReadRanges(const std::vector<VFileRange>& ranges)
+{
+    bool complete = true;
+    for (const VFileRange& range : ranges)
+    {
+        if (!range.buffer || range.start > m_Length || range.size > m_Length - range.start)
+        {
+            LogErr(ERROR_INFO, "Range is out of bounds in file: %s", m_VirtualPath.c_str());
+            complete = false;
+            continue;
+        }
+
+        memcpy(range.buffer, m_Data + range.start, range.size);
+    }
+    return complete;
+}
+
+std::string MemoryVFile::ReadString()
+{
+    return std::string(reinterpret_cast<const char*>(m_Data), static_cast<size_t>(m_Length));
+}
+
+void MemoryVFile::Truncate(size_t)
+{
+    LogErr(ERROR_INFO, "Archive files are read-only: %s", m_VirtualPath.c_str());
+}
+
+void MemoryVFile::WriteBytes(void*, size_t, size_t)
+{
+    LogErr(ERROR_INFO, "Archive files are read-only: %s", m_VirtualPath.c_str());
+}
+
+bool MemoryVFile::IsWritable()
+{
+    return false;
+}
+
+bool MemoryVFile::IsOpened()
+{
+    return m_Data != nullptr || m_Length == 0;
+}
+
+void* MemoryVFile::GetData()
+{
+    return const_cast<uint8_t*>(m_Data);
+}
+
+uint64_t MemoryVFile::GetLength() const
+{
+    return m_Length;
+}
+
+const std::string& MemoryVFile::GetName() const
+{
+    return m_VirtualPath;
+}
+
+} // namespace aero3d
@@ -0,0 +1,53 @@
+#ifndef AERO3D_IO_MEMORYVFILE_H_
+#define AERO3D_IO_MEMORYVFILE_H_
+
+#include <string>
+#include <vector>
+
+#include "IO/MappedFile.h"
+#include "IO/VFile.h"
+#include "Utils/Common.h"
+
+namespace aero3d {
+
+// Read-only file backed by memory: either a range of an archive mapping,
+// served without a copy, or a buffer it owns, e.g. a decompressed entry.
+class MemoryVFile : public VFile
+{
+public:
+    MemoryVFile(const std::string& virtualPath, Ref<MappedFile> mapping, const uint8_t* data, uint64_t length);
+    MemoryVFile(const std::string& virtualPath, std::vector<uint8_t>&& buffer);
+    ~MemoryVFile() = default;
+
+    virtual void ReadBytes(void* buffer, size_t size, size_t start = 0) override;
+    virtual bool ReadRanges(const std::vector<VFileRange>& ranges) override;
+    virtual std::string ReadString() override;
+
+    virtual void Truncate(size_t pos = 0) override;
+    virtual void WriteBytes(void* data, size_t size, size_t start = 0) override;
+
+    // The data is always resident.
+    virtual void Load() override {}
+    virtual void Unload() override {}
+
+    virtual bool IsWritable() override;
+    virtual bool IsOpened() override;
+
+    // Must not be written through, it may point into a read-only mapping.
+    virtual void* GetData() override;
+
+    virtual uint64_t GetLength() const override;
+    virtual const std::string& GetName() const override;
+
+private:
+    std::string m_VirtualPath = "";
+    Ref<MappedFile> m_Mapping = nullptr;
+    std::vector<uint8_t> m_Buffer;
+    const uint8_t* m_Data = nullptr;
+    uint64_t m_Length = 0;
+
+};
+
+} // namespace aero3d
+
+#endif // AERO3D_IO_MEMORYVFILE_H_
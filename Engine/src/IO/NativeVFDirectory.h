@@ -1,6 +1,9 @@
 #ifndef AERO3D_IO_NATIVEVDIRECTORY_H_
 #define AERO3D_IO_NATIVEVDIRECTORY_H_
 
+#include <shared_mutex>
+#include <unordered_set>
+
 #include "IO/VFDirectory.h"
 
 namespace aero3d {
@@ -12,8 +15,33 @@ public:
     ~NativeVFDirectory() = default;
 
     virtual Ref<VFile> OpenFile(std::string& path) override;
+    virtual Ref<VFile> CreateNewFile(std::string& path) override;
 
     virtual bool FileExists(std::string& path) override;
+    virtual void Enumerate(const std::string& path, bool recursive, std::vector<std::string>& files) override;
+
+    // Once indexed, files created or removed outside the VFS are missed.
+    virtual void BuildIndex() override;
+
+private:
+    // Index keys compare the way the native filesystem resolves paths.
+    struct PathHash
+    {
+        size_t operator()(const std::string& path) const;
+    };
+
+    struct PathEqual
+    {
+        bool operator()(const std::string& a, const std::string& b) const;
+    };
+
+    // Walks the native directory, collecting paths relative to the mount.
+    void Scan(const std::string& path, bool recursive, std::vector<std::string>& files);
+
+private:
+    std::shared_mutex m_IndexMutex;
+    std::unordered_set<std::string, PathHash, PathEqual> m_Index;
+    bool m_Indexed = false;
 
 };
 
@@ -3,18 +3,13 @@
 
 #include <string>
 
+#include "IO/FileHandle.h"
+#include "IO/MappedFile.h"
 #include "IO/VFile.h"
+#include "Utils/Common.h"
 
 namespace aero3d {
 
-#ifdef _WIN32
-    using FileHandle = void*;
-    constexpr FileHandle FILE_HANDLE_NULL = nullptr;
-#else
-    using FileHandle = int;
-    constexpr FileHandle FILE_HANDLE_NULL = -1;
-#endif
-
 class NativeVFile : public VFile
 {
 public:
@@ -22,11 +17,14 @@ public:
     ~NativeVFile();
 
     virtual void ReadBytes(void* buffer, size_t size, size_t start = 0) override;
+    virtual bool ReadRanges(const std::vector<VFileRange>& ranges) override;
     virtual std::string ReadString() override;
 
     virtual void Truncate(size_t pos = 0) override;
     virtual void WriteBytes(void* data, size_t size, size_t start = 0) override;
 
+    // Maps the file instead of reading it, GetData then points into the
+    // page cache. Writing drops the mapping, so Load again afterwards.
     virtual void Load() override;
     virtual void Unload() override;
 
@@ -38,10 +36,16 @@ public:
     virtual uint64_t GetLength() const override;
     virtual const std::string& GetName() const override;
 
+    // For platform readers that submit I/O on the descriptor themselves.
+    FileHandle GetHandle() const { return m_Handle; }
+
 private:
     uint64_t m_Length = 0;
     std::string m_VirtualPath = "";
     FileHandle m_Handle = FILE_HANDLE_NULL;
+    // Files that can't be mapped, e.g. empty ones, are read into m_Buffer.
+    Ref<MappedFile> m_Mapping = nullptr;
+    void* m_Buffer = nullptr;
     void* m_Data = nullptr;
     bool m_Opened = false;
 
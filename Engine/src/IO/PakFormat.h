@@ -0,0 +1,46 @@
+#ifndef AERO3D_IO_PAKFORMAT_H_
+#define AERO3D_IO_PAKFORMAT_H_
+
+#include <cstdint>
+#include <string>
+
+#include "Utils/Hash.h"
+
+namespace aero3d {
+
+constexpr uint32_t PAK_MAGIC = 0x50443341; // "A3DP"
+constexpr uint32_t PAK_VERSION = 1;
+// Entries start aligned so cooked payloads stay aligned inside the mapping.
+constexpr uint64_t PAK_DATA_ALIGNMENT = 16;
+
+// Layout: header, entry data, then the table of contents at tocOffset:
+// entryCount PakEntry sorted by pathHash, followed by the paths they point
+// at. Paths are relative to the archive root and use '/'.
+struct PakHeader
+{
+    uint32_t magic = PAK_MAGIC;
+    uint32_t version = PAK_VERSION;
+    uint32_t entryCount = 0;
+    uint32_t reserved = 0;
+    uint64_t tocOffset = 0;
+    uint64_t tocSize = 0;
+};
+
+struct PakEntry
+{
+    uint64_t pathHash = 0;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    // Into the path table that follows the entries.
+    uint32_t pathOffset = 0;
+    uint32_t pathLength = 0;
+};
+
+inline uint64_t HashPakPath(const std::string& path)
+{
+    return HashFNV1a(path.data(), path.size());
+}
+
+} // namespace aero3d
+
+#endif // AERO3D_IO_PAKFORMAT_H_
@@ -0,0 +1,124 @@
+#include "IO/PakVFDirectory.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "IO/MemoryVFile.h"
+#include "Utils/Log.h"
+
+namespace aero3d {
+
+PakVFDirectory::PakVFDirectory(std::string virtualPath, std::string mountPoint)
+{
+    m_VirtualPath = virtualPath;
+    m_MountPoint = mountPoint;
+
+    Ref<MappedFile> archive = std::make_shared<MappedFile>(mountPoint);
+    if (!archive->IsValid())
+        return;
+
+    PakHeader header;
+    if (archive->GetSize() < sizeof(header))
+    {
+        LogErr(ERROR_INFO, "Pak archive is truncated: %s", mountPoint.c_str());
+        return;
+    }
+    memcpy(&header, archive->GetData(), sizeof(header));
+
+    uint64_t entriesSize = static_cast<uint64_t>(header.entryCount) * sizeof(PakEntry);
+    bool valid =
+        header.magic == PAK_MAGIC && header.version == PAK_VERSION &&
+        header.tocOffset % alignof(PakEntry) == 0 &&
+        header.tocSize >= entriesSize &&
+        header.tocOffset <= archive->GetSize() &&
+        header.tocSize <= archive->GetSize() - header.tocOffset;
+
+    if (!valid)
+    {
+        LogErr(ERROR_INFO, "Invalid pak archive: %s", mountPoint.c_str());
+        return;
+    }
+
+    const uint8_t* toc = archive->GetData() + header.tocOffset;
+    m_Entries = reinterpret_cast<const PakEntry*>(toc);
+    m_EntryCount = header.entryCount;
+    m_Paths = reinterpret_cast<const char*>(toc + entriesSize);
+    m_PathsSize = header.tocSize - entriesSize;
+    m_Archive = archive;
+
+    LogMsg("Mounted pak archive %s with %u files.", mountPoint.c_str(), m_EntryCount);
+}
+
+Ref<VFile> PakVFDirectory::OpenFile(std::string& path)
+{
+    const PakEntry* entry = FindEntry(path);
+    if (!entry)
+    {
+        LogErr(ERROR_INFO, "Failed to open file: %s", path.c_str());
+        return nullptr;
+    }
+
+    if (entry->offset > m_Archive->GetSize() || entry->size > m_Archive->GetSize() - entry->offset)
+    {
+        LogErr(ERROR_INFO, "Pak entry is out of bounds: %s", path.c_str());
+        return nullptr;
+    }
+
+    return std::make_shared<MemoryVFile>(path, m_Archive, m_Archive->GetData() + entry->offset, entry->size);
+}
+
+Ref<VFile> PakVFDirectory::CreateNewFile(std::string& path)
+{
+    LogErr(ERROR_INFO, "Pak archives are read-only: %s", path.c_str());
+    return nullptr;
+}
+
+bool PakVFDirectory::FileExists(std::string& path)
+{
+    return FindEntry(path) != nullptr;
+}
+
+void PakVFDirectory::Enumerate(const std::string& path, bool recursive, std::vector<std::string>& files)
+{
+    std::string dir = AsDirectory(path);
+
+    for (uint32_t i = 0; i < m_EntryCount; i++)
+    {
+        const PakEntry& entry = m_Entries[i];
+        if (static_cast<uint64_t>(entry.pathOffset) + entry.pathLength > m_PathsSize)
+            continue;
+
+        std::string file(m_Paths + entry.pathOffset, entry.pathLength);
+        if (IsInDirectory(file, dir, recursive))
+        {
+            files.push_back(std::move(file));
+        }
+    }
+}
+
+const PakEntry* PakVFDirectory::FindEntry(const std::string& path) const
+{
+    if (!m_Entries)
+        return nullptr;
+
+    uint64_t hash = HashPakPath(path);
+
+    const PakEntry* end = m_Entries + m_EntryCount;
+    const PakEntry* it = std::lower_bound(m_Entries, end, hash,
+        [](const PakEntry& entry, uint64_t value) { return entry.pathHash < value; });
+
+    // Colliding hashes sit next to each other, the path decides.
+    for (; it != end && it->pathHash == hash; ++it)
+    {
+        if (it->pathLength == path.size() &&
+            static_cast<uint64_t>(it->pathOffset) + it->pathLength <= m_PathsSize &&
+            memcmp(m_Paths + it->pathOffset, path.data(), path.size()) == 0)
+        {
+            return it;
+        }
+    }
+
+    return nullptr;
+}
+
+} // namespace aero3d
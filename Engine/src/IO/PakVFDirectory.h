@@ -0,0 +1,39 @@
+#ifndef AERO3D_IO_PAKVFDIRECTORY_H_
+#define AERO3D_IO_PAKVFDIRECTORY_H_
+
+#include "IO/MappedFile.h"
+#include "IO/PakFormat.h"
+#include "IO/VFDirectory.h"
+
+namespace aero3d {
+
+// Read-only directory over a mapped .pak archive. The table of contents is
+// used in place, lookups are a binary search over path hashes, and opened
+// files point straight into the mapping.
+class PakVFDirectory : public VFDirectory
+{
+public:
+    PakVFDirectory(std::string virtualPath, std::string mountPoint);
+    ~PakVFDirectory() = default;
+
+    virtual Ref<VFile> OpenFile(std::string& path) override;
+    virtual Ref<VFile> CreateNewFile(std::string& path) override;
+
+    virtual bool FileExists(std::string& path) override;
+    virtual void Enumerate(const std::string& path, bool recursive, std::vector<std::string>& files) override;
+
+private:
+    const PakEntry* FindEntry(const std::string& path) const;
+
+private:
+    Ref<MappedFile> m_Archive = nullptr;
+    const PakEntry* m_Entries = nullptr;
+    uint32_t m_EntryCount = 0;
+    const char* m_Paths = nullptr;
+    uint64_t m_PathsSize = 0;
+
+};
+
+} // namespace aero3d
+
+#endif // AERO3D_IO_PAKVFDIRECTORY_H_
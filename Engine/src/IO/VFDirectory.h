@@ -23,12 +23,34 @@ public:
     virtual ~VFDirectory() = default;
     
     virtual Ref<VFile> OpenFile(std::string& path) = 0;
+    // Creates the file (and missing parent directories) or truncates it.
+    virtual Ref<VFile> CreateNewFile(std::string& path) = 0;
 
     virtual bool FileExists(std::string& path) = 0;
 
+    // Appends the files under path ("" for the root) to files, relative to
+    // the mount. Subdirectories are descended into when recursive is set.
+    virtual void Enumerate(const std::string& path, bool recursive, std::vector<std::string>& files) = 0;
+
+    // Scans the directory once so later lookups need no syscalls. Archives
+    // index their table of contents on mount and don't need it.
+    virtual void BuildIndex() {}
+
     const std::string& GetMountPoint() const { return m_MountPoint; }
     const std::string& GetVirualPath() const { return m_VirtualPath; }
 
+protected:
+    // Whether file lies in directory dir, which is "" or ends with '/'.
+    static bool IsInDirectory(const std::string& file, const std::string& dir, bool recursive)
+    {
+        return file.starts_with(dir) && (recursive || file.find('/', dir.size()) == std::string::npos);
+    }
+
+    static std::string AsDirectory(const std::string& path)
+    {
+        return path.empty() || path.back() == '/' ? path : path + '/';
+    }
+
 protected:
     std::string m_MountPoint = "";
     std::string m_VirtualPath = "";
@@ -1,8 +1,12 @@
 #include "IO/VFS.h"
 
+#include <algorithm>
 #include <memory>
+#include <unordered_set>
 
 #include "IO/NativeVFDirectory.h"
+#include "IO/PakVFDirectory.h"
+#include "IO/ZipVFDirectory.h"
 #include "Utils/Common.h"
 #include "Utils/Assert.h"
 #include "Utils/Log.h"
@@ -12,42 +16,385 @@ namespace aero3d {
 std::vector<Scope<VFDirectory>> VFS::s_Dirs = {};
 Scope<VFDirectory> VFS::s_DefaultDir = std::make_unique<NativeVFDirectory>("", "");
 
+std::shared_mutex VFS::s_PathMutex;
+std::unordered_map<std::string, VFSPath> VFS::s_PathIds = {};
+std::deque<std::string> VFS::s_Paths = {};
+std::deque<VFS::ResolvedPath> VFS::s_Resolved = {};
+// Starts past the default generation so new entries begin stale.
+uint64_t VFS::s_MountGeneration = 1;
+
+std::mutex VFS::s_LookupMutex;
+VFS::LookupList VFS::s_Lookups = {};
+std::unordered_map<std::string_view, VFS::LookupList::iterator> VFS::s_LookupIndex = {};
+
+Scope<AsyncFileReader> VFS::s_AsyncReader = nullptr;
+std::mutex VFS::s_AsyncReaderMutex;
+
 void VFS::Mount(std::string virtualPath, std::string mountPoint, DirType type, bool appendToFront)
 {
+    Scope<VFDirectory> dir = nullptr;
+
     switch (type)
     {
-    case DirType::NATIVE:
+    case DirType::NATIVE: dir = std::make_unique<NativeVFDirectory>(virtualPath, mountPoint); break;
+    case DirType::PAK: dir = std::make_unique<PakVFDirectory>(virtualPath, mountPoint); break;
+    case DirType::ZIP: dir = std::make_unique<ZipVFDirectory>(virtualPath, mountPoint); break;
+    default: Assert(ERROR_INFO, false, "Unknown DirType!"); return;
+    }
+
+    dir->BuildIndex();
+
+    std::unique_lock<std::shared_mutex> lock(s_PathMutex);
+
+    if (appendToFront)
+    {
+        s_Dirs.insert(s_Dirs.begin(), std::move(dir));
+    }
+    else
+    {
+        s_Dirs.emplace_back(std::move(dir));
+    }
+
+    s_MountGeneration++;
+}
+
+VFSPath VFS::InternPath(const std::string& path)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(s_PathMutex);
+        auto it = s_PathIds.find(path);
+        if (it != s_PathIds.end())
+            return it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(s_PathMutex);
+
+    auto [it, inserted] = s_PathIds.try_emplace(path, static_cast<VFSPath>(s_Paths.size()));
+    if (inserted)
     {
-        if (appendToFront)
+        s_Paths.push_back(path);
+        s_Resolved.emplace_back();
+    }
+
+    return it->second;
+}
+
+VFSPath VFS::FindPath(const std::string& path)
+{
+    std::shared_lock<std::shared_mutex> lock(s_PathMutex);
+    auto it = s_PathIds.find(path);
+    return it != s_PathIds.end() ? it->second : INVALID_VFS_PATH;
+}
+
+const std::string& VFS::GetPath(VFSPath path)
+{
+    std::shared_lock<std::shared_mutex> lock(s_PathMutex);
+    Assert(ERROR_INFO, path < s_Paths.size(), "Invalid VFS path handle!");
+    return s_Paths[path];
+}
+
+Ref<VFile> VFS::ReadFile(std::string path)
+{
+    ResolvedPath resolved = Resolve(path);
+    std::string subPath = path.substr(resolved.prefixLength);
+    return resolved.dir->OpenFile(subPath);
+}
+
+Ref<VFile> VFS::ReadFile(VFSPath path)
+{
+    if (path == INVALID_VFS_PATH)
+        return nullptr;
+
+    ResolvedPath resolved = Resolve(path);
+    std::string subPath = GetPath(path).substr(resolved.prefixLength);
+    return resolved.dir->OpenFile(subPath);
+}
+
+bool VFS::WriteFile(std::string path, const void* data, size_t size)
+{
+    VFDirectory* target = s_DefaultDir.get();
+    std::string subPath = path;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(s_PathMutex);
+        for (const auto& dir : s_Dirs)
+        {
+            const std::string& dirVirtualPath = dir->GetVirualPath();
+            if (path.starts_with(dirVirtualPath))
+            {
+                target = dir.get();
+                subPath = path.substr(dirVirtualPath.length());
+                break;
+            }
+        }
+    }
+
+    Ref<VFile> file = target->CreateNewFile(subPath);
+
+    // The file may now shadow another mount or exist where it didn't before.
+    Invalidate(path);
+
+    if (!file || !file->IsOpened())
+        return false;
+
+    if (size > 0)
+    {
+        file->WriteBytes(const_cast<void*>(data), size);
+    }
+
+    return file->GetLength() == size;
+}
+
+bool VFS::FileExists(std::string path)
+{
+    return Resolve(path).exists;
+}
+
+bool VFS::FileExists(VFSPath path)
+{
+    if (path == INVALID_VFS_PATH)
+        return false;
+
+    return Resolve(path).exists;
+}
+
+std::vector<std::string> VFS::Enumerate(const std::string& path, bool recursive)
+{
+    std::string virtualDir = path.empty() || path.back() == '/' ? path : path + '/';
+
+    std::vector<std::string> result;
+    std::unordered_set<std::string> seen;
+
+    std::shared_lock<std::shared_mutex> lock(s_PathMutex);
+
+    for (const auto& dir : s_Dirs)
+    {
+        const std::string& dirVirtualPath = dir->GetVirualPath();
+
+        std::vector<std::string> files;
+        if (virtualDir.starts_with(dirVirtualPath))
+        {
+            dir->Enumerate(virtualDir.substr(dirVirtualPath.length()), recursive, files);
+        }
+        else if (dirVirtualPath.starts_with(virtualDir))
         {
-            s_Dirs.insert(s_Dirs.begin(), std::make_unique<NativeVFDirectory>(virtualPath, mountPoint));
+            // The mount lies below the listed directory.
+            dir->Enumerate("", true, files);
+        }
+
+        for (std::string& file : files)
+        {
+            std::string virtualFile = dirVirtualPath + file;
+            if (!virtualFile.starts_with(virtualDir))
+                continue;
+            if (!recursive && virtualFile.find('/', virtualDir.length()) != std::string::npos)
+                continue;
+
+            if (seen.insert(virtualFile).second)
+            {
+                result.push_back(std::move(virtualFile));
+            }
         }
-        else
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+VFS::ResolvedPath VFS::Resolve(VFSPath path)
+{
+    ResolvedPath resolved;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(s_PathMutex);
+        Assert(ERROR_INFO, path < s_Resolved.size(), "Invalid VFS path handle!");
+
+        if (s_Resolved[path].generation == s_MountGeneration)
+            return s_Resolved[path];
+
+        resolved = Walk(s_Paths[path]);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(s_PathMutex);
+
+    // Dropped if a Mount raced with the walk, the next lookup redoes it.
+    if (resolved.generation == s_MountGeneration)
+    {
+        s_Resolved[path] = resolved;
+    }
+
+    return resolved;
+}
+
+VFS::ResolvedPath VFS::Resolve(const std::string& path)
+{
+    VFSPath handle = FindPath(path);
+    if (handle != INVALID_VFS_PATH)
+        return Resolve(handle);
+
+    std::shared_lock<std::shared_mutex> lock(s_PathMutex);
+
+    {
+        std::lock_guard<std::mutex> lookupLock(s_LookupMutex);
+        auto it = s_LookupIndex.find(path);
+        if (it != s_LookupIndex.end() && it->second->second.generation == s_MountGeneration)
         {
-            s_Dirs.emplace_back(std::make_unique<NativeVFDirectory>(virtualPath, mountPoint));
+            s_Lookups.splice(s_Lookups.end(), s_Lookups, it->second);
+            return it->second->second;
         }
-        break;
     }
-    default: Assert(ERROR_INFO, false, "Unknown DirType!");
+
+    // Walked without the lookup lock, other threads may resolve meanwhile.
+    ResolvedPath resolved = Walk(path);
+
+    std::lock_guard<std::mutex> lookupLock(s_LookupMutex);
+
+    auto it = s_LookupIndex.find(path);
+    if (it != s_LookupIndex.end())
+    {
+        it->second->second = resolved;
+        s_Lookups.splice(s_Lookups.end(), s_Lookups, it->second);
+        return resolved;
+    }
+
+    if (s_Lookups.size() >= MAX_CACHED_LOOKUPS)
+    {
+        s_LookupIndex.erase(s_Lookups.front().first);
+        s_Lookups.pop_front();
     }
+
+    s_Lookups.emplace_back(path, resolved);
+    s_LookupIndex.emplace(s_Lookups.back().first, std::prev(s_Lookups.end()));
+    return resolved;
 }
 
-Ref<VFile> VFS::ReadFile(std::string path)
+VFS::ResolvedPath VFS::Walk(const std::string& path)
 {
+    // Mounts only change under the exclusive lock, so the walk sees a
+    // consistent list. Directories are never unmounted.
+    ResolvedPath resolved;
+    resolved.dir = s_DefaultDir.get();
+    resolved.generation = s_MountGeneration;
+
     for (const auto& dir : s_Dirs)
     {
-        std::string dirVirtualPath = dir->GetVirualPath();
+        const std::string& dirVirtualPath = dir->GetVirualPath();
         if (path.starts_with(dirVirtualPath))
         {
             std::string subPath = path.substr(dirVirtualPath.length());
             if (dir->FileExists(subPath))
             {
-                return dir->OpenFile(subPath);
+                resolved.dir = dir.get();
+                resolved.prefixLength = dirVirtualPath.length();
+                resolved.exists = true;
+                return resolved;
             }
         }
     }
 
-    return s_DefaultDir->OpenFile(path);
+    std::string subPath = path;
+    resolved.exists = s_DefaultDir->FileExists(subPath);
+    return resolved;
+}
+
+void VFS::Invalidate(const std::string& path)
+{
+    std::unique_lock<std::shared_mutex> lock(s_PathMutex);
+
+    auto handle = s_PathIds.find(path);
+    if (handle != s_PathIds.end())
+    {
+        s_Resolved[handle->second].generation = 0;
+    }
+
+    std::lock_guard<std::mutex> lookupLock(s_LookupMutex);
+    auto it = s_LookupIndex.find(path);
+    if (it != s_LookupIndex.end())
+    {
+        LookupList::iterator entry = it->second;
+        s_LookupIndex.erase(it);
+        s_Lookups.erase(entry);
+    }
+}
+
+void VFS::ReadFileAsync(const std::string& path, VFSReadCallback callback)
+{
+    ReadMany({ path }, std::move(callback));
+}
+
+std::future<VFSReadResult> VFS::ReadFileAsync(const std::string& path)
+{
+    // std::function needs a copyable callable.
+    auto promise = std::make_shared<std::promise<VFSReadResult>>();
+    std::future<VFSReadResult> future = promise->get_future();
+
+    ReadFileAsync(path, [promise](VFSReadResult&& result)
+    {
+        promise->set_value(std::move(result));
+    });
+
+    return future;
+}
+
+void VFS::ReadMany(const std::vector<std::string>& paths, VFSReadCallback callback)
+{
+    std::vector<Scope<AsyncReadRequest>> requests;
+    requests.reserve(paths.size());
+
+    for (const std::string& path : paths)
+    {
+        Ref<VFile> file = ReadFile(path);
+        if (!file || !file->IsOpened())
+        {
+            LogErr(ERROR_INFO, "Failed to open file for reading: %s", path.c_str());
+
+            VFSReadResult result;
+            result.path = path;
+            callback(std::move(result));
+            continue;
+        }
+
+        Scope<AsyncReadRequest> request = std::make_unique<AsyncReadRequest>();
+        request->file = file;
+        request->result.path = path;
+        request->callback = callback;
+        requests.push_back(std::move(request));
+    }
+
+    if (!requests.empty())
+    {
+        SubmitReads(requests);
+    }
+}
+
+void VFS::Shutdown()
+{
+    // Flushed without the lock, callbacks may submit follow-up reads. Those
+    // land in a new reader, which the next iteration drains.
+    while (true)
+    {
+        Scope<AsyncFileReader> reader = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(s_AsyncReaderMutex);
+            reader = std::move(s_AsyncReader);
+        }
+
+        if (!reader)
+            break;
+
+        reader->Flush();
+    }
+}
+
+void VFS::SubmitReads(std::vector<Scope<AsyncReadRequest>>& requests)
+{
+    std::lock_guard<std::mutex> lock(s_AsyncReaderMutex);
+    if (!s_AsyncReader)
+    {
+        s_AsyncReader = AsyncFileReader::Create();
+    }
+
+    s_AsyncReader->Submit(requests);
 }
 
 } // namespace aero3d
\ No newline at end of file
@@ -1,27 +1,107 @@
 #ifndef AERO3D_IO_VFS_H_
 #define AERO3D_IO_VFS_H_
 
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <list>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 
+#include "IO/AsyncFileReader.h"
 #include "IO/VFDirectory.h"
 #include "IO/VFile.h"
 #include "Utils/Common.h"
 
 namespace aero3d {
 
+// Interned virtual path. Lookups through it skip hashing the string.
+using VFSPath = uint32_t;
+
+constexpr VFSPath INVALID_VFS_PATH = UINT32_MAX;
+
+// Native mounts are indexed once and resolved paths are cached until the
+// next Mount. Files created or removed behind the VFS's back may be missed.
 class VFS {
 public:
     static void Mount(std::string virtualPath, std::string mounPoint, 
         DirType type = DirType::NATIVE, bool appendToFront = false);
 
+    // Handles stay valid for the lifetime of the process. Interned paths
+    // keep their resolution for good, other string lookups only land in a
+    // bounded cache of recent paths.
+    static VFSPath InternPath(const std::string& path);
+    static const std::string& GetPath(VFSPath path);
+
     static Ref<VFile> ReadFile(std::string path);
+    static Ref<VFile> ReadFile(VFSPath path);
+    static bool WriteFile(std::string path, const void* data, size_t size);
+    static bool FileExists(std::string path);
+    static bool FileExists(VFSPath path);
+
+    // Lists the files under a virtual directory across all mounts, sorted.
+    // Earlier mounts shadow later ones. The unmounted working directory is
+    // not listed. Feed the result to ReadMany to prefetch a folder.
+    static std::vector<std::string> Enumerate(const std::string& path, bool recursive = false);
+
+    // Reads the whole file without blocking. The callback runs on an I/O or
+    // job thread, also when the file can't be opened.
+    static void ReadFileAsync(const std::string& path, VFSReadCallback callback);
+    static std::future<VFSReadResult> ReadFileAsync(const std::string& path);
+    // Submits all reads as one batch, the callback runs once per path.
+    static void ReadMany(const std::vector<std::string>& paths, VFSReadCallback callback);
+
+    // Waits for pending asynchronous reads and releases the reader.
+    static void Shutdown();
+
+private:
+    struct ResolvedPath
+    {
+        VFDirectory* dir = nullptr;
+        // Length of the mount's virtual path, the rest is the path inside it.
+        size_t prefixLength = 0;
+        bool exists = false;
+        // The entry is stale unless it matches s_MountGeneration.
+        uint64_t generation = 0;
+    };
+
+    // INVALID_VFS_PATH when the path was never interned.
+    static VFSPath FindPath(const std::string& path);
+    static ResolvedPath Resolve(VFSPath path);
+    static ResolvedPath Resolve(const std::string& path);
+    // Resolves against the mounts. s_PathMutex must be held.
+    static ResolvedPath Walk(const std::string& path);
+    static void Invalidate(const std::string& path);
+
+    static void SubmitReads(std::vector<Scope<AsyncReadRequest>>& requests);
 
 private:
     static std::vector<Scope<VFDirectory>> s_Dirs;
     static Scope<VFDirectory> s_DefaultDir;
 
+    // Guards the mounts and the path tables. Deques keep references stable.
+    static std::shared_mutex s_PathMutex;
+    static std::unordered_map<std::string, VFSPath> s_PathIds;
+    static std::deque<std::string> s_Paths;
+    static std::deque<ResolvedPath> s_Resolved;
+    static uint64_t s_MountGeneration;
+
+    // Least recently used string lookups go first. Taken after s_PathMutex.
+    static constexpr size_t MAX_CACHED_LOOKUPS = 1024;
+    using LookupList = std::list<std::pair<std::string, ResolvedPath>>;
+    static std::mutex s_LookupMutex;
+    static LookupList s_Lookups;
+    // Keys view the strings owned by s_Lookups.
+    static std::unordered_map<std::string_view, LookupList::iterator> s_LookupIndex;
+
+    static Scope<AsyncFileReader> s_AsyncReader;
+    static std::mutex s_AsyncReaderMutex;
+
 };
 
 } // namespace aero3d
@@ -3,15 +3,28 @@
 
 #include <string>
 #include <cstdint>
+#include <vector>
 
 namespace aero3d {
 
+struct VFileRange
+{
+    void* buffer = nullptr;
+    size_t size = 0;
+    uint64_t start = 0;
+};
+
+// Reads are positional and don't touch shared state, so one file may be
+// read from several threads at once. Writes are not synchronized.
 class VFile
 {
 public:
     virtual ~VFile() = default;
 
     virtual void ReadBytes(void* buffer, size_t size, size_t start = 0) = 0;
+    // Scatter read, ranges that follow each other in the file are read with
+    // one call. False if any range could not be read completely.
+    virtual bool ReadRanges(const std::vector<VFileRange>& ranges) = 0;
     virtual std::string ReadString() = 0;
 
     virtual void Truncate(size_t pos = 0) = 0;
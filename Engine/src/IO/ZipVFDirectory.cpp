@@ -0,0 +1,245 @@
+#include "IO/ZipVFDirectory.h"
+
+#include <cstring>
+#include <vector>
+
+#include <zlib.h>
+
+#include "IO/MemoryVFile.h"
+#include "Utils/Log.h"
+
+namespace aero3d {
+
+constexpr uint32_t ZIP_LOCAL_HEADER_SIGNATURE = 0x04034b50;
+constexpr uint32_t ZIP_CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+constexpr uint32_t ZIP_END_OF_CENTRAL_DIR_SIGNATURE = 0x06054b50;
+
+constexpr uint64_t ZIP_LOCAL_HEADER_SIZE = 30;
+constexpr uint64_t ZIP_CENTRAL_HEADER_SIZE = 46;
+constexpr uint64_t ZIP_END_OF_CENTRAL_DIR_SIZE = 22;
+constexpr uint64_t ZIP_MAX_COMMENT_SIZE = 0xFFFF;
+
+constexpr uint16_t ZIP_METHOD_STORED = 0;
+constexpr uint16_t ZIP_METHOD_DEFLATED = 8;
+constexpr uint16_t ZIP_FLAG_ENCRYPTED = 1 << 0;
+
+static uint16_t ReadU16(const uint8_t* data)
+{
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+static uint32_t ReadU32(const uint8_t* data)
+{
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+        (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+ZipVFDirectory::ZipVFDirectory(std::string virtualPath, std::string mountPoint)
+{
+    m_VirtualPath = virtualPath;
+    m_MountPoint = mountPoint;
+
+    Ref<MappedFile> archive = std::make_shared<MappedFile>(mountPoint);
+    if (!archive->IsValid())
+        return;
+
+    m_Archive = archive;
+    if (!ReadCentralDirectory())
+    {
+        LogErr(ERROR_INFO, "Invalid zip archive: %s", mountPoint.c_str());
+        m_Entries.clear();
+        m_Archive = nullptr;
+        return;
+    }
+
+    LogMsg("Mounted zip archive %s with %zu files.", mountPoint.c_str(), m_Entries.size());
+}
+
+Ref<VFile> ZipVFDirectory::OpenFile(std::string& path)
+{
+    auto it = m_Entries.find(path);
+    if (it == m_Entries.end())
+    {
+        LogErr(ERROR_INFO, "Failed to open file: %s", path.c_str());
+        return nullptr;
+    }
+
+    const Entry& entry = it->second;
+    const uint8_t* archive = m_Archive->GetData();
+    uint64_t archiveSize = m_Archive->GetSize();
+
+    // The local header repeats the name but may carry different extra data.
+    if (entry.localHeaderOffset + ZIP_LOCAL_HEADER_SIZE > archiveSize ||
+        ReadU32(archive + entry.localHeaderOffset) != ZIP_LOCAL_HEADER_SIGNATURE)
+    {
+        LogErr(ERROR_INFO, "Corrupt zip entry: %s", path.c_str());
+        return nullptr;
+    }
+
+    const uint8_t* local = archive + entry.localHeaderOffset;
+    uint64_t dataOffset = entry.localHeaderOffset + ZIP_LOCAL_HEADER_SIZE + ReadU16(local + 26) + ReadU16(local + 28);
+
+    if (dataOffset > archiveSize || entry.compressedSize > archiveSize - dataOffset)
+    {
+        LogErr(ERROR_INFO, "Zip entry is out of bounds: %s", path.c_str());
+        return nullptr;
+    }
+
+    const uint8_t* data = archive + dataOffset;
+
+    if (entry.method == ZIP_METHOD_STORED)
+    {
+        if (entry.size != entry.compressedSize)
+        {
+            LogErr(ERROR_INFO, "Corrupt zip entry: %s", path.c_str());
+            return nullptr;
+        }
+        return std::make_shared<MemoryVFile>(path, m_Archive, data, entry.size);
+    }
+
+    std::vector<uint8_t> buffer(entry.size);
+
+    z_stream stream{};
+    // Negative window bits: raw deflate, zip has no zlib header.
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+    {
+        LogErr(ERROR_INFO, "Failed to initialize inflate for: %s", path.c_str());
+        return nullptr;
+    }
+
+    stream.next_in = const_cast<Bytef*>(data);
+    stream.avail_in = static_cast<uInt>(entry.compressedSize);
+    stream.next_out = buffer.data();
+    stream.avail_out = static_cast<uInt>(buffer.size());
+
+    int result = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+
+    if (result != Z_STREAM_END || stream.total_out != entry.size)
+    {
+        LogErr(ERROR_INFO, "Failed to inflate zip entry: %s", path.c_str());
+        return nullptr;
+    }
+
+    return std::make_shared<MemoryVFile>(path, std::move(buffer));
+}
+
+Ref<VFile> ZipVFDirectory::CreateNewFile(std::string& path)
+{
+    LogErr(ERROR_INFO, "Zip archives are read-only: %s", path.c_str());
+    return nullptr;
+}
+
+bool ZipVFDirectory::FileExists(std::string& path)
+{
+    return m_Entries.find(path) != m_Entries.end();
+}
+
+void ZipVFDirectory::Enumerate(const std::string& path, bool recursive, std::vector<std::string>& files)
+{
+    std::string dir = AsDirectory(path);
+
+    for (const auto& [file, entry] : m_Entries)
+    {
+        if (IsInDirectory(file, dir, recursive))
+        {
+            files.push_back(file);
+        }
+    }
+}
+
+bool ZipVFDirectory::ReadCentralDirectory()
+{
+    const uint8_t* archive = m_Archive->GetData();
+    uint64_t archiveSize = m_Archive->GetSize();
+
+    if (archiveSize < ZIP_END_OF_CENTRAL_DIR_SIZE)
+        return false;
+
+    // The end record sits behind a comment of unknown length.
+    uint64_t searchEnd = archiveSize - ZIP_END_OF_CENTRAL_DIR_SIZE;
+    uint64_t searchStart = searchEnd > ZIP_MAX_COMMENT_SIZE ? searchEnd - ZIP_MAX_COMMENT_SIZE : 0;
+
+    const uint8_t* end = nullptr;
+    for (uint64_t offset = searchEnd + 1; offset-- > searchStart; )
+    {
+        if (ReadU32(archive + offset) == ZIP_END_OF_CENTRAL_DIR_SIGNATURE)
+        {
+            end = archive + offset;
+            break;
+        }
+    }
+
+    if (!end)
+        return false;
+
+    uint16_t entryCount = ReadU16(end + 10);
+    uint64_t directorySize = ReadU32(end + 12);
+    uint64_t directoryOffset = ReadU32(end + 16);
+
+    if (entryCount == 0xFFFF || directoryOffset == 0xFFFFFFFF)
+    {
+        LogErr(ERROR_INFO, "ZIP64 archives are not supported: %s", m_MountPoint.c_str());
+        return false;
+    }
+
+    if (directoryOffset + directorySize > archiveSize)
+        return false;
+
+    m_Entries.reserve(entryCount);
+
+    uint64_t offset = directoryOffset;
+    for (uint16_t i = 0; i < entryCount; i++)
+    {
+        if (offset + ZIP_CENTRAL_HEADER_SIZE > directoryOffset + directorySize)
+            return false;
+
+        const uint8_t* header = archive + offset;
+        if (ReadU32(header) != ZIP_CENTRAL_HEADER_SIGNATURE)
+            return false;
+
+        uint16_t flags = ReadU16(header + 8);
+        uint16_t nameLength = ReadU16(header + 28);
+        uint16_t extraLength = ReadU16(header + 30);
+        uint16_t commentLength = ReadU16(header + 32);
+
+        if (offset + ZIP_CENTRAL_HEADER_SIZE + nameLength > directoryOffset + directorySize)
+            return false;
+
+        std::string name(reinterpret_cast<const char*>(header + ZIP_CENTRAL_HEADER_SIZE), nameLength);
+
+        Entry entry;
+        entry.method = ReadU16(header + 10);
+        entry.compressedSize = ReadU32(header + 20);
+        entry.size = ReadU32(header + 24);
+        entry.localHeaderOffset = ReadU32(header + 42);
+
+        offset += ZIP_CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+
+        // Directories only exist as name prefixes.
+        if (name.empty() || name.back() == '/')
+            continue;
+
+        if (flags & ZIP_FLAG_ENCRYPTED)
+        {
+            LogErr(ERROR_INFO, "Skipping encrypted zip entry: %s", name.c_str());
+            continue;
+        }
+        if (entry.method != ZIP_METHOD_STORED && entry.method != ZIP_METHOD_DEFLATED)
+        {
+            LogErr(ERROR_INFO, "Skipping zip entry with unsupported compression %u: %s", entry.method, name.c_str());
+            continue;
+        }
+        if (entry.size == 0xFFFFFFFF || entry.compressedSize == 0xFFFFFFFF || entry.localHeaderOffset == 0xFFFFFFFF)
+        {
+            LogErr(ERROR_INFO, "Skipping ZIP64 entry: %s", name.c_str());
+            continue;
+        }
+
+        m_Entries.emplace(std::move(name), entry);
+    }
+
+    return true;
+}
+
+} // namespace aero3d
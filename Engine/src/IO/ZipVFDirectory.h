@@ -0,0 +1,46 @@
+#ifndef AERO3D_IO_ZIPVFDIRECTORY_H_
+#define AERO3D_IO_ZIPVFDIRECTORY_H_
+
+#include <unordered_map>
+
+#include "IO/MappedFile.h"
+#include "IO/VFDirectory.h"
+
+namespace aero3d {
+
+// Read-only directory over a mapped .zip archive. The central directory is
+// indexed once on mount. Stored entries point straight into the mapping,
+// deflated ones are inflated into their own buffer on open. ZIP64 and
+// encrypted entries are not supported.
+class ZipVFDirectory : public VFDirectory
+{
+public:
+    ZipVFDirectory(std::string virtualPath, std::string mountPoint);
+    ~ZipVFDirectory() = default;
+
+    virtual Ref<VFile> OpenFile(std::string& path) override;
+    virtual Ref<VFile> CreateNewFile(std::string& path) override;
+
+    virtual bool FileExists(std::string& path) override;
+    virtual void Enumerate(const std::string& path, bool recursive, std::vector<std::string>& files) override;
+
+private:
+    struct Entry
+    {
+        uint64_t localHeaderOffset = 0;
+        uint64_t compressedSize = 0;
+        uint64_t size = 0;
+        uint16_t method = 0;
+    };
+
+    bool ReadCentralDirectory();
+
+private:
+    Ref<MappedFile> m_Archive = nullptr;
+    std::unordered_map<std::string, Entry> m_Entries;
+
+};
+
+} // namespace aero3d
+
+#endif // AERO3D_IO_ZIPVFDIRECTORY_H_
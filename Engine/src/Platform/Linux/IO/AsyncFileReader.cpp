@@ -0,0 +1,391 @@
+#include "IO/AsyncFileReader.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "IO/NativeVFile.h"
+#include "Utils/Log.h"
+
+namespace aero3d {
+
+constexpr uint32_t IO_URING_QUEUE_DEPTH = 256;
+// readv lengths are 32-bit, larger files are read in pieces.
+constexpr size_t IO_URING_MAX_READ = 1u << 30;
+// user_data of the no-op that wakes the completion thread on shutdown.
+constexpr uint64_t IO_URING_WAKE = 0;
+
+static int IoUringSetup(uint32_t entries, io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int IoUringEnter(int ringFd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+// One submission and completion ring driven by raw syscalls, so there is no
+// liburing dependency. Any thread submits, a single thread reaps the
+// completions, continues short reads and runs the callbacks. Files that are
+// not native, e.g. archive entries, go to the job system.
+class IoUringFileReader : public AsyncFileReader
+{
+public:
+    IoUringFileReader() = default;
+    ~IoUringFileReader();
+
+    bool Init();
+
+    virtual void Submit(std::vector<Scope<AsyncReadRequest>>& requests) override;
+    virtual void Flush() override;
+
+private:
+    struct Read
+    {
+        Scope<AsyncReadRequest> request;
+        int fd = -1;
+        uint64_t offset = 0;
+        iovec iov = {};
+    };
+
+    // Both expect m_Mutex to be held.
+    void QueueRead(Read* read);
+    void SubmitQueued();
+
+    void CompletionLoop();
+    void Finish(Read* read, bool success);
+
+private:
+    int m_RingFd = -1;
+
+    void* m_SqRing = nullptr;
+    void* m_CqRing = nullptr;
+    size_t m_SqRingSize = 0;
+    size_t m_CqRingSize = 0;
+    io_uring_sqe* m_Sqes = nullptr;
+    uint32_t m_SqEntries = 0;
+
+    uint32_t* m_SqTail = nullptr;
+    uint32_t* m_SqMask = nullptr;
+    uint32_t* m_SqArray = nullptr;
+    uint32_t* m_CqHead = nullptr;
+    uint32_t* m_CqTail = nullptr;
+    uint32_t* m_CqMask = nullptr;
+    io_uring_cqe* m_Cqes = nullptr;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_IdleCondition;
+    // Waiting for a free submission slot.
+    std::deque<Read*> m_Backlog;
+    uint32_t m_InFlight = 0;
+    uint32_t m_Pending = 0;
+    bool m_Stopping = false;
+
+    std::thread m_CompletionThread;
+    JobFileReader m_Fallback;
+
+};
+
+bool IoUringFileReader::Init()
+{
+    io_uring_params params{};
+    m_RingFd = IoUringSetup(IO_URING_QUEUE_DEPTH, &params);
+    if (m_RingFd < 0)
+    {
+        LogMsg("io_uring is unavailable (errno %d), reading files on the job system.", errno);
+        return false;
+    }
+
+    m_SqEntries = params.sq_entries;
+    m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap)
+    {
+        m_SqRingSize = m_CqRingSize = std::max(m_SqRingSize, m_CqRingSize);
+    }
+
+    m_SqRing = mmap(nullptr, m_SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        m_RingFd, IORING_OFF_SQ_RING);
+    m_CqRing = singleMmap ? m_SqRing : mmap(nullptr, m_CqRingSize, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, m_RingFd, IORING_OFF_CQ_RING);
+    void* sqes = mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, m_RingFd, IORING_OFF_SQES);
+
+    if (m_SqRing == MAP_FAILED || m_CqRing == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        LogErr(ERROR_INFO, "Failed to map io_uring rings, errno: %d (%s)", errno, strerror(errno));
+        if (sqes != MAP_FAILED) munmap(sqes, params.sq_entries * sizeof(io_uring_sqe));
+        if (m_CqRing != MAP_FAILED && m_CqRing != m_SqRing) munmap(m_CqRing, m_CqRingSize);
+        if (m_SqRing != MAP_FAILED) munmap(m_SqRing, m_SqRingSize);
+        m_SqRing = m_CqRing = nullptr;
+        close(m_RingFd);
+        m_RingFd = -1;
+        return false;
+    }
+
+    uint8_t* sq = static_cast<uint8_t*>(m_SqRing);
+    uint8_t* cq = static_cast<uint8_t*>(m_CqRing);
+
+    m_Sqes = static_cast<io_uring_sqe*>(sqes);
+    m_SqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+    m_SqMask = reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+    m_SqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+    m_CqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+    m_CqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+    m_CqMask = reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+    m_Cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    m_CompletionThread = std::thread(&IoUringFileReader::CompletionLoop, this);
+    return true;
+}
+
+IoUringFileReader::~IoUringFileReader()
+{
+    if (m_RingFd < 0)
+        return;
+
+    Flush();
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+
+        uint32_t tail = *m_SqTail;
+        uint32_t index = tail & *m_SqMask;
+
+        io_uring_sqe& sqe = m_Sqes[index];
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_NOP;
+        sqe.user_data = IO_URING_WAKE;
+
+        m_SqArray[index] = index;
+        __atomic_store_n(m_SqTail, tail + 1, __ATOMIC_RELEASE);
+        IoUringEnter(m_RingFd, 1, 0, 0);
+    }
+
+    m_CompletionThread.join();
+
+    munmap(m_Sqes, m_SqEntries * sizeof(io_uring_sqe));
+    if (m_CqRing != m_SqRing) munmap(m_CqRing, m_CqRingSize);
+    munmap(m_SqRing, m_SqRingSize);
+    close(m_RingFd);
+}
+
+void IoUringFileReader::Submit(std::vector<Scope<AsyncReadRequest>>& requests)
+{
+    std::vector<Scope<AsyncReadRequest>> fallback;
+    std::vector<Read*> empty;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        for (auto& request : requests)
+        {
+            NativeVFile* native = dynamic_cast<NativeVFile*>(request->file.get());
+            if (!native)
+            {
+                fallback.push_back(std::move(request));
+                continue;
+            }
+
+            Read* read = new Read();
+            read->fd = native->GetHandle();
+            read->request = std::move(request);
+            read->request->result.data.resize(static_cast<size_t>(read->request->file->GetLength()));
+
+            m_Pending++;
+            if (read->request->result.data.empty())
+            {
+                empty.push_back(read);
+                continue;
+            }
+
+            // Behind anything already waiting for a slot.
+            m_Backlog.push_back(read);
+        }
+
+        SubmitQueued();
+    }
+    requests.clear();
+
+    for (Read* read : empty)
+    {
+        Finish(read, true);
+    }
+
+    if (!fallback.empty())
+    {
+        m_Fallback.Submit(fallback);
+    }
+}
+
+void IoUringFileReader::Flush()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_IdleCondition.wait(lock, [this]() { return m_Pending == 0; });
+    }
+    m_Fallback.Flush();
+}
+
+void IoUringFileReader::QueueRead(Read* read)
+{
+    std::vector<uint8_t>& data = read->request->result.data;
+    read->iov.iov_base = data.data() + read->offset;
+    read->iov.iov_len = std::min<size_t>(data.size() - read->offset, IO_URING_MAX_READ);
+
+    if (m_InFlight >= m_SqEntries)
+    {
+        m_Backlog.push_back(read);
+        return;
+    }
+
+    uint32_t tail = *m_SqTail;
+    uint32_t index = tail & *m_SqMask;
+
+    io_uring_sqe& sqe = m_Sqes[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_READV;
+    sqe.fd = read->fd;
+    sqe.off = read->offset;
+    sqe.addr = reinterpret_cast<uint64_t>(&read->iov);
+    sqe.len = 1;
+    sqe.user_data = reinterpret_cast<uint64_t>(read);
+
+    m_SqArray[index] = index;
+    // The kernel may look at the entry as soon as it sees the new tail.
+    __atomic_store_n(m_SqTail, tail + 1, __ATOMIC_RELEASE);
+    m_InFlight++;
+}
+
+void IoUringFileReader::SubmitQueued()
+{
+    while (!m_Backlog.empty() && m_InFlight < m_SqEntries)
+    {
+        Read* read = m_Backlog.front();
+        m_Backlog.pop_front();
+        QueueRead(read);
+    }
+
+    // The kernel consumes everything up to the tail, the count only has to
+    // be large enough.
+    int result;
+    do
+    {
+        result = IoUringEnter(m_RingFd, m_SqEntries, 0, 0);
+    } while (result < 0 && errno == EINTR);
+}
+
+void IoUringFileReader::CompletionLoop()
+{
+    std::vector<std::pair<Read*, bool>> finished;
+
+    while (true)
+    {
+        int result = IoUringEnter(m_RingFd, 0, 1, IORING_ENTER_GETEVENTS);
+        if (result < 0 && errno != EINTR)
+        {
+            LogErr(ERROR_INFO, "io_uring_enter failed, errno: %d (%s)", errno, strerror(errno));
+        }
+
+        bool wake = false;
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            uint32_t head = *m_CqHead;
+            uint32_t tail = __atomic_load_n(m_CqTail, __ATOMIC_ACQUIRE);
+
+            for (; head != tail; head++)
+            {
+                const io_uring_cqe& cqe = m_Cqes[head & *m_CqMask];
+                if (cqe.user_data == IO_URING_WAKE)
+                {
+                    wake = true;
+                    continue;
+                }
+
+                Read* read = reinterpret_cast<Read*>(cqe.user_data);
+                m_InFlight--;
+
+                if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+                {
+                    QueueRead(read);
+                    continue;
+                }
+                if (cqe.res <= 0)
+                {
+                    // Zero is an unexpected end of file.
+                    finished.push_back({ read, false });
+                    continue;
+                }
+
+                read->offset += static_cast<uint64_t>(cqe.res);
+                if (read->offset < read->request->result.data.size())
+                {
+                    QueueRead(read);
+                    continue;
+                }
+
+                finished.push_back({ read, true });
+            }
+
+            __atomic_store_n(m_CqHead, head, __ATOMIC_RELEASE);
+            SubmitQueued();
+
+            if (wake && m_Stopping)
+                return;
+        }
+
+        for (auto& [read, success] : finished)
+        {
+            Finish(read, success);
+        }
+        finished.clear();
+    }
+}
+
+void IoUringFileReader::Finish(Read* read, bool success)
+{
+    Scope<AsyncReadRequest> request = std::move(read->request);
+    delete read;
+
+    if (!success)
+    {
+        LogErr(ERROR_INFO, "Failed to read file: %s", request->result.path.c_str());
+        request->result.data.clear();
+    }
+
+    request->result.success = success;
+    request->callback(std::move(request->result));
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (--m_Pending == 0)
+    {
+        m_IdleCondition.notify_all();
+    }
+}
+
+Scope<AsyncFileReader> AsyncFileReader::Create()
+{
+    auto reader = std::make_unique<IoUringFileReader>();
+    if (reader->Init())
+        return reader;
+
+    return std::make_unique<JobFileReader>();
+}
+
+} // namespace aero3d
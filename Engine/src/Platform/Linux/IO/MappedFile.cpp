@@ -0,0 +1,73 @@
+#include "IO/MappedFile.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <errno.h>
+
+#include "Utils/Log.h"
+
+namespace aero3d {
+
+static const uint8_t* MapDescriptor(int fd, uint64_t& size)
+{
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0)
+        return nullptr;
+
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+        return nullptr;
+
+    size = static_cast<uint64_t>(st.st_size);
+    return static_cast<const uint8_t*>(data);
+}
+
+MappedFile::MappedFile(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        LogErr(ERROR_INFO, "Failed to open file: %s, errno: %d (%s)", path.c_str(), errno, strerror(errno));
+        return;
+    }
+
+    m_Data = MapDescriptor(fd, m_Size);
+    // The mapping keeps its own reference to the file.
+    close(fd);
+
+    if (!m_Data)
+    {
+        LogErr(ERROR_INFO, "Failed to map file: %s, errno: %d (%s)", path.c_str(), errno, strerror(errno));
+    }
+}
+
+MappedFile::MappedFile(FileHandle handle)
+{
+    if (handle != FILE_HANDLE_NULL)
+    {
+        m_Data = MapDescriptor(handle, m_Size);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_Data)
+    {
+        munmap(const_cast<uint8_t*>(m_Data), static_cast<size_t>(m_Size));
+    }
+}
+
+void MappedFile::AdviseSequential()
+{
+    if (!m_Data)
+        return;
+
+    void* data = const_cast<uint8_t*>(m_Data);
+    madvise(data, static_cast<size_t>(m_Size), MADV_SEQUENTIAL);
+    madvise(data, static_cast<size_t>(m_Size), MADV_WILLNEED);
+}
+
+} // namespace aero3d
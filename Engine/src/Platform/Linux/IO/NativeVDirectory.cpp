@@ -1,12 +1,15 @@
 #include "IO/NativeVFDirectory.h"
 
+#include <dirent.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <string.h>
 #include <errno.h>
 
 #include <memory>
+#include <mutex>
 
 #include "IO/NativeVFile.h"
 #include "Utils/StringManip.h"
@@ -16,6 +19,18 @@
 
 namespace aero3d {
 
+constexpr size_t DIRENT_BUFFER_SIZE = 32 * 1024;
+
+size_t NativeVFDirectory::PathHash::operator()(const std::string& path) const
+{
+    return std::hash<std::string>()(path);
+}
+
+bool NativeVFDirectory::PathEqual::operator()(const std::string& a, const std::string& b) const
+{
+    return a == b;
+}
+
 NativeVFDirectory::NativeVFDirectory(std::string virtualPath, std::string mountPoint)
 {
     m_VirtualPath = virtualPath;
@@ -36,8 +51,46 @@ Ref<VFile> NativeVFDirectory::OpenFile(std::string& path)
     return std::make_shared<NativeVFile>(fd, path);
 }
 
+Ref<VFile> NativeVFDirectory::CreateNewFile(std::string& path)
+{
+    std::string fullPath = A3D_RESOLVE_NATIVE_PATH(path);
+
+    for (size_t pos = fullPath.find('/', 1); pos != std::string::npos; pos = fullPath.find('/', pos + 1))
+    {
+        std::string parent = fullPath.substr(0, pos);
+        if (mkdir(parent.c_str(), 0755) == -1 && errno != EEXIST)
+        {
+            LogErr(ERROR_INFO, "Failed to create directory: %s, errno: %d (%s)", parent.c_str(), errno, strerror(errno));
+            return nullptr;
+        }
+    }
+
+    int fd = open(fullPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        LogErr(ERROR_INFO, "Failed to create file: %s, errno: %d (%s)", path.c_str(), errno, strerror(errno));
+        return nullptr;
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(m_IndexMutex);
+        if (m_Indexed)
+        {
+            m_Index.insert(path);
+        }
+    }
+
+    return std::make_shared<NativeVFile>(fd, path);
+}
+
 bool NativeVFDirectory::FileExists(std::string& path)
 {
+    {
+        std::shared_lock<std::shared_mutex> lock(m_IndexMutex);
+        if (m_Indexed)
+            return m_Index.contains(path);
+    }
+
     std::string fullPath = A3D_RESOLVE_NATIVE_PATH(path);
 
     struct stat st;
@@ -48,4 +101,107 @@ bool NativeVFDirectory::FileExists(std::string& path)
     return false;
 }
 
+void NativeVFDirectory::Enumerate(const std::string& path, bool recursive, std::vector<std::string>& files)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(m_IndexMutex);
+        if (m_Indexed)
+        {
+            std::string dir = AsDirectory(path);
+            for (const std::string& file : m_Index)
+            {
+                if (IsInDirectory(file, dir, recursive))
+                {
+                    files.push_back(file);
+                }
+            }
+            return;
+        }
+    }
+
+    Scan(path, recursive, files);
+}
+
+void NativeVFDirectory::BuildIndex()
+{
+    std::vector<std::string> files;
+    Scan("", true, files);
+
+    std::unique_lock<std::shared_mutex> lock(m_IndexMutex);
+    m_Index = std::unordered_set<std::string, PathHash, PathEqual>(
+        std::make_move_iterator(files.begin()), std::make_move_iterator(files.end()));
+    m_Indexed = true;
+
+    LogMsg("Indexed %s with %zu files.", m_MountPoint.c_str(), m_Index.size());
+}
+
+void NativeVFDirectory::Scan(const std::string& path, bool recursive, std::vector<std::string>& files)
+{
+    std::vector<std::string> pending = { AsDirectory(path) };
+    std::vector<char> buffer(DIRENT_BUFFER_SIZE);
+
+    while (!pending.empty())
+    {
+        std::string dir = std::move(pending.back());
+        pending.pop_back();
+
+        std::string fullPath = A3D_RESOLVE_NATIVE_PATH(dir);
+        int fd = open(fullPath.empty() ? "." : fullPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd == -1)
+            continue;
+
+        // getdents64 fills the buffer with as many entries as fit, one
+        // syscall per batch rather than per entry as readdir may do.
+        while (true)
+        {
+            long bytes = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+            if (bytes <= 0)
+            {
+                if (bytes == -1)
+                {
+                    LogErr(ERROR_INFO, "Failed to read directory: %s, errno: %d (%s)", fullPath.c_str(), errno, strerror(errno));
+                }
+                break;
+            }
+
+            for (long offset = 0; offset < bytes; )
+            {
+                const dirent64* entry = reinterpret_cast<const dirent64*>(buffer.data() + offset);
+                offset += entry->d_reclen;
+
+                const char* name = entry->d_name;
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+                    continue;
+
+                unsigned char type = entry->d_type;
+                bool link = type == DT_LNK;
+
+                // Some filesystems don't report the type, links are resolved.
+                if (type == DT_UNKNOWN || link)
+                {
+                    struct stat st;
+                    if (fstatat(fd, name, &st, 0) == -1)
+                        continue;
+                    type = S_ISDIR(st.st_mode) ? DT_DIR : DT_REG;
+                }
+
+                if (type == DT_DIR)
+                {
+                    // Linked directories are not followed, they may form cycles.
+                    if (recursive && !link)
+                    {
+                        pending.push_back(dir + name + '/');
+                    }
+                }
+                else
+                {
+                    files.push_back(dir + name);
+                }
+            }
+        }
+
+        close(fd);
+    }
+}
+
 } // namespace aero3d
@@ -2,9 +2,13 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <errno.h>
+#include <limits.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 
+#include <algorithm>
 #include <cstring>
 #include <limits>
 #include <cstddef>
@@ -42,7 +46,55 @@ NativeVFile::~NativeVFile()
         close(m_Handle);
     }
 
-    if (m_Data) free(m_Data);
+    Unload();
+}
+
+// pread may return less than asked for, e.g. when interrupted.
+static size_t ReadFully(int fd, void* buffer, size_t size, uint64_t start)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        ssize_t bytesRead = pread(fd, static_cast<uint8_t*>(buffer) + total, size - total,
+            static_cast<off_t>(start + total));
+
+        if (bytesRead < 0 && errno == EINTR)
+            continue;
+        if (bytesRead <= 0)
+            break;
+
+        total += static_cast<size_t>(bytesRead);
+    }
+    return total;
+}
+
+static bool ReadVectorFully(int fd, iovec* iov, int count, uint64_t start)
+{
+    while (count > 0)
+    {
+        ssize_t bytesRead = preadv(fd, iov, count, static_cast<off_t>(start));
+
+        if (bytesRead < 0 && errno == EINTR)
+            continue;
+        if (bytesRead <= 0)
+            return false;
+
+        start += static_cast<uint64_t>(bytesRead);
+
+        size_t remaining = static_cast<size_t>(bytesRead);
+        while (count > 0 && remaining >= iov->iov_len)
+        {
+            remaining -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + remaining;
+            iov->iov_len -= remaining;
+        }
+    }
+    return true;
 }
 
 void NativeVFile::ReadBytes(void* buffer, size_t size, size_t start)
@@ -53,37 +105,75 @@ void NativeVFile::ReadBytes(void* buffer, size_t size, size_t start)
         return;
     }
 
+    if (start > m_Length)
+    {
+        LogErr(ERROR_INFO, "Start is past the end of file: %s", m_VirtualPath.c_str());
+        return;
+    }
+
     if (start + size > m_Length) 
     {
         LogErr(ERROR_INFO, "Size is bigger than length in file: %s", m_VirtualPath.c_str());
         size = static_cast<size_t>(m_Length - start);
     }
 
-    if (lseek(m_Handle, static_cast<off_t>(start), SEEK_SET) == -1) 
+    if (ReadFully(m_Handle, buffer, size, start) != size)
     {
-        LogErr(ERROR_INFO, "Failed to set file pointer: %s", m_VirtualPath.c_str());
-        return;
+        LogErr(ERROR_INFO, "Failed to read bytes from file: %s, errno: %d (%s)",
+            m_VirtualPath.c_str(), errno, strerror(errno));
     }
+}
+
+bool NativeVFile::ReadRanges(const std::vector<VFileRange>& ranges)
+{
+    std::vector<iovec> iov;
+    iov.reserve(std::min<size_t>(ranges.size(), IOV_MAX));
+
+    bool complete = true;
+    uint64_t runStart = 0;
+    uint64_t runEnd = 0;
+
+    auto flush = [&]()
+    {
+        if (!iov.empty() && !ReadVectorFully(m_Handle, iov.data(), static_cast<int>(iov.size()), runStart))
+        {
+            LogErr(ERROR_INFO, "Failed to read ranges from file: %s", m_VirtualPath.c_str());
+            complete = false;
+        }
+        iov.clear();
+    };
 
-    ssize_t bytesRead = read(m_Handle, buffer, size);
-    if (bytesRead < 0) 
+    for (const VFileRange& range : ranges)
     {
-        LogErr(ERROR_INFO, "Failed to read bytes from file: %s", m_VirtualPath.c_str());
+        if (range.size == 0)
+            continue;
+
+        if (!range.buffer || range.start > m_Length || range.size > m_Length - range.start)
+        {
+            LogErr(ERROR_INFO, "Range is out of bounds in file: %s", m_VirtualPath.c_str());
+            complete = false;
+            continue;
+        }
+
+        if (iov.empty() || range.start != runEnd || iov.size() == IOV_MAX)
+        {
+            flush();
+            runStart = range.start;
+        }
+
+        iov.push_back({ range.buffer, range.size });
+        runEnd = range.start + range.size;
     }
+    flush();
+
+    return complete;
 }
 
 std::string NativeVFile::ReadString()
 {
     std::string result(static_cast<size_t>(m_Length), '\0');
 
-    if (lseek(m_Handle, 0, SEEK_SET) == -1) 
-    {
-        LogErr(ERROR_INFO, "Failed to reset file pointer in file: %s", m_VirtualPath.c_str());
-        return "";
-    }
-
-    ssize_t bytesRead = read(m_Handle, result.data(), m_Length);
-    if (bytesRead != static_cast<ssize_t>(m_Length)) 
+    if (ReadFully(m_Handle, result.data(), result.size(), 0) != result.size())
     {
         LogErr(ERROR_INFO, "Failed to read string from file: %s", m_VirtualPath.c_str());
         return "";
@@ -94,6 +184,9 @@ std::string NativeVFile::ReadString()
 
 void NativeVFile::Truncate(size_t pos)
 {
+    // The loaded data would no longer match the file.
+    Unload();
+
     if (pos > static_cast<size_t>(std::numeric_limits<off_t>::max())) 
     {
         LogErr(ERROR_INFO, "Pos is bigger than max value: %s", m_VirtualPath.c_str());
@@ -111,6 +204,9 @@ void NativeVFile::Truncate(size_t pos)
 
 void NativeVFile::WriteBytes(void* data, size_t size, size_t start)
 {
+    // The loaded data would no longer match the file.
+    Unload();
+
     if (!data || size == 0) 
     {
         LogErr(ERROR_INFO, "Data pointer or size is incorrect in file: %s", m_VirtualPath.c_str());
@@ -123,17 +219,22 @@ void NativeVFile::WriteBytes(void* data, size_t size, size_t start)
         return;
     }
 
-    if (lseek(m_Handle, static_cast<off_t>(start), SEEK_SET) == -1) 
+    size_t bytesWritten = 0;
+    while (bytesWritten < size)
     {
-        LogErr(ERROR_INFO, "Failed to set write pointer in file: %s", m_VirtualPath.c_str());
-        return;
-    }
+        ssize_t result = pwrite(m_Handle, static_cast<uint8_t*>(data) + bytesWritten, size - bytesWritten,
+            static_cast<off_t>(start + bytesWritten));
 
-    ssize_t bytesWritten = write(m_Handle, data, size);
-    if (bytesWritten < 0) 
-    {
-        LogErr(ERROR_INFO, "Failed to write bytes in file: %s", m_VirtualPath.c_str());
-        return;
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+        {
+            LogErr(ERROR_INFO, "Failed to write bytes in file: %s, errno: %d (%s)",
+                m_VirtualPath.c_str(), errno, strerror(errno));
+            break;
+        }
+
+        bytesWritten += static_cast<size_t>(result);
     }
 
     if (start + bytesWritten > m_Length) 
@@ -144,13 +245,28 @@ void NativeVFile::WriteBytes(void* data, size_t size, size_t start)
 
 void NativeVFile::Load()
 {
-    m_Data = new std::byte[m_Length];
-    ReadBytes(m_Data, m_Length, 0);
+    if (m_Data)
+        return;
+
+    m_Mapping = std::make_shared<MappedFile>(m_Handle);
+    if (m_Mapping->IsValid())
+    {
+        m_Mapping->AdviseSequential();
+        m_Data = const_cast<uint8_t*>(m_Mapping->GetData());
+        return;
+    }
+
+    m_Mapping = nullptr;
+    m_Buffer = malloc(m_Length > 0 ? static_cast<size_t>(m_Length) : 1);
+    ReadBytes(m_Buffer, static_cast<size_t>(m_Length), 0);
+    m_Data = m_Buffer;
 }
 
 void NativeVFile::Unload()
 {
-    free(m_Data);
+    m_Mapping = nullptr;
+    free(m_Buffer);
+    m_Buffer = nullptr;
     m_Data = nullptr;
 }
 
@@ -0,0 +1,11 @@
+#include "IO/AsyncFileReader.h"
+
+namespace aero3d {
+
+// Reads go through the job system until there is an overlapped I/O backend.
+Scope<AsyncFileReader> AsyncFileReader::Create()
+{
+    return std::make_unique<JobFileReader>();
+}
+
+} // namespace aero3d
@@ -0,0 +1,80 @@
+#include "IO/MappedFile.h"
+
+#define NOMINMAX
+#include <windows.h>
+
+#include "Utils/Log.h"
+
+namespace aero3d {
+
+static const uint8_t* MapHandle(HANDLE file, HANDLE& mapping, uint64_t& size)
+{
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        return nullptr;
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+        return nullptr;
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(mapping);
+        mapping = nullptr;
+        return nullptr;
+    }
+
+    size = static_cast<uint64_t>(fileSize.QuadPart);
+    return static_cast<const uint8_t*>(data);
+}
+
+MappedFile::MappedFile(const std::string& path)
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        LogErr(ERROR_INFO, "Failed to open file: %s", path.c_str());
+        return;
+    }
+
+    m_Data = MapHandle(file, m_Mapping, m_Size);
+    if (!m_Data)
+    {
+        LogErr(ERROR_INFO, "Failed to map file: %s", path.c_str());
+        CloseHandle(file);
+        return;
+    }
+
+    m_File = file;
+}
+
+MappedFile::MappedFile(FileHandle handle)
+{
+    if (handle && handle != INVALID_HANDLE_VALUE)
+    {
+        m_Data = MapHandle(handle, m_Mapping, m_Size);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_Data) UnmapViewOfFile(m_Data);
+    if (m_Mapping) CloseHandle(m_Mapping);
+    if (m_File) CloseHandle(m_File);
+}
+
+void MappedFile::AdviseSequential()
+{
+    if (!m_Data)
+        return;
+
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<uint8_t*>(m_Data);
+    range.NumberOfBytes = static_cast<SIZE_T>(m_Size);
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+} // namespace aero3d
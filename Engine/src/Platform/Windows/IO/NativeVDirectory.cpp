@@ -1,7 +1,10 @@
 #include "IO/NativeVFDirectory.h"
 
 #include <Windows.h>
+#include <algorithm>
+#include <cctype>
 #include <memory>
+#include <mutex>
 #include <string.h>
 
 #include "IO/NativeVFile.h"
@@ -12,6 +15,37 @@
 
 namespace aero3d {
 
+// Windows resolves paths case-insensitively and accepts both separators.
+static char NormalizePathChar(char c)
+{
+    return c == '\\' ? '/' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+static std::string NormalizePath(const std::string& path)
+{
+    std::string normalized = path;
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(), NormalizePathChar);
+    return normalized;
+}
+
+size_t NativeVFDirectory::PathHash::operator()(const std::string& path) const
+{
+    // FNV-1a over the normalized characters, without building a copy.
+    size_t hash = static_cast<size_t>(14695981039346656037ull);
+    for (char c : path)
+    {
+        hash ^= static_cast<unsigned char>(NormalizePathChar(c));
+        hash *= static_cast<size_t>(1099511628211ull);
+    }
+    return hash;
+}
+
+bool NativeVFDirectory::PathEqual::operator()(const std::string& a, const std::string& b) const
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+        [](char x, char y) { return NormalizePathChar(x) == NormalizePathChar(y); });
+}
+
 NativeVFDirectory::NativeVFDirectory(std::string virtualPath, std::string mountPoint)
 {
     m_VirtualPath = virtualPath;
@@ -36,10 +70,131 @@ Ref<VFile> NativeVFDirectory::OpenFile(std::string& path)
     return std::make_shared<NativeVFile>(fileHandle, path);
 }
 
+Ref<VFile> NativeVFDirectory::CreateNewFile(std::string& path)
+{
+    std::string fullPath = A3D_RESOLVE_NATIVE_PATH(path);
+
+    for (size_t pos = fullPath.find_first_of("/\\", 1); pos != std::string::npos;
+        pos = fullPath.find_first_of("/\\", pos + 1))
+    {
+        std::string parent = fullPath.substr(0, pos);
+        if (!CreateDirectoryA(parent.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+        {
+            LogErr(ERROR_INFO, "Failed to create directory: %s", parent.c_str());
+            return nullptr;
+        }
+    }
+
+    HANDLE fileHandle = CreateFileA(
+        fullPath.c_str(),
+        GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+
+    if (!fileHandle || fileHandle == INVALID_HANDLE_VALUE)
+    {
+        LogErr(ERROR_INFO, "Failed to create file: %s", path.c_str());
+        return nullptr;
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(m_IndexMutex);
+        if (m_Indexed)
+        {
+            m_Index.insert(path);
+        }
+    }
+
+    return std::make_shared<NativeVFile>(fileHandle, path);
+}
+
 bool NativeVFDirectory::FileExists(std::string& path)
 {
+    {
+        std::shared_lock<std::shared_mutex> lock(m_IndexMutex);
+        if (m_Indexed)
+            return m_Index.contains(path);
+    }
+
     DWORD attrs = GetFileAttributesA(A3D_RESOLVE_NATIVE_PATH(path).c_str());
     return (attrs != INVALID_FILE_ATTRIBUTES) && !(attrs & FILE_ATTRIBUTE_DIRECTORY);
 }
 
+void NativeVFDirectory::Enumerate(const std::string& path, bool recursive, std::vector<std::string>& files)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(m_IndexMutex);
+        if (m_Indexed)
+        {
+            std::string dir = NormalizePath(AsDirectory(path));
+            for (const std::string& file : m_Index)
+            {
+                if (IsInDirectory(NormalizePath(file), dir, recursive))
+                {
+                    files.push_back(file);
+                }
+            }
+            return;
+        }
+    }
+
+    Scan(path, recursive, files);
+}
+
+void NativeVFDirectory::BuildIndex()
+{
+    std::vector<std::string> files;
+    Scan("", true, files);
+
+    std::unique_lock<std::shared_mutex> lock(m_IndexMutex);
+    m_Index = std::unordered_set<std::string, PathHash, PathEqual>(
+        std::make_move_iterator(files.begin()), std::make_move_iterator(files.end()));
+    m_Indexed = true;
+
+    LogMsg("Indexed %s with %zu files.", m_MountPoint.c_str(), m_Index.size());
+}
+
+void NativeVFDirectory::Scan(const std::string& path, bool recursive, std::vector<std::string>& files)
+{
+    std::vector<std::string> pending = { AsDirectory(path) };
+
+    while (!pending.empty())
+    {
+        std::string dir = std::move(pending.back());
+        pending.pop_back();
+
+        WIN32_FIND_DATAA data;
+        HANDLE find = FindFirstFileExA((A3D_RESOLVE_NATIVE_PATH(dir) + "*").c_str(), FindExInfoBasic,
+            &data, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+        if (find == INVALID_HANDLE_VALUE)
+            continue;
+
+        do
+        {
+            const char* name = data.cFileName;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+                continue;
+
+            if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            {
+                // Junctions and linked directories are not followed, they may form cycles.
+                if (recursive && !(data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+                {
+                    pending.push_back(dir + name + '/');
+                }
+            }
+            else
+            {
+                files.push_back(dir + name);
+            }
+        } while (FindNextFileA(find, &data));
+
+        FindClose(find);
+    }
+}
+
 } // namespace aero3d
\ No newline at end of file
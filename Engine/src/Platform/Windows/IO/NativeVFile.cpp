@@ -3,7 +3,9 @@
 #define NOMINMAX
 #include <windows.h>
 
+#include <algorithm>
 #include <cstdlib>
+#include <limits>
 
 #include "Utils/Log.h"
 
@@ -31,7 +33,47 @@ NativeVFile::~NativeVFile()
     if (m_Handle && m_Handle != INVALID_HANDLE_VALUE)
         CloseHandle(m_Handle);
 
-    if (m_Data) free(m_Data);
+    Unload();
+}
+
+// Passing the offset in an OVERLAPPED makes a synchronous read or write
+// positional, nothing depends on the shared file pointer.
+static size_t ReadAt(HANDLE handle, void* buffer, size_t size, uint64_t start)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(start + total);
+        overlapped.OffsetHigh = static_cast<DWORD>((start + total) >> 32);
+
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(size - total, MAXDWORD));
+        DWORD bytesRead = 0;
+        if (!ReadFile(handle, static_cast<uint8_t*>(buffer) + total, chunk, &bytesRead, &overlapped) || bytesRead == 0)
+            break;
+
+        total += bytesRead;
+    }
+    return total;
+}
+
+static size_t WriteAt(HANDLE handle, const void* data, size_t size, uint64_t start)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(start + total);
+        overlapped.OffsetHigh = static_cast<DWORD>((start + total) >> 32);
+
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(size - total, MAXDWORD));
+        DWORD bytesWritten = 0;
+        if (!WriteFile(handle, static_cast<const uint8_t*>(data) + total, chunk, &bytesWritten, &overlapped) || bytesWritten == 0)
+            break;
+
+        total += bytesWritten;
+    }
+    return total;
 }
 
 void NativeVFile::ReadBytes(void* buffer, size_t size, size_t start)
@@ -42,34 +84,48 @@ void NativeVFile::ReadBytes(void* buffer, size_t size, size_t start)
         return;
     }
 
+    if (start > m_Length)
+    {
+        LogErr(ERROR_INFO, "Start is past the end of file: %s", m_VirtualPath.c_str());
+        return;
+    }
+
     if (start + size > m_Length)
     {
         LogErr(ERROR_INFO, "Size is bigger than length inf file: %s", m_VirtualPath.c_str());
         size = static_cast<size_t>(m_Length - start);
     }
 
-    LARGE_INTEGER li;
-    li.QuadPart = static_cast<LONGLONG>(start);
-    SetFilePointerEx(m_Handle, li, nullptr, FILE_BEGIN);
-
-    if (!ReadFile(m_Handle, buffer, static_cast<DWORD>(size), nullptr, nullptr))
+    if (ReadAt(m_Handle, buffer, size, start) != size)
         LogErr(ERROR_INFO, "Failed to read bytes from file: %s", m_VirtualPath.c_str());
 }
 
-std::string NativeVFile::ReadString()
+bool NativeVFile::ReadRanges(const std::vector<VFileRange>& ranges)
 {
-    std::string result(static_cast<size_t>(m_Length), '\0');
-
-    LARGE_INTEGER li;
-    li.QuadPart = 0;
-    if (!SetFilePointerEx(m_Handle, li, nullptr, FILE_BEGIN))
+    bool complete = true;
+    for (const VFileRange& range : ranges)
     {
-        LogErr(ERROR_INFO, "Failed to set read pointer in file: %s", m_VirtualPath.c_str());
-        return "";
+        if (!range.buffer || range.start > m_Length || range.size > m_Length - range.start)
+        {
+            LogErr(ERROR_INFO, "Range is out of bounds in file: %s", m_VirtualPath.c_str());
+            complete = false;
+            continue;
+        }
+
+        if (ReadAt(m_Handle, range.buffer, range.size, range.start) != range.size)
+        {
+            LogErr(ERROR_INFO, "Failed to read ranges from file: %s", m_VirtualPath.c_str());
+            complete = false;
+        }
     }
+    return complete;
+}
 
-    DWORD bytesRead = 0;
-    if (!ReadFile(m_Handle, result.data(), static_cast<DWORD>(m_Length), &bytesRead, nullptr) || bytesRead != m_Length)
+std::string NativeVFile::ReadString()
+{
+    std::string result(static_cast<size_t>(m_Length), '\0');
+
+    if (ReadAt(m_Handle, result.data(), result.size(), 0) != result.size())
     {
         LogErr(ERROR_INFO, "Failed to read string from file: %s", m_VirtualPath.c_str());
         return "";
@@ -80,6 +136,9 @@ std::string NativeVFile::ReadString()
 
 void NativeVFile::Truncate(size_t pos)
 {
+    // The loaded data would no longer match the file.
+    Unload();
+
     if (pos > static_cast<size_t>(std::numeric_limits<LONGLONG>::max()))
     {
         LogErr(ERROR_INFO, "Pos is bigger than maximum value in file: %s", m_VirtualPath.c_str());
@@ -105,6 +164,9 @@ void NativeVFile::Truncate(size_t pos)
 
 void NativeVFile::WriteBytes(void* data, size_t size, size_t start)
 {
+    // The loaded data would no longer match the file.
+    Unload();
+
     if (!data || size == 0)
     {
         LogErr(ERROR_INFO, "Data pointer or size is incorrect in file: %s", m_VirtualPath.c_str());
@@ -112,22 +174,15 @@ void NativeVFile::WriteBytes(void* data, size_t size, size_t start)
     }
 
     if (start > std::numeric_limits<uint64_t>::max() - size)
-        LogErr(ERROR_INFO, "Pos is bigger than maximum value in file: %s", m_VirtualPath.c_str());
-        return;
-
-    LARGE_INTEGER li;
-    li.QuadPart = static_cast<LONGLONG>(start);
-    if (!SetFilePointerEx(m_Handle, li, nullptr, FILE_BEGIN))
     {
-        LogErr(ERROR_INFO, "Failed to set read pointer in file: %s", m_VirtualPath.c_str());
+        LogErr(ERROR_INFO, "Pos is bigger than maximum value in file: %s", m_VirtualPath.c_str());
         return;
     }
 
-    DWORD bytesWritten = 0;
-    if (!WriteFile(m_Handle, data, static_cast<DWORD>(size), &bytesWritten, nullptr))
+    size_t bytesWritten = WriteAt(m_Handle, data, size, start);
+    if (bytesWritten != size)
     {
         LogErr(ERROR_INFO, "Failed to write bytes in file: %s", m_VirtualPath.c_str());
-        return;
     }
 
     if (start + bytesWritten > m_Length) {
@@ -137,13 +192,28 @@ void NativeVFile::WriteBytes(void* data, size_t size, size_t start)
 
 void NativeVFile::Load()
 {
-    m_Data = new byte[m_Length];
-    ReadBytes(m_Data, m_Length, 0);
+    if (m_Data)
+        return;
+
+    m_Mapping = std::make_shared<MappedFile>(m_Handle);
+    if (m_Mapping->IsValid())
+    {
+        m_Mapping->AdviseSequential();
+        m_Data = const_cast<uint8_t*>(m_Mapping->GetData());
+        return;
+    }
+
+    m_Mapping = nullptr;
+    m_Buffer = malloc(m_Length > 0 ? static_cast<size_t>(m_Length) : 1);
+    ReadBytes(m_Buffer, static_cast<size_t>(m_Length), 0);
+    m_Data = m_Buffer;
 }
 
 void NativeVFile::Unload()
 {
-    free(m_Data);
+    m_Mapping = nullptr;
+    free(m_Buffer);
+    m_Buffer = nullptr;
     m_Data = nullptr;
 }
 
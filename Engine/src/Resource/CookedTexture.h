@@ -0,0 +1,49 @@
+#ifndef AERO3D_RESOURCE_COOKEDTEXTURE_H_
+#define AERO3D_RESOURCE_COOKEDTEXTURE_H_
+
+#include <cstdint>
+#include <string>
+
+namespace aero3d {
+
+constexpr uint32_t COOKED_TEXTURE_MAGIC = 0x54443341; // "A3DT"
+// Bump whenever the layout changes, old files are then cooked again.
+constexpr uint32_t COOKED_TEXTURE_VERSION = 1;
+constexpr uint64_t COOKED_TEXTURE_ALIGNMENT = 16;
+constexpr const char* COOKED_TEXTURE_EXTENSION = ".a3dtex";
+
+// Written by the AssetCooker. The payload starts at dataOffset, aligned to
+// COOKED_TEXTURE_ALIGNMENT, and holds every level tightly packed, largest
+// first, exactly as the GPU copies them. Loading it is a single read into
+// staging memory.
+struct CookedTextureHeader
+{
+    uint32_t magic = COOKED_TEXTURE_MAGIC;
+    uint32_t version = COOKED_TEXTURE_VERSION;
+    uint32_t format = 0; // TextureFormat
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipLevels = 1;
+    uint64_t dataOffset = 0;
+    uint64_t dataSize = 0;
+    uint32_t reserved[2] = {};
+};
+
+static_assert(sizeof(CookedTextureHeader) % COOKED_TEXTURE_ALIGNMENT == 0,
+    "Cooked texture header must keep the payload aligned.");
+
+// "res/textures/stone.png" is cooked to "res/textures/stone.a3dtex".
+inline std::string GetCookedTexturePath(const std::string& path)
+{
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("/\\");
+
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return path + COOKED_TEXTURE_EXTENSION;
+
+    return path.substr(0, dot) + COOKED_TEXTURE_EXTENSION;
+}
+
+} // namespace aero3d
+
+#endif // AERO3D_RESOURCE_COOKEDTEXTURE_H_
@@ -1,7 +1,9 @@
 #include "Resource/ResourceManager.h"
 
+#include "Graphics/BindlessTextureTable.h"
 #include "IO/VFS.h"
-#include "Utils/ImageLoader.h"
+#include "Utils/Assert.h"
+#include "Utils/Log.h"
 
 namespace aero3d {
 
@@ -9,14 +11,23 @@ ResourceManager::ResourceManager(GraphicsDevice* graphicsDevice, ResourceFactory
 {
     m_GraphicsDevice = graphicsDevice;
     m_ResourceFactory = resourceFactory;
+
+    CreatePlaceholder();
 }
 
 ResourceManager::~ResourceManager()
 {
+    // Decode jobs write into the pending entries.
+    for (auto& pending : m_PendingTextures)
+    {
+        JobSystem::Wait(pending->decoded);
+    }
+    m_PendingTextures.clear();
+
     Clean();
 }
 
-Ref<TextureView> ResourceManager::LoadTexture(std::string path)
+Ref<TextureView> ResourceManager::LoadTexture(std::string path, bool generateMipmaps)
 {
     auto it = m_Textures.find(path);
     if (it != m_Textures.end())
@@ -27,29 +38,157 @@ Ref<TextureView> ResourceManager::LoadTexture(std::string path)
         }
     }
 
-    ImageData id = ImageLoader::LoadImage("res/textures/texture.jpg");
+    ImageData id;
+    CookedTextureHeader header;
 
-    TextureDesc td;
-    td.width = id.width;
-    td.height = id.height;
-    td.format = id.format;
-    td.usage = TextureUsage::Sampled;
+    if (Ref<VFile> cooked = OpenCookedTexture(GetCookedTexturePath(path), header, id))
+    {
+        id.pixels.resize(header.dataSize);
+        cooked->ReadBytes(id.pixels.data(), id.pixels.size(), header.dataOffset);
+    }
+    else
+    {
+        id = ImageLoader::LoadImage(path);
+        RejectUnsupportedFormat(path, id);
+    }
 
-    Ref<Texture> texture = m_ResourceFactory->CreateTexture(td);
+    if (id.pixels.empty())
+        return m_Placeholder;
 
-    m_GraphicsDevice->UpdateTexture(texture, id.pixels.data(), id.pixels.size());
+    Ref<Texture> texture = CreateTexture(id, generateMipmaps);
+    if (!texture)
+        return m_Placeholder;
 
-    TextureViewDesc tvd;
-    tvd.format = id.format;
-    tvd.texture = texture;
+    m_GraphicsDevice->UpdateTexture(texture, id.pixels.data(), id.pixels.size());
 
-    Ref<TextureView> textureView = m_ResourceFactory->CreateTextureView(tvd);
+    Ref<TextureView> textureView = CreateTextureView(texture, id.format);
 
     m_Textures[path] = textureView;
 
     return textureView;
 }
 
+Ref<TextureHandle> ResourceManager::LoadTextureAsync(const std::string& path, bool generateMipmaps)
+{
+    auto it = m_TextureHandles.find(path);
+    if (it != m_TextureHandles.end())
+    {
+        if (auto existing = it->second.lock())
+        {
+            return existing;
+        }
+    }
+
+    Ref<TextureHandle> handle = std::make_shared<TextureHandle>();
+    m_TextureHandles[path] = handle;
+
+    auto loaded = m_Textures.find(path);
+    if (loaded != m_Textures.end())
+    {
+        if (auto existing = loaded->second.lock())
+        {
+            handle->m_View = existing;
+            handle->m_Loaded = true;
+            return handle;
+        }
+    }
+
+    handle->m_View = m_Placeholder;
+
+    auto pending = std::make_unique<PendingTexture>();
+    pending->path = path;
+    pending->handle = handle;
+    pending->generateMipmaps = generateMipmaps;
+
+    PendingTexture* target = pending.get();
+    JobSystem::Execute(pending->decoded, [this, target]()
+    {
+        target->cookedFile = OpenCookedTexture(GetCookedTexturePath(target->path),
+            target->cookedHeader, target->image);
+
+        if (!target->cookedFile)
+        {
+            target->image = ImageLoader::LoadImage(target->path);
+            RejectUnsupportedFormat(target->path, target->image);
+        }
+    });
+
+    m_PendingTextures.push_back(std::move(pending));
+
+    return handle;
+}
+
+void ResourceManager::Update()
+{
+    uint32_t uploads = 0;
+
+    for (auto it = m_PendingTextures.begin(); it != m_PendingTextures.end(); )
+    {
+        PendingTexture& pending = **it;
+
+        if (!pending.uploading)
+        {
+            if (pending.decoded.pending.load() > 0 || uploads >= MAX_TEXTURE_UPLOADS_PER_UPDATE)
+            {
+                ++it;
+                continue;
+            }
+
+            // A failed decode already logged, the handle keeps the placeholder.
+            if (!pending.cookedFile && pending.image.pixels.empty())
+            {
+                it = m_PendingTextures.erase(it);
+                continue;
+            }
+
+            pending.texture = CreateTexture(pending.image, pending.generateMipmaps);
+            if (!pending.texture)
+            {
+                it = m_PendingTextures.erase(it);
+                continue;
+            }
+
+            if (pending.cookedFile)
+            {
+                // Cooked levels are stored as the GPU copies them, so the
+                // payload is read once, straight into staging memory.
+                VFile* file = pending.cookedFile.get();
+                const CookedTextureHeader& header = pending.cookedHeader;
+
+                pending.upload = m_GraphicsDevice->UploadTextureAsync(pending.texture, header.dataSize,
+                    [file, &header](void* staging)
+                    {
+                        file->ReadBytes(staging, header.dataSize, header.dataOffset);
+                    });
+                pending.cookedFile = nullptr;
+            }
+            else
+            {
+                pending.upload = m_GraphicsDevice->UploadTextureAsync(pending.texture,
+                    pending.image.pixels.data(), pending.image.pixels.size());
+            }
+            pending.uploading = true;
+            uploads++;
+
+            // The upload queue copied the pixels into staging memory.
+            pending.image.pixels = {};
+        }
+
+        if (!m_GraphicsDevice->IsUploadComplete(pending.upload))
+        {
+            ++it;
+            continue;
+        }
+
+        Ref<TextureView> textureView = CreateTextureView(pending.texture, pending.image.format);
+        pending.handle->m_View = textureView;
+        pending.handle->m_Loaded = true;
+        m_Textures[pending.path] = textureView;
+
+        it = m_PendingTextures.erase(it);
+    }
+}
+
 void ResourceManager::Clean()
 {
     for (auto it = m_Textures.begin(); it != m_Textures.end(); )
@@ -63,6 +202,137 @@ void ResourceManager::Clean()
             ++it;
         }
     }
+
+    for (auto it = m_TextureHandles.begin(); it != m_TextureHandles.end(); )
+    {
+        if (it->second.expired())
+        {
+            it = m_TextureHandles.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+Ref<Texture> ResourceManager::CreateTexture(const ImageData& image, bool generateMipmaps)
+{
+    TextureDesc td;
+    td.width = image.width;
+    td.height = image.height;
+    td.format = image.format;
+    td.mipLevels = image.mipLevels;
+    td.usage = TextureUsage::Sampled;
+    // Cooked files bring their own chain, and compressed blocks can't be blitted.
+    td.generateMipmaps = generateMipmaps && image.mipLevels == 1 && !IsCompressedFormat(image.format);
+
+    Ref<Texture> texture = m_ResourceFactory->CreateTexture(td);
+    if (!texture->IsValid())
+    {
+        LogErr(ERROR_INFO, "Failed to create a %ux%u texture.", image.width, image.height);
+        return nullptr;
+    }
+
+    return texture;
+}
+
+Ref<TextureView> ResourceManager::CreateTextureView(Ref<Texture> texture, TextureFormat format)
+{
+    TextureViewDesc tvd;
+    tvd.format = format;
+    tvd.texture = texture;
+
+    Ref<TextureView> textureView = m_ResourceFactory->CreateTextureView(tvd);
+
+    if (BindlessTextureTable* bindlessTable = m_GraphicsDevice->GetBindlessTextureTable())
+    {
+        bindlessTable->Register(textureView);
+    }
+
+    return textureView;
+}
+
+void ResourceManager::CreatePlaceholder()
+{
+    ImageData image{};
+    image.width = 1;
+    image.height = 1;
+    image.channels = 4;
+    image.format = TextureFormat::RGBA8;
+    image.pixels = { 255, 255, 255, 255 };
+
+    Ref<Texture> texture = CreateTexture(image, false);
+    Assert(ERROR_INFO, texture != nullptr, "Failed to create the placeholder texture!");
+    m_GraphicsDevice->UpdateTexture(texture, image.pixels.data(), image.pixels.size());
+
+    m_Placeholder = CreateTextureView(texture, image.format);
+}
+
+void ResourceManager::RejectUnsupportedFormat(const std::string& path, ImageData& image)
+{
+    if (image.pixels.empty() || m_GraphicsDevice->IsFormatSupported(image.format))
+        return;
+
+    LogErr(ERROR_INFO, "Texture format %d is not supported by this device: %s",
+        static_cast<int>(image.format), path.c_str());
+    image = ImageData{};
+}
+
+Ref<VFile> ResourceManager::OpenCookedTexture(const std::string& path, CookedTextureHeader& header, ImageData& image)
+{
+    if (!VFS::FileExists(path))
+        return nullptr;
+
+    Ref<VFile> file = VFS::ReadFile(path);
+    if (!file || file->GetLength() < sizeof(header))
+    {
+        LogErr(ERROR_INFO, "Cooked texture is truncated: %s", path.c_str());
+        return nullptr;
+    }
+
+    file->ReadBytes(&header, sizeof(header));
+
+    if (header.magic != COOKED_TEXTURE_MAGIC || header.version != COOKED_TEXTURE_VERSION)
+    {
+        LogMsg("Cooked texture is stale, falling back to the source image: %s", path.c_str());
+        return nullptr;
+    }
+
+    TextureFormat format = static_cast<TextureFormat>(header.format);
+    bool valid =
+        header.format <= static_cast<uint32_t>(TextureFormat::BC7_SRGB) &&
+        header.width > 0 && header.height > 0 &&
+        header.mipLevels >= 1 && header.mipLevels <= CalculateMipLevels(header.width, header.height) &&
+        header.dataOffset >= sizeof(header) && header.dataOffset % COOKED_TEXTURE_ALIGNMENT == 0 &&
+        header.dataOffset + header.dataSize <= file->GetLength();
+
+    size_t expectedSize = 0;
+    for (uint32_t level = 0; valid && level < header.mipLevels; level++)
+    {
+        expectedSize += GetTextureLevelSize(format, header.width >> level, header.height >> level);
+    }
+
+    if (!valid || header.dataSize != expectedSize)
+    {
+        LogErr(ERROR_INFO, "Invalid cooked texture: %s", path.c_str());
+        return nullptr;
+    }
+
+    if (!m_GraphicsDevice->IsFormatSupported(format))
+    {
+        LogMsg("Cooked texture format is not supported by this device, falling back to the source image: %s",
+            path.c_str());
+        return nullptr;
+    }
+
+    image.width = header.width;
+    image.height = header.height;
+    image.mipLevels = header.mipLevels;
+    image.format = format;
+    image.channels = format == TextureFormat::BC5 ? 2 : 4;
+
+    return file;
 }
 
 } // namespace aero3d
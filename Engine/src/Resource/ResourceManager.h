@@ -1,30 +1,81 @@
 #ifndef AERO3D_RESOURCE_RESOURCEMANAGER_H_
 #define AERO3D_RESOURCE_RESOURCEMANAGER_H_
 
+#include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "Core/JobSystem.h"
 #include "Graphics/GraphicsDevice.h"
 #include "Graphics/ResourceFactory.h"
+#include "IO/VFile.h"
+#include "Resource/CookedTexture.h"
+#include "Resource/TextureHandle.h"
+#include "Utils/ImageLoader.h"
 
 namespace aero3d {
 
+// Caps how many decoded textures are handed to the upload queue per
+// Update, so a burst of finished decodes does not stall one frame.
+constexpr uint32_t MAX_TEXTURE_UPLOADS_PER_UPDATE = 16;
+
 class ResourceManager
 {
 public:
     ResourceManager(GraphicsDevice* graphicsDevice, ResourceFactory* resourceFactory);
     ~ResourceManager();
 
-    Ref<TextureView> LoadTexture(std::string path);
+    // Textures are cached by path, the first load decides about mipmaps.
+    // A cooked .a3dtex next to the source image is preferred over it.
+    Ref<TextureView> LoadTexture(std::string path, bool generateMipmaps = true);
+    // Decodes on the job system and uploads on the transfer queue. The
+    // handle shows a placeholder until Update swaps in the texture.
+    Ref<TextureHandle> LoadTextureAsync(const std::string& path, bool generateMipmaps = true);
 
+    // Main thread, once per frame: uploads finished decodes and publishes
+    // finished uploads.
+    void Update();
     void Clean();
 
+private:
+    struct PendingTexture
+    {
+        std::string path;
+        Ref<TextureHandle> handle;
+        JobCounter decoded;
+        ImageData image;
+        // Set instead of image.pixels when a cooked file was found.
+        Ref<VFile> cookedFile;
+        CookedTextureHeader cookedHeader;
+        Ref<Texture> texture;
+        uint64_t upload = 0;
+        bool generateMipmaps = true;
+        bool uploading = false;
+    };
+
+    // Null when the device couldn't create the texture.
+    Ref<Texture> CreateTexture(const ImageData& image, bool generateMipmaps);
+    Ref<TextureView> CreateTextureView(Ref<Texture> texture, TextureFormat format);
+    void CreatePlaceholder();
+    // Drops images the device can't sample, they get the placeholder.
+    void RejectUnsupportedFormat(const std::string& path, ImageData& image);
+
+    // Null when there is no valid cooked file or the device can't sample
+    // its format, otherwise image describes the texture and the payload is
+    // left in the file. Safe to call from jobs.
+    Ref<VFile> OpenCookedTexture(const std::string& path, CookedTextureHeader& header, ImageData& image);
+
 private:
     GraphicsDevice* m_GraphicsDevice = nullptr;
     ResourceFactory* m_ResourceFactory = nullptr;
     std::unordered_map<std::string, std::weak_ptr<TextureView>> m_Textures;
+    std::unordered_map<std::string, std::weak_ptr<TextureHandle>> m_TextureHandles;
+
+    std::vector<Scope<PendingTexture>> m_PendingTextures;
+    Ref<TextureView> m_Placeholder = nullptr;
 
 };
 
 } // namespace aero3d
 
-#endif // AERO3D_RESOURCE_RESOURCEMANAGER_H_
\ No newline at end of file
+#endif // AERO3D_RESOURCE_RESOURCEMANAGER_H_
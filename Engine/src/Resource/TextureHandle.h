@@ -0,0 +1,28 @@
+#ifndef AERO3D_RESOURCE_TEXTUREHANDLE_H_
+#define AERO3D_RESOURCE_TEXTUREHANDLE_H_
+
+#include "Graphics/Resources.h"
+#include "Utils/Common.h"
+
+namespace aero3d {
+
+// Returned by asynchronous loads. Holds a placeholder view until the
+// texture is decoded and uploaded, the ResourceManager then swaps in the
+// real one on the main thread.
+class TextureHandle
+{
+public:
+    Ref<TextureView> GetView() const { return m_View; }
+    bool IsLoaded() const { return m_Loaded; }
+
+private:
+    friend class ResourceManager;
+
+    Ref<TextureView> m_View = nullptr;
+    bool m_Loaded = false;
+
+};
+
+} // namespace aero3d
+
+#endif // AERO3D_RESOURCE_TEXTUREHANDLE_H_
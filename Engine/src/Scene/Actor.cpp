@@ -1,5 +1,9 @@
 #include "Scene/Actor.h"
+
+#include <algorithm>
+
 #include "Scene/Components.h"
+#include "Scene/Scene.h"
 
 namespace aero3d {
 
@@ -13,9 +17,10 @@ Actor::~Actor()
 
 void Actor::Update(float deltaTime)
 {
-    for (auto& comp : m_Components)
+    // Only actors outside a scene still hold their components.
+    for (auto& pending : m_Components)
     {
-        comp->Update(deltaTime);
+        pending.component->Update(deltaTime);
     }
 }
 
@@ -29,6 +34,16 @@ Scene* Actor::GetScene() const
     return m_Scene;
 }
 
+void Actor::SetID(uint32_t id)
+{
+    m_ID = id;
+}
+
+uint32_t Actor::GetID() const
+{
+    return m_ID;
+}
+
 void Actor::SetRootComponent(SceneComponent* component)
 {
     m_RootComponent = component;
@@ -39,10 +54,65 @@ SceneComponent* Actor::GetRootComponent() const
     return m_RootComponent;
 }
 
-void Actor::AddComponent(std::unique_ptr<Component> component)
+void Actor::AddComponent(std::unique_ptr<Component> component, ComponentPoolFactory createPool)
 {
+    if (m_Scene)
+    {
+        m_Scene->AddComponent(this, std::move(component), createPool);
+        return;
+    }
+
     component->SetOwner(this);
-    m_Components.push_back(std::move(component));
+    m_Components.push_back({ std::move(component), createPool });
+}
+
+void Actor::RemoveComponent(Component* component)
+{
+    if (m_Scene)
+    {
+        m_Scene->RemoveComponent(this, component);
+        return;
+    }
+
+    if (m_RootComponent == component)
+    {
+        m_RootComponent = nullptr;
+    }
+
+    m_Components.erase(std::remove_if(m_Components.begin(), m_Components.end(),
+        [component](const PendingComponent& pending)
+        {
+            return pending.component.get() == component;
+        }), m_Components.end());
+}
+
+std::vector<Component*> Actor::GetComponents() const
+{
+    std::vector<Component*> components;
+    if (m_Scene)
+    {
+        m_Scene->GetComponents(m_ID, components);
+        return components;
+    }
+
+    for (const auto& pending : m_Components)
+    {
+        components.push_back(pending.component.get());
+    }
+    return components;
+}
+
+Component* Actor::FindComponent(std::type_index type, bool (*match)(Component*)) const
+{
+    if (m_Scene)
+        return m_Scene->FindComponent(m_ID, type, match);
+
+    for (const auto& pending : m_Components)
+    {
+        if (match(pending.component.get()))
+            return pending.component.get();
+    }
+    return nullptr;
 }
 
 } // namespace aero3d
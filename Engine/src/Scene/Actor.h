@@ -4,6 +4,10 @@
 #include <vector>
 #include <memory>
 #include <type_traits>
+#include <typeindex>
+#include <cstdint>
+
+#include "Scene/ComponentPool.h"
 
 namespace aero3d {
 
@@ -17,34 +21,73 @@ public:
     Actor();
     virtual ~Actor();
 
+    // Components of actors in a scene are updated by the scene.
     virtual void Update(float deltaTime);
 
     void SetScene(Scene* scene);
     Scene* GetScene() const;
 
+    void SetID(uint32_t id);
+    uint32_t GetID() const;
+
     void SetRootComponent(SceneComponent* component);
     SceneComponent* GetRootComponent() const;
 
-    void AddComponent(std::unique_ptr<Component> component);
+    // Held by the actor until it joins a scene, which moves the component's
+    // value into the pool for its type. One component per type and actor.
+    template<typename T>
+    void AddComponent(std::unique_ptr<T> component);
+    void RemoveComponent(Component* component);
+
+    std::vector<Component*> GetComponents() const;
 
     template<typename T>
     T* GetComponent();
 
+private:
+    friend class Scene;
+
+    struct PendingComponent
+    {
+        std::unique_ptr<Component> component;
+        // Null when the pool has to come from the scene's registry.
+        ComponentPoolFactory createPool = nullptr;
+    };
+
+    void AddComponent(std::unique_ptr<Component> component, ComponentPoolFactory createPool);
+    Component* FindComponent(std::type_index type, bool (*match)(Component*)) const;
+
 private:
     Scene* m_Scene = nullptr;
+    uint32_t m_ID = UINT32_MAX;
     SceneComponent* m_RootComponent = nullptr;
-    std::vector<std::unique_ptr<Component>> m_Components;
+    std::vector<PendingComponent> m_Components;
 };
 
 template<typename T>
-T* Actor::GetComponent() 
+void Actor::AddComponent(std::unique_ptr<T> component)
 {
-    for (auto& comp : m_Components) 
+    // Only a pointer to the concrete type can create its pool here.
+    ComponentPoolFactory createPool = nullptr;
+    if constexpr (!std::is_abstract_v<T> && std::is_move_constructible_v<T>)
     {
-        if (auto* casted = dynamic_cast<T*>(comp.get()))
-            return casted;
+        if (typeid(*component) == typeid(T))
+        {
+            createPool = &ComponentPool<T>::Create;
+        }
     }
-    return nullptr;
+
+    AddComponent(std::unique_ptr<Component>(std::move(component)), createPool);
+}
+
+template<typename T>
+T* Actor::GetComponent() 
+{
+    Component* component = FindComponent(typeid(T), [](Component* candidate)
+    {
+        return dynamic_cast<T*>(candidate) != nullptr;
+    });
+    return dynamic_cast<T*>(component);
 }
 
 } // namespace aero3d
@@ -0,0 +1,49 @@
+#include "Scene/ComponentPool.h"
+
+namespace aero3d {
+
+ComponentPoolBase::ComponentPoolBase(std::type_index type)
+    : m_Type(type)
+{
+}
+
+bool ComponentPoolBase::Contains(uint32_t actorId) const
+{
+    return actorId < m_Sparse.size() && m_Sparse[actorId] != UINT32_MAX;
+}
+
+Component* ComponentPoolBase::Get(uint32_t actorId)
+{
+    if (!Contains(actorId))
+        return nullptr;
+    return GetComponent(m_Sparse[actorId]);
+}
+
+void ComponentPoolBase::AddActor(uint32_t actorId, bool parallelUpdate)
+{
+    if (actorId >= m_Sparse.size())
+    {
+        m_Sparse.resize(actorId + 1, UINT32_MAX);
+    }
+
+    m_Sparse[actorId] = static_cast<uint32_t>(m_ActorIds.size());
+    m_ActorIds.push_back(actorId);
+
+    m_ParallelUpdates |= parallelUpdate;
+}
+
+uint32_t ComponentPoolBase::RemoveActor(uint32_t actorId)
+{
+    uint32_t index = m_Sparse[actorId];
+    uint32_t lastActorId = m_ActorIds.back();
+
+    m_ActorIds[index] = lastActorId;
+    m_Sparse[lastActorId] = index;
+
+    m_ActorIds.pop_back();
+    m_Sparse[actorId] = UINT32_MAX;
+
+    return index;
+}
+
+} // namespace aero3d
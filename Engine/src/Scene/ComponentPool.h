@@ -0,0 +1,116 @@
+#ifndef AERO3D_SCENE_COMPONENTPOOL_H_
+#define AERO3D_SCENE_COMPONENTPOOL_H_
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <typeindex>
+
+namespace aero3d {
+
+class Component;
+class ComponentPoolBase;
+
+using ComponentPoolFactory = std::unique_ptr<ComponentPoolBase>(*)();
+
+// Sparse set over the components of one concrete type: actor ids map to
+// dense indices, which the component array shares with m_ActorIds.
+class ComponentPoolBase
+{
+public:
+    ComponentPoolBase(std::type_index type);
+    virtual ~ComponentPoolBase() = default;
+
+    // Moves the component's value into the pool. Null if the actor already
+    // has a component of this type.
+    virtual Component* Insert(uint32_t actorId, std::unique_ptr<Component> component) = 0;
+    virtual void Remove(uint32_t actorId) = 0;
+    virtual Component* GetComponent(size_t index) = 0;
+
+    bool Contains(uint32_t actorId) const;
+    Component* Get(uint32_t actorId);
+
+    std::type_index GetType() const { return m_Type; }
+    size_t GetSize() const { return m_ActorIds.size(); }
+    const std::vector<uint32_t>& GetActorIds() const { return m_ActorIds; }
+
+    // Set once any component in the pool updated on job system workers.
+    bool HasParallelUpdates() const { return m_ParallelUpdates; }
+
+protected:
+    // Called after the component was appended to the dense array.
+    void AddActor(uint32_t actorId, bool parallelUpdate);
+    // Mirrors a swap-remove of the dense array, returns the removed index.
+    uint32_t RemoveActor(uint32_t actorId);
+
+private:
+    std::type_index m_Type;
+    bool m_ParallelUpdates = false;
+
+    std::vector<uint32_t> m_Sparse;
+    std::vector<uint32_t> m_ActorIds;
+
+};
+
+// Components of type T stored by value in one packed array, so walking a
+// pool touches contiguous memory. Removal moves the last component into the
+// gap. Adding or removing components relocates others of the same type.
+template<typename T>
+class ComponentPool : public ComponentPoolBase
+{
+public:
+    ComponentPool() : ComponentPoolBase(typeid(T)) {}
+
+    static std::unique_ptr<ComponentPoolBase> Create() { return std::make_unique<ComponentPool<T>>(); }
+
+    template<typename... Args>
+    T* Emplace(uint32_t actorId, Args&&... args);
+
+    virtual Component* Insert(uint32_t actorId, std::unique_ptr<Component> component) override;
+    virtual void Remove(uint32_t actorId) override;
+    virtual Component* GetComponent(size_t index) override { return &m_Components[index]; }
+
+    std::vector<T>& GetComponents() { return m_Components; }
+
+private:
+    std::vector<T> m_Components;
+
+};
+
+template<typename T>
+template<typename... Args>
+T* ComponentPool<T>::Emplace(uint32_t actorId, Args&&... args)
+{
+    if (Contains(actorId))
+        return nullptr;
+
+    T& component = m_Components.emplace_back(std::forward<Args>(args)...);
+    AddActor(actorId, component.SupportsParallelUpdate());
+    return &component;
+}
+
+template<typename T>
+Component* ComponentPool<T>::Insert(uint32_t actorId, std::unique_ptr<Component> component)
+{
+    return Emplace(actorId, std::move(static_cast<T&>(*component)));
+}
+
+template<typename T>
+void ComponentPool<T>::Remove(uint32_t actorId)
+{
+    if (!Contains(actorId))
+        return;
+
+    uint32_t index = RemoveActor(actorId);
+    if (index != m_Components.size() - 1)
+    {
+        m_Components[index] = std::move(m_Components.back());
+    }
+    m_Components.pop_back();
+}
+
+} // namespace aero3d
+
+#endif // AERO3D_SCENE_COMPONENTPOOL_H_
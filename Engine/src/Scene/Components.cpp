@@ -1,13 +1,83 @@
 #include "Scene/Components.h"
+
+#include <algorithm>
+
 #include "Scene/Actor.h"
+#include "Scene/Scene.h"
 
 namespace aero3d {
 
-glm::mat4 SceneComponent::GetWorldTransform() const 
+SceneComponent::SceneComponent(SceneComponent&& other) noexcept
+    : Component(std::move(other))
+{
+    TakeLinks(other);
+}
+
+SceneComponent& SceneComponent::operator=(SceneComponent&& other) noexcept
+{
+    if (this == &other)
+        return *this;
+
+    // Whatever this component was linked to loses it.
+    if (m_Parent)
+    {
+        auto& siblings = m_Parent->m_Children;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+    }
+    for (SceneComponent* child : m_Children)
+    {
+        child->m_Parent = nullptr;
+    }
+
+    Component::operator=(std::move(other));
+    TakeLinks(other);
+    return *this;
+}
+
+void SceneComponent::TakeLinks(SceneComponent& other)
 {
+    m_Parent = other.m_Parent;
+    m_Children = std::move(other.m_Children);
+    m_LocalTransform = other.m_LocalTransform;
+    m_WorldTransform = other.m_WorldTransform;
+    m_TransformDirty = other.m_TransformDirty;
+    m_TransformPass = other.m_TransformPass;
+
+    other.m_Parent = nullptr;
+    other.m_Children.clear();
+
     if (m_Parent)
-        return m_Parent->GetWorldTransform() * m_LocalTransform;
-    return m_LocalTransform;
+    {
+        std::replace(m_Parent->m_Children.begin(), m_Parent->m_Children.end(), &other, this);
+    }
+    for (SceneComponent* child : m_Children)
+    {
+        child->m_Parent = this;
+    }
+
+    if (m_Owner && m_Owner->GetRootComponent() == &other)
+    {
+        m_Owner->SetRootComponent(this);
+    }
+}
+
+void SceneComponent::SetLocalTransform(const glm::mat4& transform)
+{
+    m_LocalTransform = transform;
+    MarkTransformDirty();
+}
+
+const glm::mat4& SceneComponent::GetWorldTransform() const 
+{
+    if (m_TransformDirty)
+    {
+        if (m_Parent)
+            m_WorldTransform = m_Parent->GetWorldTransform() * m_LocalTransform;
+        else
+            m_WorldTransform = m_LocalTransform;
+        m_TransformDirty = false;
+    }
+    return m_WorldTransform;
 }
 
 void SceneComponent::AttachTo(SceneComponent* parent) 
@@ -16,6 +86,7 @@ void SceneComponent::AttachTo(SceneComponent* parent)
         Detach();
     m_Parent = parent;
     m_Parent->m_Children.push_back(this);
+    MarkTransformDirty();
 }
 
 void SceneComponent::Detach() 
@@ -24,6 +95,34 @@ void SceneComponent::Detach()
     auto& siblings = m_Parent->m_Children;
     siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
     m_Parent = nullptr;
+    MarkTransformDirty();
+}
+
+void SceneComponent::MarkTransformDirty()
+{
+    if (m_TransformDirty)
+        return;
+
+    m_TransformDirty = true;
+
+    Scene* scene = m_Owner ? m_Owner->GetScene() : nullptr;
+    if (scene)
+    {
+        scene->QueueTransformUpdate(this);
+    }
+
+    std::vector<SceneComponent*> stack(m_Children.begin(), m_Children.end());
+    while (!stack.empty())
+    {
+        SceneComponent* child = stack.back();
+        stack.pop_back();
+
+        if (child->m_TransformDirty)
+            continue;
+
+        child->m_TransformDirty = true;
+        stack.insert(stack.end(), child->m_Children.begin(), child->m_Children.end());
+    }
 }
 
 void CameraComponent::SetPerspective(float fov, float aspect, float nearClip, float farClip) 
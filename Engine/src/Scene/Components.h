@@ -8,19 +8,32 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "Graphics/Resources.h"
+#include "Resource/TextureHandle.h"
 
 namespace aero3d {
 
 class Actor;
+class Scene;
 
+// Scenes store components by value in per-type arrays, so every component
+// type has to be movable.
 class Component 
 {
 public:
+    Component() = default;
+    Component(Component&&) = default;
+    Component& operator=(Component&&) = default;
     virtual ~Component() = default;
+
     virtual void OnAttach() {}
     virtual void OnDetach() {}
     virtual void Update(float deltaTime) {}
 
+    // Components returning true are updated on job system workers, concurrently
+    // with other such components, and must not touch shared state. World
+    // transforms are resolved before that pass and may be read, not set.
+    virtual bool SupportsParallelUpdate() const { return false; }
+
     void SetOwner(Actor* owner) { m_Owner = owner; }
     Actor* GetOwner() const { return m_Owner; }
 
@@ -31,28 +44,64 @@ protected:
 class SceneComponent : public Component 
 {
 public:
-    void SetLocalTransform(const glm::mat4& transform) { m_LocalTransform = transform; }
+    SceneComponent() = default;
+    // Moving re-points the parent, the children and the owner's root at the
+    // new address, so the hierarchy survives pools relocating components.
+    SceneComponent(SceneComponent&& other) noexcept;
+    SceneComponent& operator=(SceneComponent&& other) noexcept;
+
+    void SetLocalTransform(const glm::mat4& transform);
     glm::mat4 GetLocalTransform() const { return m_LocalTransform; }
-    glm::mat4 GetWorldTransform() const;
+    const glm::mat4& GetWorldTransform() const;
 
     void AttachTo(SceneComponent* parent);
     void Detach();
 
+    bool IsTransformDirty() const { return m_TransformDirty; }
+
+protected:
+    void MarkTransformDirty();
+
 protected:
     SceneComponent* m_Parent = nullptr;
     std::vector<SceneComponent*> m_Children;
     glm::mat4 m_LocalTransform = glm::mat4(1.0f);
+
+    // A dirty component always has dirty descendants, so marking can stop
+    // at the first node that is already dirty.
+    mutable glm::mat4 m_WorldTransform = glm::mat4(1.0f);
+    mutable bool m_TransformDirty = true;
+
+private:
+    void TakeLinks(SceneComponent& other);
+
+private:
+    // Last Scene::UpdateTransforms pass that visited this component.
+    uint32_t m_TransformPass = 0;
+
+    friend class Scene;
     
 };
 
 class SpriteComponent : public SceneComponent 
 {
 public:
-    void SetTexture(Ref<TextureView> texture) { m_Texture = texture; }
-    Ref<TextureView> GetTexture() { return m_Texture; }
+    void SetTexture(Ref<TextureView> texture) { m_Texture = texture; m_TextureHandle = nullptr; }
+    void SetTexture(Ref<TextureHandle> texture) { m_TextureHandle = texture; m_Texture = nullptr; }
+    Ref<TextureView> GetTexture() { return m_TextureHandle ? m_TextureHandle->GetView() : m_Texture; }
+
+    void SetColor(const glm::vec4& color) { m_Color = color; }
+    const glm::vec4& GetColor() const { return m_Color; }
+
+    // Normalized (u0, v0, u1, v1) region of the texture, for atlases.
+    void SetUVRect(const glm::vec4& uvRect) { m_UVRect = uvRect; }
+    const glm::vec4& GetUVRect() const { return m_UVRect; }
 
 private:
     Ref<TextureView> m_Texture = nullptr;
+    Ref<TextureHandle> m_TextureHandle = nullptr;
+    glm::vec4 m_Color = glm::vec4(1.0f);
+    glm::vec4 m_UVRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
 
 };
 
@@ -1,11 +1,18 @@
 #include "Scene/Scene.h"
 #include "Scene/Actor.h"
 #include "Scene/Components.h"
+#include "Core/JobSystem.h"
+#include "Utils/Log.h"
+
+#include <algorithm>
 
 namespace aero3d {
 
+constexpr uint32_t PARALLEL_UPDATE_GROUP_SIZE = 64;
+
 std::unordered_map<std::size_t, std::function<std::unique_ptr<Actor>()>>  Scene::s_ActorRegistry;
 std::unordered_map<std::size_t, std::function<std::unique_ptr<Component>()>> Scene::s_ComponentRegistry;
+std::unordered_map<std::type_index, ComponentPoolFactory> Scene::s_PoolRegistry;
 
 Scene::Scene()
 {
@@ -24,15 +31,301 @@ Scene::~Scene()
 void Scene::AddActor(std::unique_ptr<Actor> actor) 
 {
     actor->SetScene(this);
+    actor->SetID(static_cast<uint32_t>(m_Actors.size()));
     m_Actors.emplace_back(std::move(actor));
+
+    Actor* added = m_Actors.back().get();
+    std::vector<Actor::PendingComponent> pending = std::move(added->m_Components);
+    added->m_Components.clear();
+
+    for (auto& entry : pending)
+    {
+        AddComponent(added, std::move(entry.component), entry.createPool);
+    }
+}
+
+Component* Scene::AddComponent(Actor* actor, std::unique_ptr<Component> component, ComponentPoolFactory createPool)
+{
+    component->SetOwner(actor);
+
+    if (m_Updating)
+    {
+        Component* deferred = component.get();
+        m_DeferredComponents.push_back({ actor, std::move(component), createPool });
+        return deferred;
+    }
+
+    std::type_index type = typeid(*component);
+
+    ComponentPoolBase* pool = GetPool(type, createPool);
+    if (!pool)
+    {
+        LogErr(ERROR_INFO, "Component type %s was never registered.", type.name());
+        return nullptr;
+    }
+
+    Component* added = pool->Insert(actor->GetID(), std::move(component));
+    OnComponentAdded(actor, pool, added);
+    return added;
+}
+
+void Scene::RemoveComponent(Actor* actor, Component* component)
+{
+    // Added during this update and not in a pool yet.
+    auto deferred = std::find_if(m_DeferredComponents.begin(), m_DeferredComponents.end(),
+        [component](const DeferredComponent& entry)
+        {
+            return entry.component.get() == component;
+        });
+    if (deferred != m_DeferredComponents.end())
+    {
+        m_DeferredComponents.erase(deferred);
+        return;
+    }
+
+    if (m_Updating)
+    {
+        m_DeferredRemovals.emplace_back(actor, component);
+        return;
+    }
+
+    auto it = m_PoolsByType.find(typeid(*component));
+    if (it == m_PoolsByType.end() || it->second->Get(actor->GetID()) != component)
+    {
+        LogErr(ERROR_INFO, "Component is not attached to actor %u.", actor->GetID());
+        return;
+    }
+
+    if (SceneComponent* sceneComponent = dynamic_cast<SceneComponent*>(component))
+    {
+        while (!sceneComponent->m_Children.empty())
+        {
+            sceneComponent->m_Children.back()->Detach();
+        }
+        sceneComponent->Detach();
+
+        if (actor->GetRootComponent() == sceneComponent)
+        {
+            actor->SetRootComponent(nullptr);
+        }
+    }
+
+    it->second->Remove(actor->GetID());
+}
+
+void Scene::GetComponents(uint32_t actorId, std::vector<Component*>& components)
+{
+    for (auto& pool : m_Pools)
+    {
+        if (Component* component = pool->Get(actorId))
+        {
+            components.push_back(component);
+        }
+    }
+
+    for (auto& entry : m_DeferredComponents)
+    {
+        if (entry.actor->GetID() == actorId)
+        {
+            components.push_back(entry.component.get());
+        }
+    }
+}
+
+Component* Scene::FindComponent(uint32_t actorId, std::type_index type, bool (*match)(Component*))
+{
+    // The pool of the exact type answers most lookups without a cast.
+    auto it = m_PoolsByType.find(type);
+    if (it != m_PoolsByType.end())
+    {
+        if (Component* component = it->second->Get(actorId))
+            return component;
+    }
+
+    for (auto& pool : m_Pools)
+    {
+        Component* component = pool->Get(actorId);
+        if (component && match(component))
+            return component;
+    }
+
+    for (auto& entry : m_DeferredComponents)
+    {
+        if (entry.actor->GetID() == actorId && match(entry.component.get()))
+            return entry.component.get();
+    }
+
+    return nullptr;
+}
+
+ComponentPoolBase* Scene::GetPool(std::type_index type, ComponentPoolFactory createPool)
+{
+    auto it = m_PoolsByType.find(type);
+    if (it != m_PoolsByType.end())
+        return it->second;
+
+    if (!createPool)
+    {
+        auto registered = s_PoolRegistry.find(type);
+        if (registered == s_PoolRegistry.end())
+            return nullptr;
+
+        createPool = registered->second;
+    }
+
+    m_Pools.push_back(createPool());
+    return m_PoolsByType.emplace(type, m_Pools.back().get()).first->second;
+}
+
+void Scene::OnComponentAdded(Actor* actor, ComponentPoolBase* pool, Component* component)
+{
+    if (!component)
+    {
+        LogErr(ERROR_INFO, "Actor %u already has a component of type %s.", actor->GetID(), pool->GetType().name());
+        return;
+    }
+
+    // Queries skip empty pools, this one may match now.
+    if (pool->GetSize() == 1)
+    {
+        m_PoolQueries.clear();
+    }
+
+    if (SceneComponent* sceneComponent = dynamic_cast<SceneComponent*>(component))
+    {
+        if (sceneComponent->IsTransformDirty())
+        {
+            QueueTransformUpdate(sceneComponent);
+        }
+    }
+}
+
+void Scene::FlushDeferredChanges()
+{
+    std::vector<std::pair<Actor*, Component*>> removals = std::move(m_DeferredRemovals);
+    m_DeferredRemovals.clear();
+
+    for (auto& [actor, component] : removals)
+    {
+        RemoveComponent(actor, component);
+    }
+
+    std::vector<DeferredComponent> additions = std::move(m_DeferredComponents);
+    m_DeferredComponents.clear();
+
+    for (auto& entry : additions)
+    {
+        AddComponent(entry.actor, std::move(entry.component), entry.createPool);
+    }
+}
+
+void Scene::QueueTransformUpdate(SceneComponent* component)
+{
+    // Components added during Update have no pool yet, they are queued
+    // once they are moved into it.
+    auto it = m_PoolsByType.find(typeid(*component));
+    if (it == m_PoolsByType.end())
+        return;
+
+    std::lock_guard<std::mutex> lock(m_DirtyTransformsMutex);
+    m_DirtyTransforms.push_back({ it->second, component->GetOwner()->GetID() });
+}
+
+void Scene::UpdateTransforms()
+{
+    m_TransformPass++;
+
+    for (const DirtyTransform& entry : m_DirtyTransforms)
+    {
+        // Null when the component was removed since it was queued.
+        auto* dirty = static_cast<SceneComponent*>(entry.pool->Get(entry.actorId));
+
+        // Already covered by the subtree of an earlier entry.
+        if (!dirty || dirty->m_TransformPass == m_TransformPass)
+            continue;
+
+        SceneComponent* root = dirty;
+        while (root->m_Parent && root->m_Parent->m_TransformDirty)
+        {
+            root = root->m_Parent;
+        }
+
+        m_TransformQueue.clear();
+        m_TransformQueue.push_back(root);
+
+        // A queued node may have been resolved by GetWorldTransform since,
+        // which leaves its descendants dirty. The whole subtree is walked
+        // and only dirty nodes are recomputed.
+        for (size_t i = 0; i < m_TransformQueue.size(); ++i)
+        {
+            SceneComponent* node = m_TransformQueue[i];
+            node->m_TransformPass = m_TransformPass;
+
+            if (node->m_TransformDirty)
+            {
+                if (node->m_Parent)
+                    node->m_WorldTransform = node->m_Parent->m_WorldTransform * node->m_LocalTransform;
+                else
+                    node->m_WorldTransform = node->m_LocalTransform;
+                node->m_TransformDirty = false;
+            }
+
+            m_TransformQueue.insert(m_TransformQueue.end(), node->m_Children.begin(), node->m_Children.end());
+        }
+    }
+
+    m_DirtyTransforms.clear();
 }
 
 void Scene::Update(float deltaTime) 
 {
+    // Parallel components may read world transforms, which must be clean so
+    // GetWorldTransform doesn't write to them from several workers.
+    UpdateTransforms();
+
+    m_Updating = true;
+
+    JobCounter counter;
+    for (auto& pool : m_Pools)
+    {
+        if (!pool->HasParallelUpdates())
+            continue;
+
+        ComponentPoolBase* parallelPool = pool.get();
+        JobSystem::Dispatch(counter, static_cast<uint32_t>(parallelPool->GetSize()), PARALLEL_UPDATE_GROUP_SIZE,
+            [parallelPool, deltaTime](uint32_t index)
+            {
+                Component* component = parallelPool->GetComponent(index);
+                if (component->SupportsParallelUpdate())
+                {
+                    component->Update(deltaTime);
+                }
+            });
+    }
+    JobSystem::Wait(counter);
+
+    // Pool by pool, so each update walks one packed array.
+    for (auto& pool : m_Pools)
+    {
+        for (size_t i = 0; i < pool->GetSize(); i++)
+        {
+            Component* component = pool->GetComponent(i);
+            if (!component->SupportsParallelUpdate())
+            {
+                component->Update(deltaTime);
+            }
+        }
+    }
+
     for (auto& actor : m_Actors) 
     {
         actor->Update(deltaTime);
     }
+
+    m_Updating = false;
+    FlushDeferredChanges();
+
+    UpdateTransforms();
 }
 
 }
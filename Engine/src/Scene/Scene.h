@@ -5,11 +5,19 @@
 #include <memory>
 #include <unordered_map>
 #include <functional>
+#include <typeindex>
+#include <tuple>
+#include <mutex>
+#include <type_traits>
 
 #include "Scene/Actor.h"
+#include "Scene/ComponentPool.h"
 
 namespace aero3d {
 
+// Components live in per-type pools rather than in their actors. A pointer
+// to a component stays valid until a component of the same type is added
+// to or removed from the scene outside of Update.
 class Scene 
 {
 public:
@@ -28,6 +36,8 @@ public:
 public:
     static std::unordered_map<std::size_t, std::function<std::unique_ptr<Actor>()>> s_ActorRegistry;
     static std::unordered_map<std::size_t, std::function<std::unique_ptr<Component>()>> s_ComponentRegistry;
+    // Lets components added through a base class pointer find their pool.
+    static std::unordered_map<std::type_index, ComponentPoolFactory> s_PoolRegistry;
 
 public:
     Scene();
@@ -36,8 +46,26 @@ public:
     void AddActor(std::unique_ptr<Actor> actor);
     void Update(float deltaTime);
 
+    // Moves the component's value into its pool. During Update the insert
+    // waits until the end of the frame and the component stays where it is.
+    Component* AddComponent(Actor* actor, std::unique_ptr<Component> component,
+        ComponentPoolFactory createPool = nullptr);
+    // Constructs the component in place, skipping the heap allocation.
+    template<typename T, typename... Args>
+    T* EmplaceComponent(Actor* actor, Args&&... args);
+    void RemoveComponent(Actor* actor, Component* component);
+
+    void GetComponents(uint32_t actorId, std::vector<Component*>& components);
+    Component* FindComponent(uint32_t actorId, std::type_index type, bool (*match)(Component*));
+
+    void QueueTransformUpdate(SceneComponent* component);
+    void UpdateTransforms();
+
     std::vector<std::unique_ptr<Actor>>& GetActors() { return m_Actors; };
 
+    template<typename T, typename Func>
+    void ForEachComponent(Func&& func);
+
     template<typename T>
     T* GetFirstComponentOfType();
 
@@ -50,9 +78,48 @@ public:
     template<typename... Ts>
     std::vector<Actor*> GetAllActorsWithComponents();
 
+private:
+    // Queued by pool and actor, component addresses change as pools grow.
+    struct DirtyTransform
+    {
+        ComponentPoolBase* pool = nullptr;
+        uint32_t actorId = 0;
+    };
+
+    struct DeferredComponent
+    {
+        Actor* actor = nullptr;
+        std::unique_ptr<Component> component;
+        ComponentPoolFactory createPool = nullptr;
+    };
+
+    ComponentPoolBase* GetPool(std::type_index type, ComponentPoolFactory createPool);
+    void OnComponentAdded(Actor* actor, ComponentPoolBase* pool, Component* component);
+    void FlushDeferredChanges();
+
+    template<typename T>
+    const std::vector<ComponentPoolBase*>& GetPoolsOfType();
+
+    template<typename T>
+    bool HasComponent(uint32_t actorId);
+
 private:
     std::vector<std::unique_ptr<Actor>> m_Actors;
 
+    std::vector<std::unique_ptr<ComponentPoolBase>> m_Pools;
+    std::unordered_map<std::type_index, ComponentPoolBase*> m_PoolsByType;
+    std::unordered_map<std::type_index, std::vector<ComponentPoolBase*>> m_PoolQueries;
+
+    // Pools must not move components while they update.
+    bool m_Updating = false;
+    std::vector<DeferredComponent> m_DeferredComponents;
+    std::vector<std::pair<Actor*, Component*>> m_DeferredRemovals;
+
+    std::mutex m_DirtyTransformsMutex;
+    std::vector<DirtyTransform> m_DirtyTransforms;
+    std::vector<SceneComponent*> m_TransformQueue;
+    uint32_t m_TransformPass = 0;
+
 };
 
 template<typename T>
@@ -71,6 +138,7 @@ void Scene::RegisterComponent()
     {
         return std::make_unique<T>();
     };
+    s_PoolRegistry[typeid(T)] = &ComponentPool<T>::Create;
 }
 
 template<typename T>
@@ -95,43 +163,128 @@ std::unique_ptr<T> Scene::CreateComponent()
     return nullptr;
 }
 
+template<typename T, typename... Args>
+T* Scene::EmplaceComponent(Actor* actor, Args&&... args)
+{
+    if (m_Updating)
+    {
+        auto component = std::make_unique<T>(std::forward<Args>(args)...);
+        return static_cast<T*>(AddComponent(actor, std::move(component), &ComponentPool<T>::Create));
+    }
+
+    auto* pool = static_cast<ComponentPool<T>*>(GetPool(typeid(T), &ComponentPool<T>::Create));
+
+    T* component = pool->Emplace(actor->GetID(), std::forward<Args>(args)...);
+    if (component)
+    {
+        component->SetOwner(actor);
+    }
+
+    OnComponentAdded(actor, pool, component);
+    return component;
+}
+
 template<typename T>
-T* Scene::GetFirstComponentOfType() 
+const std::vector<ComponentPoolBase*>& Scene::GetPoolsOfType()
 {
-    for (auto& actor : m_Actors) 
+    auto it = m_PoolQueries.find(typeid(T));
+    if (it != m_PoolQueries.end())
     {
-        if (T* comp = actor->GetComponent<T>()) 
+        return it->second;
+    }
+
+    // Every component in a pool shares one concrete type, so a single cast
+    // per pool decides whether the whole pool matches T. Empty pools can't
+    // be cast and are left out until their first component clears this.
+    std::vector<ComponentPoolBase*> pools;
+    for (auto& pool : m_Pools)
+    {
+        if (pool->GetSize() > 0 && dynamic_cast<T*>(pool->GetComponent(0)))
         {
-            return comp;
+            pools.push_back(pool.get());
         }
     }
-    return nullptr;
+
+    return m_PoolQueries.emplace(typeid(T), std::move(pools)).first->second;
 }
 
 template<typename T>
-Actor* Scene::GetFirstActorWithComponent() 
+bool Scene::HasComponent(uint32_t actorId)
 {
-    for (auto& actor : m_Actors)
+    for (ComponentPoolBase* pool : GetPoolsOfType<T>())
     {
-        if (actor->GetComponent<T>()) 
+        if (pool->Contains(actorId))
         {
-            return actor.get();
+            return true;
         }
     }
+    return false;
+}
+
+template<typename T, typename Func>
+void Scene::ForEachComponent(Func&& func)
+{
+    for (ComponentPoolBase* pool : GetPoolsOfType<T>())
+    {
+        // A pool of exactly T is walked as the packed array it is.
+        if constexpr (!std::is_abstract_v<T>)
+        {
+            if (pool->GetType() == typeid(T))
+            {
+                for (T& comp : static_cast<ComponentPool<T>*>(pool)->GetComponents())
+                {
+                    func(&comp);
+                }
+                continue;
+            }
+        }
+
+        for (size_t i = 0; i < pool->GetSize(); i++)
+        {
+            func(static_cast<T*>(pool->GetComponent(i)));
+        }
+    }
+}
+
+template<typename T>
+T* Scene::GetFirstComponentOfType() 
+{
+    for (ComponentPoolBase* pool : GetPoolsOfType<T>())
+    {
+        if (pool->GetSize() > 0)
+            return static_cast<T*>(pool->GetComponent(0));
+    }
+    return nullptr;
+}
+
+template<typename T>
+Actor* Scene::GetFirstActorWithComponent() 
+{
+    for (ComponentPoolBase* pool : GetPoolsOfType<T>())
+    {
+        if (pool->GetSize() > 0)
+            return m_Actors[pool->GetActorIds().front()].get();
+    }
     return nullptr;
 }
 
 template<typename T>
 std::vector<T*> Scene::GetAllComponentsOfType() 
 {
-    std::vector<T*> result;
-    for (auto& actor : m_Actors)
+    const std::vector<ComponentPoolBase*>& pools = GetPoolsOfType<T>();
+
+    size_t count = 0;
+    for (ComponentPoolBase* pool : pools)
     {
-        if (T* comp = actor->GetComponent<T>()) 
-        {
-            result.push_back(comp);
-        }
+        count += pool->GetSize();
     }
+
+    std::vector<T*> result;
+    result.reserve(count);
+    ForEachComponent<T>([&result](T* comp)
+    {
+        result.push_back(comp);
+    });
     return result;
 }
 
@@ -140,11 +293,25 @@ std::vector<Actor*> Scene::GetAllActorsWithComponents()
 {
     std::vector<Actor*> result;
 
-    for (auto& actor : m_Actors) 
+    if constexpr (sizeof...(Ts) > 0)
     {
-        if ((actor->GetComponent<Ts>() && ...)) 
+        using First = std::tuple_element_t<0, std::tuple<Ts...>>;
+
+        std::vector<bool> visited(m_Actors.size(), false);
+
+        for (ComponentPoolBase* pool : GetPoolsOfType<First>())
         {
-            result.push_back(actor.get());
+            for (uint32_t actorId : pool->GetActorIds())
+            {
+                if (visited[actorId])
+                    continue;
+                visited[actorId] = true;
+
+                if ((HasComponent<Ts>(actorId) && ...))
+                {
+                    result.push_back(m_Actors[actorId].get());
+                }
+            }
         }
     }
 
@@ -1,15 +1,36 @@
 #include "Systems/RenderSystem.h"
 
+#include <algorithm>
+
+#include <glm/gtc/packing.hpp>
+
+#include "Core/JobSystem.h"
 #include "Scene/Components.h"
+#include "Utils/Assert.h"
+#include "Utils/Log.h"
 
 namespace aero3d {
 
+static void WriteSpriteInstance(SpriteInstance& instance, const glm::mat4& transform,
+    const glm::vec4& color, const glm::vec4& uvRect, uint32_t texIndex)
+{
+    instance.axisX = glm::vec3(transform[0]);
+    instance.axisY = glm::vec3(transform[1]);
+    instance.translation = glm::vec3(transform[3]);
+    instance.uvRect = glm::packUnorm<uint16_t>(glm::clamp(uvRect, 0.0f, 1.0f));
+    instance.color = glm::packUnorm4x8(color);
+    instance.texIndex = texIndex;
+}
+
 RenderSystem::RenderSystem(GraphicsDevice* graphicsDevice, ResourceFactory* resourceFactory)
 {
     m_GraphicsDevice = graphicsDevice;
     m_ResourceFactory = resourceFactory;
 
     m_CommandList = graphicsDevice->CreateCommandList();
+    m_ResourceSetCache = std::make_unique<ResourceSetCache>(resourceFactory);
+    m_BindlessTable = graphicsDevice->GetBindlessTextureTable();
+    m_RenderGraph = std::make_unique<RenderGraph>(graphicsDevice, resourceFactory);
 
     Prepare2D();
 }
@@ -21,43 +42,106 @@ RenderSystem::~RenderSystem()
 
 void RenderSystem::Render(Scene* scene)
 {
+    if (!m_GraphicsDevice->BeginFrame())
+        return;
+
+    Ref<Framebuffer> framebuffer = m_GraphicsDevice->GetSwapchain()->GetFramebuffer();
+    FramebufferDesc& framebufferDesc = framebuffer->GetDescription();
+
+    // Both targets are cleared, what the previous frame left in them is
+    // never needed.
+    RenderGraphResource backbuffer = m_RenderGraph->ImportTexture(framebufferDesc.colorTargets[0],
+        ResourceState::Present, ResourceState::Present, false);
+    RenderGraphResource depth = m_RenderGraph->ImportTexture(framebufferDesc.depthTarget,
+        ResourceState::DepthStencilWrite, ResourceState::DepthStencilWrite, false);
+
+    m_RenderGraph->AddPass("Sprites", [this, scene, framebuffer](Ref<CommandList> commandList)
+    {
+        RenderPassDesc renderPass;
+        renderPass.framebuffer = framebuffer;
+        renderPass.colorLoadOp = LoadOp::Clear;
+        renderPass.depthLoadOp = LoadOp::Clear;
+        // The bindless sprite path fills the pass from secondary lists only.
+        renderPass.secondaryContents = m_BindlessTable != nullptr;
+
+        commandList->BeginRenderPass(renderPass);
+        SpritePass(scene);
+        commandList->EndRenderPass();
+    })
+        .Write(backbuffer, ResourceState::RenderTarget)
+        .Write(depth, ResourceState::DepthStencilWrite);
+
+    // The whole frame is recorded into one list and submitted once.
     m_CommandList->Begin();
-    m_CommandList->SetFramebuffer(m_GraphicsDevice->GetSwapchain()->GetFramebuffer());
-    m_CommandList->ClearRenderTargets(0.0f, 0.0f, 0.0f, 1.0f);
-    m_CommandList->ClearDepthStencil();
+    m_RenderGraph->Execute(m_CommandList);
     m_CommandList->End();
     m_GraphicsDevice->SubmitCommands(m_CommandList);
-    SpritePass(scene);
-    m_GraphicsDevice->Present();
+
+    m_GraphicsDevice->EndFrame();
 }
 
 void RenderSystem::SpritePass(Scene* scene)
 {
+    m_Sprites.clear();
+    scene->ForEachComponent<SpriteComponent>([&](SpriteComponent* sprite)
+    {
+        m_Sprites.push_back(sprite);
+    });
+
+    ReserveSpriteInstances(static_cast<uint32_t>(m_Sprites.size()));
+
+    m_SpriteInstances = static_cast<SpriteInstance*>(m_GraphicsDevice->MapBuffer(m_SpriteInstanceBuffer));
+    m_InstanceCount = 0;
+
+    if (m_BindlessTable != nullptr)
+    {
+        // Written here, not on the workers: GetWorldTransform may lazily
+        // update dirty ancestors shared between chunks, and registering a
+        // texture modifies the bindless table.
+        for (uint32_t i = 0; i < m_Sprites.size(); ++i)
+        {
+            SpriteComponent* sprite = m_Sprites[i];
+            WriteSpriteInstance(m_SpriteInstances[i], sprite->GetWorldTransform(),
+                sprite->GetColor(), sprite->GetUVRect(), GetBindlessIndex(sprite->GetTexture()));
+        }
+
+        RecordSpritesParallel();
+        return;
+    }
+
     BeginBatch();
-    for (auto& sprite : scene->GetAllComponentsOfType<SpriteComponent>())
+    for (SpriteComponent* sprite : m_Sprites)
     {
-        DrawQuad(sprite->GetWorldTransform(), sprite->GetTexture());
+        DrawQuad(sprite->GetWorldTransform(), sprite->GetTexture(), sprite->GetColor(), sprite->GetUVRect());
     }
     Flush();
 }
 
 void RenderSystem::BeginBatch()
 {
-    m_VertexCount = 0;
+    m_BatchStart = m_InstanceCount;
     m_TextureSlotIndex = 0;
 }
 
 void RenderSystem::Flush()
 {
-    if (m_VertexCount == 0)
+    if (m_InstanceCount == m_BatchStart)
         return;
 
-    m_GraphicsDevice->UpdateBuffer(
-        m_SpriteVertexBuffer,
-        m_SpriteVertices.data(),
-        m_VertexCount * sizeof(SpriteVertex)
-    );
+    Ref<ResourceSet> resourceSet = m_BindlessTable != nullptr
+        ? m_BindlessTable->GetResourceSet()
+        : GetSlotResourceSet();
 
+    m_CommandList->SetPipeline(m_SpritePipeline);
+    m_CommandList->SetResourceSet(0, resourceSet);
+    m_CommandList->SetVertexBuffer(0, m_SpriteVertexBuffer);
+    m_CommandList->SetVertexBuffer(1, m_SpriteInstanceBuffer);
+    m_CommandList->SetIndexBuffer(m_SpriteIndexBuffer, IndexFormat::UnsignedShort);
+    m_CommandList->DrawIndexed(INDICES_PER_QUAD, m_InstanceCount - m_BatchStart, 0, 0, m_BatchStart);
+}
+
+Ref<ResourceSet> RenderSystem::GetSlotResourceSet()
+{
     std::vector<Ref<TextureView>> textures;
 
     Ref<TextureView> lastValidTexture = nullptr;
@@ -80,80 +164,134 @@ void RenderSystem::Flush()
     setDesc.layout = m_SpriteResourceLayout;
     setDesc.resources = { m_SpriteTextureSampler, textures };
 
-    Ref<ResourceSet> resourceSet = m_ResourceFactory->CreateResourceSet(setDesc);
-
-    m_CommandList->Begin();
-    m_CommandList->SetFramebuffer(m_GraphicsDevice->GetSwapchain()->GetFramebuffer());
-    m_CommandList->SetPipeline(m_SpritePipeline);
-    m_CommandList->SetResourceSet(0, resourceSet);
-    m_CommandList->SetVertexBuffer(m_SpriteVertexBuffer);
-    m_CommandList->Draw(m_VertexCount);
-    m_CommandList->End();
-    m_GraphicsDevice->SubmitCommands(m_CommandList);
+    return m_ResourceSetCache->GetOrCreate(setDesc);
 }
 
-void RenderSystem::DrawQuad(const glm::mat4& transform, Ref<TextureView> texture)
+uint32_t RenderSystem::GetTextureSlot(Ref<TextureView> texture)
 {
-    if (m_VertexCount + 6 > MAX_VERTICES)
+    for (uint32_t i = 0; i < m_TextureSlotIndex; ++i)
+    {
+        if (m_TextureSlots[i] == texture)
+            return i;
+    }
+
+    if (m_TextureSlotIndex >= MAX_TEXTURE_SLOTS)
     {
         Flush();
         BeginBatch();
     }
 
-    float textureIndex = -1.0f;
-    for (uint32_t i = 0; i < m_TextureSlotIndex; ++i)
+    m_TextureSlots[m_TextureSlotIndex] = texture;
+    return m_TextureSlotIndex++;
+}
+
+uint32_t RenderSystem::GetBindlessIndex(Ref<TextureView> texture)
+{
+    if (!texture)
     {
-        if (m_TextureSlots[i] == texture)
-        {
-            textureIndex = static_cast<float>(i);
-            break;
-        }
+        texture = m_WhiteTexture;
     }
 
-    if (textureIndex == -1.0f)
+    uint32_t index = texture->GetBindlessIndex();
+    if (index == INVALID_BINDLESS_INDEX)
     {
-        if (m_TextureSlotIndex >= MAX_TEXTURE_SLOTS)
-        {
-            Flush();
-            BeginBatch();
-        }
-
-        textureIndex = static_cast<float>(m_TextureSlotIndex);
-        m_TextureSlots[m_TextureSlotIndex++] = texture;
+        // Views created outside the ResourceManager are registered lazily.
+        index = m_BindlessTable->Register(texture);
     }
 
-    glm::vec4 quadVerts[4] = 
+    return index == INVALID_BINDLESS_INDEX ? 0 : index;
+}
+
+void RenderSystem::DrawQuad(const glm::mat4& transform, Ref<TextureView> texture,
+    const glm::vec4& color, const glm::vec4& uvRect)
+{
+    if (m_InstanceCount >= m_InstanceCapacity)
     {
-        { -0.5f, -0.5f, 0.0f, 1.0f },
-        {  0.5f, -0.5f, 0.0f, 1.0f },
-        {  0.5f,  0.5f, 0.0f, 1.0f },
-        { -0.5f,  0.5f, 0.0f, 1.0f },
-    };
+        LogErr(ERROR_INFO, "Sprite instance buffer is full, reserve before drawing.");
+        return;
+    }
 
-    glm::vec2 uvs[4] = 
+    if (!texture)
     {
-        { 0.0f, 0.0f },
-        { 1.0f, 0.0f },
-        { 1.0f, 1.0f },
-        { 0.0f, 1.0f },
-    };
+        texture = m_WhiteTexture;
+    }
 
-    uint32_t order[6] = { 0, 1, 2, 2, 3, 0 };
+    uint32_t texIndex = m_BindlessTable != nullptr
+        ? GetBindlessIndex(texture)
+        : GetTextureSlot(texture);
 
-    for (uint32_t i = 0; i < 6; ++i)
+    WriteSpriteInstance(m_SpriteInstances[m_InstanceCount++], transform, color, uvRect, texIndex);
+}
+
+void RenderSystem::ReserveSpriteInstances(uint32_t count)
+{
+    if (count <= m_InstanceCapacity)
+        return;
+
+    while (m_InstanceCapacity < count)
     {
-        uint32_t v = order[i];
-        glm::vec4 worldPos = transform * quadVerts[v];
+        m_InstanceCapacity *= 2;
+    }
 
-        SpriteVertex vertex;
-        vertex.position = glm::vec3(worldPos);
-        vertex.uv = uvs[v];
-        vertex.texIndex = textureIndex;
+    // Only happens while the scene grows. Frames in flight still read the
+    // old buffer, so it can't be released before they are done.
+    m_GraphicsDevice->WaitIdle();
 
-        m_SpriteVertices[m_VertexCount++] = vertex;
+    BufferDesc bufferDesc;
+    bufferDesc.usage = USAGE_VERTEX;
+    bufferDesc.size = m_InstanceCapacity * sizeof(SpriteInstance);
+    bufferDesc.dynamic = true;
+
+    m_SpriteInstanceBuffer = m_ResourceFactory->CreateBuffer(bufferDesc);
+    Assert(ERROR_INFO, m_SpriteInstanceBuffer->IsValid(), "Failed to create the sprite instance buffer!");
+}
+
+void RenderSystem::RecordSpritesParallel()
+{
+    Ref<Framebuffer> framebuffer = m_GraphicsDevice->GetSwapchain()->GetFramebuffer();
+    uint32_t count = static_cast<uint32_t>(m_Sprites.size());
+
+    if (count == 0)
+        return;
+
+    uint32_t maxJobs = std::max(1u, count / MIN_SPRITES_PER_JOB);
+    uint32_t jobCount = std::min(JobSystem::GetThreadCount(), maxJobs);
+    uint32_t spritesPerJob = (count + jobCount - 1) / jobCount;
+    jobCount = (count + spritesPerJob - 1) / spritesPerJob;
+
+    while (m_SecondaryCommandLists.size() < jobCount)
+    {
+        m_SecondaryCommandLists.push_back(m_GraphicsDevice->CreateCommandList(CommandListLevel::Secondary));
     }
 
-    m_VertexCount += 6;
+    JobCounter counter;
+    JobSystem::Dispatch(counter, jobCount, 1, [&](uint32_t job)
+    {
+        uint32_t begin = job * spritesPerJob;
+        uint32_t end = std::min(begin + spritesPerJob, count);
+
+        RecordSpriteChunk(m_SecondaryCommandLists[job], framebuffer, begin, end - begin);
+    });
+    JobSystem::Wait(counter);
+
+    std::vector<Ref<CommandList>> commandLists(m_SecondaryCommandLists.begin(),
+        m_SecondaryCommandLists.begin() + jobCount);
+
+    m_CommandList->ExecuteCommands(commandLists);
+    m_InstanceCount = count;
+}
+
+void RenderSystem::RecordSpriteChunk(Ref<CommandList> commandList, Ref<Framebuffer> framebuffer,
+    uint32_t firstInstance, uint32_t count)
+{
+    commandList->BeginSecondary(framebuffer);
+    commandList->SetPipeline(m_SpritePipeline);
+    commandList->SetResourceSet(0, m_BindlessTable->GetResourceSet());
+    commandList->SetVertexBuffer(0, m_SpriteVertexBuffer);
+    commandList->SetVertexBuffer(1, m_SpriteInstanceBuffer);
+    commandList->SetIndexBuffer(m_SpriteIndexBuffer, IndexFormat::UnsignedShort);
+    commandList->DrawIndexed(INDICES_PER_QUAD, count, 0, 0, firstInstance);
+    commandList->End();
 }
 
 void RenderSystem::Prepare2D()
@@ -165,19 +303,26 @@ void RenderSystem::Prepare2D()
 
     Ref<Shader> vertexShader = m_ResourceFactory->CreateShader(shaderDescription);
 
-    shaderDescription.path = "res/shaders/pixel";
+    shaderDescription.path = m_BindlessTable != nullptr ? "res/shaders/pixel_bindless" : "res/shaders/pixel";
     shaderDescription.stage = STAGE_FRAGMENT;
 
     Ref<Shader> fragmentShader = m_ResourceFactory->CreateShader(shaderDescription);
 
-    ResourceLayoutDesc layoutDescription;
-    layoutDescription.bindings = 
+    if (m_BindlessTable != nullptr)
     {
-        {0, ResourceKind::Sampler, STAGE_FRAGMENT},
-        {1, ResourceKind::TextureReadOnlyArray, STAGE_FRAGMENT, MAX_TEXTURE_SLOTS},
-    };
+        m_SpriteResourceLayout = m_BindlessTable->GetResourceLayout();
+    }
+    else
+    {
+        ResourceLayoutDesc layoutDescription;
+        layoutDescription.bindings = 
+        {
+            {0, ResourceKind::Sampler, STAGE_FRAGMENT},
+            {1, ResourceKind::TextureReadOnlyArray, STAGE_FRAGMENT, MAX_TEXTURE_SLOTS},
+        };
 
-    m_SpriteResourceLayout = m_ResourceFactory->CreateResourceLayout(layoutDescription);
+        m_SpriteResourceLayout = m_ResourceFactory->CreateResourceLayout(layoutDescription);
+    }
 
     PipelineDesc pipelineDescription;
     pipelineDescription.vertexShader = vertexShader;
@@ -186,14 +331,19 @@ void RenderSystem::Prepare2D()
 
     pipelineDescription.vertexLayout.bindings = 
     {
-        { 0, sizeof(SpriteVertex), false }
+        { 0, sizeof(SpriteVertex), false },
+        { 1, sizeof(SpriteInstance), true }
     };
 
     pipelineDescription.vertexLayout.attributes = 
     {
-        { 0, 0, VertexFormat::Float3, offsetof(SpriteVertex, position) },
-        { 1, 0, VertexFormat::Float2, offsetof(SpriteVertex, uv) },
-        { 2, 0, VertexFormat::Float, offsetof(SpriteVertex, texIndex) }
+        { 0, 0, VertexFormat::Float2, offsetof(SpriteVertex, corner) },
+        { 1, 1, VertexFormat::Float3, offsetof(SpriteInstance, axisX) },
+        { 2, 1, VertexFormat::Float3, offsetof(SpriteInstance, axisY) },
+        { 3, 1, VertexFormat::Float3, offsetof(SpriteInstance, translation) },
+        { 4, 1, VertexFormat::UShort4Norm, offsetof(SpriteInstance, uvRect) },
+        { 5, 1, VertexFormat::UByte4Norm, offsetof(SpriteInstance, color) },
+        { 6, 1, VertexFormat::UInt, offsetof(SpriteInstance, texIndex) }
     };
 
     pipelineDescription.topology = PrimitiveTopology::TriangleList;
@@ -206,18 +356,62 @@ void RenderSystem::Prepare2D()
 
     m_SpritePipeline = m_ResourceFactory->CreatePipeline(pipelineDescription);
 
+    SpriteVertex quadVertices[VERTICES_PER_QUAD] = 
+    {
+        { { -0.5f, -0.5f } },
+        { {  0.5f, -0.5f } },
+        { {  0.5f,  0.5f } },
+        { { -0.5f,  0.5f } },
+    };
+
+    uint16_t quadIndices[INDICES_PER_QUAD] = { 0, 1, 2, 2, 3, 0 };
+
     BufferDesc bufferDesc;
     bufferDesc.usage = USAGE_VERTEX;
-    bufferDesc.size = MAX_VERTICES * sizeof(SpriteVertex);
+    bufferDesc.size = sizeof(quadVertices);
 
     m_SpriteVertexBuffer = m_ResourceFactory->CreateBuffer(bufferDesc);
-    m_SpriteVertices.resize(MAX_VERTICES);
+    Assert(ERROR_INFO, m_SpriteVertexBuffer->IsValid(), "Failed to create the sprite vertex buffer!");
+    m_GraphicsDevice->UpdateBuffer(m_SpriteVertexBuffer, quadVertices, sizeof(quadVertices));
+
+    bufferDesc.usage = USAGE_INDEX;
+    bufferDesc.size = sizeof(quadIndices);
+
+    m_SpriteIndexBuffer = m_ResourceFactory->CreateBuffer(bufferDesc);
+    Assert(ERROR_INFO, m_SpriteIndexBuffer->IsValid(), "Failed to create the sprite index buffer!");
+    m_GraphicsDevice->UpdateBuffer(m_SpriteIndexBuffer, quadIndices, sizeof(quadIndices));
+
+    bufferDesc.usage = USAGE_VERTEX;
+    bufferDesc.size = m_InstanceCapacity * sizeof(SpriteInstance);
+    bufferDesc.dynamic = true;
+
+    m_SpriteInstanceBuffer = m_ResourceFactory->CreateBuffer(bufferDesc);
+    Assert(ERROR_INFO, m_SpriteInstanceBuffer->IsValid(), "Failed to create the sprite instance buffer!");
 
     SamplerDesc textureSamplerDescription;
     textureSamplerDescription.filter = SamplerFilter::Linear;
+    textureSamplerDescription.mipmapMode = SamplerFilter::Linear;
+    textureSamplerDescription.maxLod = SAMPLER_LOD_CLAMP_NONE;
     textureSamplerDescription.addressModeU = SamplerAddressMode::Repeat;
 
     m_SpriteTextureSampler = m_ResourceFactory->CreateSampler(textureSamplerDescription);
+
+    TextureDesc whiteDescription;
+    whiteDescription.width = 1;
+    whiteDescription.height = 1;
+    whiteDescription.format = TextureFormat::RGBA8;
+    whiteDescription.usage = TextureUsage::Sampled;
+
+    Ref<Texture> whiteTexture = m_ResourceFactory->CreateTexture(whiteDescription);
+    Assert(ERROR_INFO, whiteTexture->IsValid(), "Failed to create the white texture!");
+    uint8_t whitePixel[4] = { 255, 255, 255, 255 };
+    m_GraphicsDevice->UpdateTexture(whiteTexture, whitePixel, sizeof(whitePixel));
+
+    TextureViewDesc whiteViewDescription;
+    whiteViewDescription.texture = whiteTexture;
+    whiteViewDescription.format = TextureFormat::RGBA8;
+
+    m_WhiteTexture = m_ResourceFactory->CreateTextureView(whiteViewDescription);
 }
 
 } // namespace aero3d
\ No newline at end of file
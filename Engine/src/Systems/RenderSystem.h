@@ -1,25 +1,44 @@
 #ifndef AERO3D_SYSTEMS_RENDERSYSTEM_H_
 #define AERO3D_SYSTEMS_RENDERSYSTEM_H_
 
+#include <vector>
+
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
 
+#include "Graphics/BindlessTextureTable.h"
 #include "Graphics/GraphicsDevice.h"
+#include "Graphics/RenderGraph.h"
 #include "Graphics/ResourceFactory.h"
+#include "Graphics/ResourceSetCache.h"
 #include "Scene/Scene.h"
 
 namespace aero3d {
 
+class SpriteComponent;
+
 struct SpriteVertex 
 {
-    glm::vec3 position;
-    glm::vec2 uv;
-    float texIndex;
+    glm::vec2 corner;
+};
+
+// The vertex shader expands the unit quad with the sprite's X/Y axes and
+// translation, which is all of the world transform a flat quad needs.
+struct SpriteInstance
+{
+    glm::vec3 axisX;
+    glm::vec3 axisY;
+    glm::vec3 translation;
+    glm::u16vec4 uvRect;
+    uint32_t color;
+    uint32_t texIndex;
 };
 
 constexpr uint32_t MAX_TEXTURE_SLOTS = 32;
-constexpr uint32_t MAX_QUADS = 1000;
-constexpr uint32_t VERTICES_PER_QUAD = 6;
-constexpr uint32_t MAX_VERTICES = MAX_QUADS * VERTICES_PER_QUAD;    
+constexpr uint32_t INITIAL_SPRITE_CAPACITY = 1024;
+constexpr uint32_t VERTICES_PER_QUAD = 4;
+constexpr uint32_t INDICES_PER_QUAD = 6;
+constexpr uint32_t MIN_SPRITES_PER_JOB = 256;
 
 class RenderSystem
 {
@@ -34,25 +53,53 @@ public:
     void BeginBatch();
     void Flush();
 
-    void DrawQuad(const glm::mat4& transform, Ref<TextureView> texture);
+    void DrawQuad(const glm::mat4& transform, Ref<TextureView> texture,
+        const glm::vec4& color = glm::vec4(1.0f), const glm::vec4& uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
 
 private:
     void Prepare2D();
 
+    // Bindless only: sprites need no per-batch texture slots, so chunks of
+    // them can be recorded into secondary lists on the job system. The
+    // instances must already be written, workers only record draws.
+    void RecordSpritesParallel();
+    void RecordSpriteChunk(Ref<CommandList> commandList, Ref<Framebuffer> framebuffer,
+        uint32_t firstInstance, uint32_t count);
+
+    // Grows the instance buffer up front, a frame can't wrap it because
+    // all of its draws execute after recording finished.
+    void ReserveSpriteInstances(uint32_t count);
+
+    Ref<ResourceSet> GetSlotResourceSet();
+    uint32_t GetTextureSlot(Ref<TextureView> texture);
+    uint32_t GetBindlessIndex(Ref<TextureView> texture);
+
 private:
     GraphicsDevice* m_GraphicsDevice = nullptr;
     ResourceFactory* m_ResourceFactory = nullptr;
 
     Ref<CommandList> m_CommandList = nullptr;
+    std::vector<Ref<CommandList>> m_SecondaryCommandLists;
 
     Ref<ResourceLayout> m_SpriteResourceLayout = nullptr;
     Ref<Pipeline> m_SpritePipeline = nullptr;
     Ref<DeviceBuffer> m_SpriteVertexBuffer = nullptr;
+    Ref<DeviceBuffer> m_SpriteIndexBuffer = nullptr;
+    Ref<DeviceBuffer> m_SpriteInstanceBuffer = nullptr;
     Ref<Sampler> m_SpriteTextureSampler = nullptr;
+    // Drawn for sprites without a texture, so they show their color.
+    Ref<TextureView> m_WhiteTexture = nullptr;
+
+    Scope<ResourceSetCache> m_ResourceSetCache = nullptr;
+    Scope<RenderGraph> m_RenderGraph = nullptr;
+    BindlessTextureTable* m_BindlessTable = nullptr;
 
-    std::vector<SpriteVertex> m_SpriteVertices;
+    std::vector<SpriteComponent*> m_Sprites;
+    SpriteInstance* m_SpriteInstances = nullptr;
     std::array<Ref<TextureView>, MAX_TEXTURE_SLOTS> m_TextureSlots;
-    uint32_t m_VertexCount = 0;
+    uint32_t m_InstanceCount = 0;
+    uint32_t m_InstanceCapacity = INITIAL_SPRITE_CAPACITY;
+    uint32_t m_BatchStart = 0;
     uint32_t m_TextureSlotIndex = 0;
 
 };
@@ -0,0 +1,25 @@
+#ifndef AERO3D_UTILS_HASH_H_
+#define AERO3D_UTILS_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace aero3d {
+
+constexpr uint64_t FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV1A_PRIME = 0x100000001b3ull;
+
+inline uint64_t HashFNV1a(const void* data, size_t size, uint64_t hash = FNV1A_OFFSET_BASIS)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
+
+} // namespace aero3d
+
+#endif // AERO3D_UTILS_HASH_H_
@@ -1,5 +1,7 @@
 #include "Utils/ImageLoader.h"
 
+#include <algorithm>
+#include <cctype>
 #include <cstring>
 
 #include <stb_image/std_image.h>
@@ -9,22 +11,179 @@
 
 namespace aero3d {
 
-ImageData ImageLoader::LoadImage(std::string path) 
+// Keeps level sizes far from overflowing, no device samples larger images.
+constexpr uint32_t MAX_IMAGE_DIMENSION = 16384;
+
+constexpr uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+constexpr uint32_t DDS_FLAG_MIPMAPCOUNT = 0x20000;
+constexpr uint32_t DDS_FLAG_DEPTH = 0x800000;
+constexpr uint32_t DDS_CAPS2_CUBEMAP = 0x200;
+constexpr uint32_t DDS_CAPS2_VOLUME = 0x200000;
+constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+constexpr uint32_t DDS_MISC_TEXTURECUBE = 0x4;
+constexpr uint32_t DDS_PIXELFORMAT_FOURCC = 0x4;
+constexpr uint32_t DDS_PIXELFORMAT_RGB = 0x40;
+
+constexpr uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+static constexpr uint32_t MakeFourCC(char a, char b, char c, char d)
+{
+    return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) |
+        (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+}
+
+struct DDSPixelFormat
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t rBitMask;
+    uint32_t gBitMask;
+    uint32_t bBitMask;
+    uint32_t aBitMask;
+};
+
+struct DDSHeader
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    DDSPixelFormat pixelFormat;
+    uint32_t caps;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+    uint32_t reserved2;
+};
+
+struct DDSHeaderDX10
+{
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+struct KTX2Header
+{
+    uint8_t identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+
+struct KTX2Level
+{
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+static bool FromDXGIFormat(uint32_t dxgiFormat, TextureFormat& format)
+{
+    switch (dxgiFormat)
+    {
+        case 28: format = TextureFormat::RGBA8; return true;
+        case 29: format = TextureFormat::RGBA8_SRGB; return true;
+        case 87: format = TextureFormat::BGRA8; return true;
+        case 91: format = TextureFormat::BGRA8_SRGB; return true;
+        case 71: format = TextureFormat::BC1; return true;
+        case 72: format = TextureFormat::BC1_SRGB; return true;
+        case 77: format = TextureFormat::BC3; return true;
+        case 78: format = TextureFormat::BC3_SRGB; return true;
+        case 83: format = TextureFormat::BC5; return true;
+        case 98: format = TextureFormat::BC7; return true;
+        case 99: format = TextureFormat::BC7_SRGB; return true;
+        default: return false;
+    }
+}
+
+// KTX2 stores VkFormat values, kept numeric so this stays API agnostic.
+static bool FromKTX2Format(uint32_t vkFormat, TextureFormat& format)
+{
+    switch (vkFormat)
+    {
+        case 37: format = TextureFormat::RGBA8; return true;
+        case 43: format = TextureFormat::RGBA8_SRGB; return true;
+        case 44: format = TextureFormat::BGRA8; return true;
+        case 50: format = TextureFormat::BGRA8_SRGB; return true;
+        case 100: format = TextureFormat::R32FLOAT; return true;
+        case 133: format = TextureFormat::BC1; return true;
+        case 134: format = TextureFormat::BC1_SRGB; return true;
+        case 137: format = TextureFormat::BC3; return true;
+        case 138: format = TextureFormat::BC3_SRGB; return true;
+        case 141: format = TextureFormat::BC5; return true;
+        case 145: format = TextureFormat::BC7; return true;
+        case 146: format = TextureFormat::BC7_SRGB; return true;
+        default: return false;
+    }
+}
+
+static bool IsValidImageSize(uint32_t width, uint32_t height)
+{
+    return width > 0 && height > 0 && width <= MAX_IMAGE_DIMENSION && height <= MAX_IMAGE_DIMENSION;
+}
+
+static bool HasExtension(const std::string& path, const char* extension)
+{
+    size_t length = strlen(extension);
+    if (path.length() < length)
+        return false;
+
+    return std::equal(path.end() - length, path.end(), extension, [](char a, char b)
+    {
+        return std::tolower(static_cast<unsigned char>(a)) == b;
+    });
+}
+
+ImageData ImageLoader::LoadImage(std::string path)
 {
     ImageData imageData{};
 
     int texWidth, texHeight, texChannels;
 
     Ref<VFile> file = VFS::ReadFile(path);
+    if (!file)
+    {
+        LogErr(ERROR_INFO, "Failed to open image: %s", path.c_str());
+        return imageData;
+    }
     file->Load();
 
-    const stbi_uc* data = reinterpret_cast<const stbi_uc*>(file->GetData());
-    int size = static_cast<int>(file->GetLength());
+    const uint8_t* fileData = static_cast<const uint8_t*>(file->GetData());
+    size_t fileSize = static_cast<size_t>(file->GetLength());
+
+    if (HasExtension(path, ".dds"))
+        return LoadDDS(path, fileData, fileSize);
+    if (HasExtension(path, ".ktx2"))
+        return LoadKTX2(path, fileData, fileSize);
 
-    stbi_uc* pixels = stbi_load_from_memory(data, size, 
+    const stbi_uc* data = reinterpret_cast<const stbi_uc*>(fileData);
+    int size = static_cast<int>(fileSize);
+
+    stbi_uc* pixels = stbi_load_from_memory(data, size,
         &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
 
-    if (!pixels) 
+    if (!pixels)
     {
         LogErr(ERROR_INFO, "Failed to load image: %s", path.c_str());
         return imageData;
@@ -41,4 +200,186 @@ ImageData ImageLoader::LoadImage(std::string path)
     return imageData;
 }
 
-} // namespace aero3d
\ No newline at end of file
+ImageData ImageLoader::LoadDDS(const std::string& path, const uint8_t* data, size_t size)
+{
+    ImageData imageData{};
+
+    uint32_t magic = 0;
+    DDSHeader header{};
+
+    if (size < sizeof(magic) + sizeof(header))
+    {
+        LogErr(ERROR_INFO, "DDS file is truncated: %s", path.c_str());
+        return imageData;
+    }
+
+    std::memcpy(&magic, data, sizeof(magic));
+    std::memcpy(&header, data + sizeof(magic), sizeof(header));
+    size_t offset = sizeof(magic) + sizeof(header);
+
+    if (magic != DDS_MAGIC || header.size != sizeof(DDSHeader))
+    {
+        LogErr(ERROR_INFO, "Not a DDS file: %s", path.c_str());
+        return imageData;
+    }
+
+    const DDSPixelFormat& pf = header.pixelFormat;
+    bool known = false;
+
+    if (pf.flags & DDS_PIXELFORMAT_FOURCC)
+    {
+        switch (pf.fourCC)
+        {
+            case MakeFourCC('D', 'X', 'T', '1'): imageData.format = TextureFormat::BC1; known = true; break;
+            case MakeFourCC('D', 'X', 'T', '5'): imageData.format = TextureFormat::BC3; known = true; break;
+            case MakeFourCC('A', 'T', 'I', '2'):
+            case MakeFourCC('B', 'C', '5', 'U'): imageData.format = TextureFormat::BC5; known = true; break;
+            case MakeFourCC('D', 'X', '1', '0'):
+            {
+                DDSHeaderDX10 dx10{};
+                if (size < offset + sizeof(dx10))
+                    break;
+
+                std::memcpy(&dx10, data + offset, sizeof(dx10));
+                offset += sizeof(dx10);
+
+                if (dx10.resourceDimension != DDS_DIMENSION_TEXTURE2D || dx10.arraySize != 1 ||
+                    (dx10.miscFlag & DDS_MISC_TEXTURECUBE))
+                {
+                    LogErr(ERROR_INFO, "Only single 2D DDS textures are supported: %s", path.c_str());
+                    return imageData;
+                }
+
+                known = FromDXGIFormat(dx10.dxgiFormat, imageData.format);
+                break;
+            }
+        }
+    }
+    else if ((pf.flags & DDS_PIXELFORMAT_RGB) && pf.rgbBitCount == 32)
+    {
+        if (pf.rBitMask == 0x000000FF && pf.bBitMask == 0x00FF0000)
+        {
+            imageData.format = TextureFormat::RGBA8;
+            known = true;
+        }
+        else if (pf.rBitMask == 0x00FF0000 && pf.bBitMask == 0x000000FF)
+        {
+            imageData.format = TextureFormat::BGRA8;
+            known = true;
+        }
+    }
+
+    if (!known)
+    {
+        LogErr(ERROR_INFO, "Unsupported DDS pixel format: %s", path.c_str());
+        return imageData;
+    }
+
+    if ((header.caps2 & (DDS_CAPS2_CUBEMAP | DDS_CAPS2_VOLUME)) ||
+        ((header.flags & DDS_FLAG_DEPTH) && header.depth > 1))
+    {
+        LogErr(ERROR_INFO, "Only single 2D DDS textures are supported: %s", path.c_str());
+        return imageData;
+    }
+    if (!IsValidImageSize(header.width, header.height))
+    {
+        LogErr(ERROR_INFO, "Invalid DDS size %ux%u: %s", header.width, header.height, path.c_str());
+        return imageData;
+    }
+
+    imageData.width = header.width;
+    imageData.height = header.height;
+    imageData.channels = imageData.format == TextureFormat::BC5 ? 2 : 4;
+    imageData.mipLevels = (header.flags & DDS_FLAG_MIPMAPCOUNT) ? std::max(header.mipMapCount, 1u) : 1;
+    imageData.mipLevels = std::min(imageData.mipLevels, CalculateMipLevels(imageData.width, imageData.height));
+
+    size_t dataSize = 0;
+    for (uint32_t level = 0; level < imageData.mipLevels; level++)
+    {
+        dataSize += GetTextureLevelSize(imageData.format, imageData.width >> level, imageData.height >> level);
+    }
+
+    if (size < offset + dataSize)
+    {
+        LogErr(ERROR_INFO, "DDS file is truncated: %s", path.c_str());
+        return ImageData{};
+    }
+
+    imageData.pixels.assign(data + offset, data + offset + dataSize);
+    return imageData;
+}
+
+ImageData ImageLoader::LoadKTX2(const std::string& path, const uint8_t* data, size_t size)
+{
+    ImageData imageData{};
+
+    KTX2Header header{};
+    if (size < sizeof(header))
+    {
+        LogErr(ERROR_INFO, "KTX2 file is truncated: %s", path.c_str());
+        return imageData;
+    }
+
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+    {
+        LogErr(ERROR_INFO, "Not a KTX2 file: %s", path.c_str());
+        return imageData;
+    }
+    if (header.supercompressionScheme != 0)
+    {
+        LogErr(ERROR_INFO, "Supercompressed KTX2 files are not supported: %s", path.c_str());
+        return imageData;
+    }
+    if (!FromKTX2Format(header.vkFormat, imageData.format))
+    {
+        LogErr(ERROR_INFO, "Unsupported KTX2 format %u: %s", header.vkFormat, path.c_str());
+        return imageData;
+    }
+
+    // A height of zero is a 1D texture, a depth a volume.
+    if (header.pixelDepth != 0 || header.layerCount > 1 || header.faceCount != 1)
+    {
+        LogErr(ERROR_INFO, "Only single 2D KTX2 textures are supported: %s", path.c_str());
+        return imageData;
+    }
+    if (!IsValidImageSize(header.pixelWidth, header.pixelHeight))
+    {
+        LogErr(ERROR_INFO, "Invalid KTX2 size %ux%u: %s", header.pixelWidth, header.pixelHeight, path.c_str());
+        return imageData;
+    }
+
+    imageData.width = header.pixelWidth;
+    imageData.height = header.pixelHeight;
+    imageData.channels = imageData.format == TextureFormat::BC5 ? 2 : 4;
+    // Zero levels asks the loader to generate them.
+    imageData.mipLevels = std::max(header.levelCount, 1u);
+    imageData.mipLevels = std::min(imageData.mipLevels, CalculateMipLevels(imageData.width, imageData.height));
+
+    if (size < sizeof(header) + imageData.mipLevels * sizeof(KTX2Level))
+    {
+        LogErr(ERROR_INFO, "KTX2 file is truncated: %s", path.c_str());
+        return ImageData{};
+    }
+
+    for (uint32_t level = 0; level < imageData.mipLevels; level++)
+    {
+        KTX2Level index{};
+        std::memcpy(&index, data + sizeof(header) + level * sizeof(KTX2Level), sizeof(index));
+
+        size_t levelSize = GetTextureLevelSize(imageData.format, imageData.width >> level, imageData.height >> level);
+
+        if (index.byteLength < levelSize || index.byteOffset > size || levelSize > size - index.byteOffset)
+        {
+            LogErr(ERROR_INFO, "KTX2 level %u is truncated: %s", level, path.c_str());
+            return ImageData{};
+        }
+
+        imageData.pixels.insert(imageData.pixels.end(), data + index.byteOffset, data + index.byteOffset + levelSize);
+    }
+
+    return imageData;
+}
+
+} // namespace aero3d
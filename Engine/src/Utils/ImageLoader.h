@@ -14,15 +14,23 @@ struct ImageData
     uint32_t width;
     uint32_t height;
     uint32_t channels;
+    uint32_t mipLevels = 1;
     TextureFormat format;
+    // All levels tightly packed, largest first.
     std::vector<uint8_t> pixels;
 };
 
 class ImageLoader
 {
 public:
+    // .dds and .ktx2 files are loaded as stored, including block
+    // compression and mip chains. Everything else is decoded to RGBA8.
     static ImageData LoadImage(std::string path);
 
+private:
+    static ImageData LoadDDS(const std::string& path, const uint8_t* data, size_t size);
+    static ImageData LoadKTX2(const std::string& path, const uint8_t* data, size_t size);
+
 };
 
 } // namespace aero3d
@@ -0,0 +1,15 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec2 fragUV;
+layout(location = 1) flat in uint fragTexIndex;
+layout(location = 2) in vec4 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform sampler uSampler;
+layout(set = 0, binding = 1) uniform texture2D uTextures[];
+
+void main() {
+    outColor = texture(sampler2D(uTextures[nonuniformEXT(fragTexIndex)], uSampler), fragUV) * fragColor;
+}
\ No newline at end of file
@@ -1,14 +1,21 @@
 #version 450
 
-layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec2 inUV;
-layout(location = 2) in float inTexIndex;
+layout(location = 0) in vec2 inCorner;
+layout(location = 1) in vec3 inAxisX;
+layout(location = 2) in vec3 inAxisY;
+layout(location = 3) in vec3 inTranslation;
+layout(location = 4) in vec4 inUVRect;
+layout(location = 5) in vec4 inColor;
+layout(location = 6) in uint inTexIndex;
 
 layout(location = 0) out vec2 fragUV;
-layout(location = 1) out float fragTexIndex;
+layout(location = 1) flat out uint fragTexIndex;
+layout(location = 2) out vec4 fragColor;
 
 void main() {
-    gl_Position = vec4(inPos, 1.0);
-    fragUV = inUV;
+    vec3 position = inTranslation + inAxisX * inCorner.x + inAxisY * inCorner.y;
+    gl_Position = vec4(position, 1.0);
+    fragUV = mix(inUVRect.xy, inUVRect.zw, inCorner + 0.5);
     fragTexIndex = inTexIndex;
+    fragColor = inColor;
 }
\ No newline at end of file
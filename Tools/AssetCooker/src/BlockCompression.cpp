@@ -0,0 +1,254 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace aero3d {
+
+constexpr uint32_t BLOCK_TEXELS = 16;
+
+static void FetchBlock(const uint8_t* pixels, uint32_t width, uint32_t height,
+    uint32_t blockX, uint32_t blockY, uint8_t block[BLOCK_TEXELS * 4])
+{
+    for (uint32_t y = 0; y < 4; y++)
+    {
+        uint32_t srcY = std::min(blockY * 4 + y, height - 1);
+        for (uint32_t x = 0; x < 4; x++)
+        {
+            uint32_t srcX = std::min(blockX * 4 + x, width - 1);
+            memcpy(&block[(y * 4 + x) * 4], &pixels[(srcY * width + srcX) * 4], 4);
+        }
+    }
+}
+
+static uint16_t To565(int r, int g, int b)
+{
+    return static_cast<uint16_t>(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+}
+
+static void From565(uint16_t color, int out[3])
+{
+    int r = (color >> 11) & 31;
+    int g = (color >> 5) & 63;
+    int b = color & 31;
+
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+}
+
+static void WriteU16(uint8_t* out, uint16_t value)
+{
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+// BC3 always decodes the color block with four colors, BC1 switches to
+// three colors and transparent black when c0 <= c1.
+static void EncodeColorBlock(const uint8_t block[BLOCK_TEXELS * 4], bool punchThrough, uint8_t out[8])
+{
+    bool transparent = false;
+    if (punchThrough)
+    {
+        for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+        {
+            transparent |= block[i * 4 + 3] < 128;
+        }
+    }
+
+    int minColor[3] = { 255, 255, 255 };
+    int maxColor[3] = { 0, 0, 0 };
+    bool any = false;
+
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+    {
+        if (transparent && block[i * 4 + 3] < 128)
+            continue;
+
+        for (int c = 0; c < 3; c++)
+        {
+            minColor[c] = std::min(minColor[c], static_cast<int>(block[i * 4 + c]));
+            maxColor[c] = std::max(maxColor[c], static_cast<int>(block[i * 4 + c]));
+        }
+        any = true;
+    }
+
+    if (!any)
+    {
+        // Fully transparent: c0 <= c1 and every index 3.
+        WriteU16(out, 0);
+        WriteU16(out + 2, 0);
+        memset(out + 4, 0xFF, 4);
+        return;
+    }
+
+    // Pull the endpoints in a little, the box corners are rarely on the line.
+    for (int c = 0; c < 3; c++)
+    {
+        int inset = (maxColor[c] - minColor[c]) / 16;
+        minColor[c] += inset;
+        maxColor[c] -= inset;
+    }
+
+    uint16_t c0 = To565(maxColor[0], maxColor[1], maxColor[2]);
+    uint16_t c1 = To565(minColor[0], minColor[1], minColor[2]);
+
+    if (transparent ? c0 > c1 : c0 < c1)
+    {
+        std::swap(c0, c1);
+    }
+
+    int palette[4][3];
+    From565(c0, palette[0]);
+    From565(c1, palette[1]);
+
+    uint32_t paletteSize = 4;
+    if (c0 > c1 || !punchThrough)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+    else
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+        }
+        paletteSize = 3;
+    }
+
+    uint32_t indices = 0;
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+    {
+        uint32_t best = 0;
+
+        if (paletteSize == 3 && block[i * 4 + 3] < 128)
+        {
+            best = 3;
+        }
+        else
+        {
+            int bestDistance = INT32_MAX;
+            for (uint32_t p = 0; p < paletteSize; p++)
+            {
+                int distance = 0;
+                for (int c = 0; c < 3; c++)
+                {
+                    int d = block[i * 4 + c] - palette[p][c];
+                    distance += d * d;
+                }
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+        }
+
+        indices |= best << (i * 2);
+    }
+
+    WriteU16(out, c0);
+    WriteU16(out + 2, c1);
+    memcpy(out + 4, &indices, 4);
+}
+
+static void EncodeAlphaBlock(const uint8_t block[BLOCK_TEXELS * 4], uint8_t out[8])
+{
+    int minAlpha = 255;
+    int maxAlpha = 0;
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+    {
+        minAlpha = std::min(minAlpha, static_cast<int>(block[i * 4 + 3]));
+        maxAlpha = std::max(maxAlpha, static_cast<int>(block[i * 4 + 3]));
+    }
+
+    out[0] = static_cast<uint8_t>(maxAlpha);
+    out[1] = static_cast<uint8_t>(minAlpha);
+
+    // a0 > a1 selects eight interpolated values.
+    int palette[8];
+    palette[0] = maxAlpha;
+    palette[1] = minAlpha;
+    for (int p = 1; p < 7; p++)
+    {
+        palette[p + 1] = ((7 - p) * maxAlpha + p * minAlpha) / 7;
+    }
+
+    uint64_t indices = 0;
+    if (maxAlpha > minAlpha)
+    {
+        for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+        {
+            int alpha = block[i * 4 + 3];
+            uint64_t best = 0;
+            int bestDistance = INT32_MAX;
+
+            for (uint32_t p = 0; p < 8; p++)
+            {
+                int distance = std::abs(alpha - palette[p]);
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+
+            indices |= best << (i * 3);
+        }
+    }
+
+    for (int b = 0; b < 6; b++)
+    {
+        out[2 + b] = static_cast<uint8_t>(indices >> (b * 8));
+    }
+}
+
+std::vector<uint8_t> CompressBC1(const uint8_t* pixels, uint32_t width, uint32_t height)
+{
+    uint32_t blocksX = (width + 3) / 4;
+    uint32_t blocksY = (height + 3) / 4;
+
+    std::vector<uint8_t> result(static_cast<size_t>(blocksX) * blocksY * 8);
+    uint8_t block[BLOCK_TEXELS * 4];
+
+    for (uint32_t y = 0; y < blocksY; y++)
+    {
+        for (uint32_t x = 0; x < blocksX; x++)
+        {
+            FetchBlock(pixels, width, height, x, y, block);
+            EncodeColorBlock(block, true, &result[(static_cast<size_t>(y) * blocksX + x) * 8]);
+        }
+    }
+
+    return result;
+}
+
+std::vector<uint8_t> CompressBC3(const uint8_t* pixels, uint32_t width, uint32_t height)
+{
+    uint32_t blocksX = (width + 3) / 4;
+    uint32_t blocksY = (height + 3) / 4;
+
+    std::vector<uint8_t> result(static_cast<size_t>(blocksX) * blocksY * 16);
+    uint8_t block[BLOCK_TEXELS * 4];
+
+    for (uint32_t y = 0; y < blocksY; y++)
+    {
+        for (uint32_t x = 0; x < blocksX; x++)
+        {
+            uint8_t* out = &result[(static_cast<size_t>(y) * blocksX + x) * 16];
+
+            FetchBlock(pixels, width, height, x, y, block);
+            EncodeAlphaBlock(block, out);
+            EncodeColorBlock(block, false, out + 8);
+        }
+    }
+
+    return result;
+}
+
+} // namespace aero3d
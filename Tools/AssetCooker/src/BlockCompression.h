@@ -0,0 +1,16 @@
+#ifndef AERO3D_ASSETCOOKER_BLOCKCOMPRESSION_H_
+#define AERO3D_ASSETCOOKER_BLOCKCOMPRESSION_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace aero3d {
+
+// Fast bounding box encoders, good enough for diffuse textures. Input is
+// RGBA8, edge blocks repeat the last row and column.
+std::vector<uint8_t> CompressBC1(const uint8_t* pixels, uint32_t width, uint32_t height);
+std::vector<uint8_t> CompressBC3(const uint8_t* pixels, uint32_t width, uint32_t height);
+
+} // namespace aero3d
+
+#endif // AERO3D_ASSETCOOKER_BLOCKCOMPRESSION_H_
@@ -0,0 +1,108 @@
+#include "PakWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "IO/PakFormat.h"
+
+namespace aero3d {
+
+static bool WritePadding(FILE* file, uint64_t& offset, uint64_t alignment)
+{
+    static const uint8_t zeros[PAK_DATA_ALIGNMENT] = {};
+
+    uint64_t padding = (alignment - offset % alignment) % alignment;
+    offset += padding;
+    return padding == 0 || fwrite(zeros, 1, padding, file) == padding;
+}
+
+bool WritePak(const std::string& directory, const std::string& output)
+{
+    namespace fs = std::filesystem;
+
+    std::error_code error;
+    std::vector<fs::path> files;
+    for (const auto& item : fs::recursive_directory_iterator(directory, error))
+    {
+        if (item.is_regular_file())
+        {
+            files.push_back(item.path());
+        }
+    }
+
+    if (error)
+    {
+        fprintf(stderr, "Failed to list %s: %s\n", directory.c_str(), error.message().c_str());
+        return false;
+    }
+
+    FILE* file = fopen(output.c_str(), "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open %s for writing.\n", output.c_str());
+        return false;
+    }
+
+    PakHeader header;
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    uint64_t offset = sizeof(header);
+
+    std::vector<PakEntry> entries;
+    std::string paths;
+
+    for (const fs::path& path : files)
+    {
+        std::ifstream input(path, std::ios::binary);
+        std::vector<char> contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+        written = written && WritePadding(file, offset, PAK_DATA_ALIGNMENT);
+
+        std::string relative = fs::relative(path, directory).generic_string();
+
+        PakEntry entry;
+        entry.pathHash = HashPakPath(relative);
+        entry.offset = offset;
+        entry.size = contents.size();
+        entry.pathOffset = static_cast<uint32_t>(paths.size());
+        entry.pathLength = static_cast<uint32_t>(relative.size());
+        entries.push_back(entry);
+
+        paths += relative;
+
+        written = written && fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+        offset += contents.size();
+    }
+
+    std::sort(entries.begin(), entries.end(),
+        [](const PakEntry& a, const PakEntry& b) { return a.pathHash < b.pathHash; });
+
+    written = written && WritePadding(file, offset, PAK_DATA_ALIGNMENT);
+
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.tocOffset = offset;
+    header.tocSize = entries.size() * sizeof(PakEntry) + paths.size();
+
+    written = written &&
+        fwrite(entries.data(), sizeof(PakEntry), entries.size(), file) == entries.size() &&
+        fwrite(paths.data(), 1, paths.size(), file) == paths.size() &&
+        fseek(file, 0, SEEK_SET) == 0 &&
+        fwrite(&header, sizeof(header), 1, file) == 1;
+
+    fclose(file);
+
+    if (!written)
+    {
+        fprintf(stderr, "Failed to write %s.\n", output.c_str());
+        remove(output.c_str());
+        return false;
+    }
+
+    printf("Packed %zu files into %s.\n", entries.size(), output.c_str());
+    return true;
+}
+
+} // namespace aero3d
@@ -0,0 +1,14 @@
+#ifndef AERO3D_ASSETCOOKER_PAKWRITER_H_
+#define AERO3D_ASSETCOOKER_PAKWRITER_H_
+
+#include <string>
+
+namespace aero3d {
+
+// Packs every regular file below directory into a .pak archive, paths
+// relative to directory.
+bool WritePak(const std::string& directory, const std::string& output);
+
+} // namespace aero3d
+
+#endif // AERO3D_ASSETCOOKER_PAKWRITER_H_
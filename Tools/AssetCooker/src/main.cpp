@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <stb_image/std_image.h>
+
+#include "BlockCompression.h"
+#include "PakWriter.h"
+#include "Graphics/Resources.h"
+#include "Resource/CookedTexture.h"
+
+namespace aero3d {
+
+struct CookOptions
+{
+    std::string input;
+    std::string output;
+    std::string format = "rgba8";
+    bool srgb = false;
+    bool mipmaps = true;
+    bool pack = false;
+};
+
+static float ToLinear(uint8_t value)
+{
+    float c = value / 255.0f;
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static uint8_t FromLinear(float value)
+{
+    float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    return static_cast<uint8_t>(std::fmin(std::fmax(c, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+// 2x2 box filter, averaged in linear space for sRGB color. Odd edges reuse
+// the last texel.
+static std::vector<uint8_t> Downsample(const std::vector<uint8_t>& src, uint32_t width, uint32_t height, bool srgb)
+{
+    uint32_t dstWidth = std::max(width / 2, 1u);
+    uint32_t dstHeight = std::max(height / 2, 1u);
+
+    std::vector<uint8_t> dst(static_cast<size_t>(dstWidth) * dstHeight * 4);
+
+    for (uint32_t y = 0; y < dstHeight; y++)
+    {
+        uint32_t y0 = std::min(y * 2, height - 1);
+        uint32_t y1 = std::min(y * 2 + 1, height - 1);
+
+        for (uint32_t x = 0; x < dstWidth; x++)
+        {
+            uint32_t x0 = std::min(x * 2, width - 1);
+            uint32_t x1 = std::min(x * 2 + 1, width - 1);
+
+            const uint8_t* texels[4] = {
+                &src[(static_cast<size_t>(y0) * width + x0) * 4],
+                &src[(static_cast<size_t>(y0) * width + x1) * 4],
+                &src[(static_cast<size_t>(y1) * width + x0) * 4],
+                &src[(static_cast<size_t>(y1) * width + x1) * 4]
+            };
+
+            uint8_t* out = &dst[(static_cast<size_t>(y) * dstWidth + x) * 4];
+            for (int c = 0; c < 4; c++)
+            {
+                if (srgb && c < 3)
+                {
+                    float sum = 0.0f;
+                    for (const uint8_t* texel : texels) sum += ToLinear(texel[c]);
+                    out[c] = FromLinear(sum / 4.0f);
+                }
+                else
+                {
+                    int sum = 0;
+                    for (const uint8_t* texel : texels) sum += texel[c];
+                    out[c] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+    }
+
+    return dst;
+}
+
+static bool ParseFormat(const CookOptions& options, TextureFormat& format)
+{
+    if (options.format == "rgba8")
+        format = options.srgb ? TextureFormat::RGBA8_SRGB : TextureFormat::RGBA8;
+    else if (options.format == "bc1")
+        format = options.srgb ? TextureFormat::BC1_SRGB : TextureFormat::BC1;
+    else if (options.format == "bc3")
+        format = options.srgb ? TextureFormat::BC3_SRGB : TextureFormat::BC3;
+    else
+        return false;
+
+    return true;
+}
+
+static std::vector<uint8_t> EncodeLevel(TextureFormat format, const std::vector<uint8_t>& pixels,
+    uint32_t width, uint32_t height)
+{
+    switch (format)
+    {
+        case TextureFormat::BC1:
+        case TextureFormat::BC1_SRGB: return CompressBC1(pixels.data(), width, height);
+        case TextureFormat::BC3:
+        case TextureFormat::BC3_SRGB: return CompressBC3(pixels.data(), width, height);
+        default: return pixels;
+    }
+}
+
+static bool CookTexture(const CookOptions& options)
+{
+    TextureFormat format;
+    if (!ParseFormat(options, format))
+    {
+        fprintf(stderr, "Unknown format '%s', expected rgba8, bc1 or bc3.\n", options.format.c_str());
+        return false;
+    }
+
+    int width, height, channels;
+    stbi_uc* data = stbi_load(options.input.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (!data)
+    {
+        fprintf(stderr, "Failed to load %s: %s\n", options.input.c_str(), stbi_failure_reason());
+        return false;
+    }
+
+    CookedTextureHeader header;
+    header.format = static_cast<uint32_t>(format);
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.mipLevels = options.mipmaps ? CalculateMipLevels(header.width, header.height) : 1;
+    header.dataOffset = sizeof(CookedTextureHeader);
+
+    std::vector<uint8_t> level(data, data + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(data);
+
+    std::vector<uint8_t> payload;
+    uint32_t levelWidth = header.width;
+    uint32_t levelHeight = header.height;
+
+    for (uint32_t i = 0; i < header.mipLevels; i++)
+    {
+        if (i > 0)
+        {
+            level = Downsample(level, levelWidth, levelHeight, options.srgb);
+            levelWidth = std::max(levelWidth / 2, 1u);
+            levelHeight = std::max(levelHeight / 2, 1u);
+        }
+
+        std::vector<uint8_t> encoded = EncodeLevel(format, level, levelWidth, levelHeight);
+        payload.insert(payload.end(), encoded.begin(), encoded.end());
+    }
+
+    header.dataSize = payload.size();
+
+    FILE* file = fopen(options.output.c_str(), "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open %s for writing.\n", options.output.c_str());
+        return false;
+    }
+
+    bool written =
+        fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(payload.data(), 1, payload.size(), file) == payload.size();
+
+    fclose(file);
+
+    if (!written)
+    {
+        fprintf(stderr, "Failed to write %s.\n", options.output.c_str());
+        remove(options.output.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+static void PrintUsage()
+{
+    printf("Usage: AssetCooker [--format rgba8|bc1|bc3] [--srgb] [--no-mips] <image> <output.a3dtex>\n");
+    printf("       AssetCooker --pack <directory> <output.pak>\n");
+}
+
+} // namespace aero3d
+
+int main(int argc, char** argv)
+{
+    aero3d::CookOptions options;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            options.format = argv[++i];
+        }
+        else if (strcmp(argv[i], "--srgb") == 0)
+        {
+            options.srgb = true;
+        }
+        else if (strcmp(argv[i], "--no-mips") == 0)
+        {
+            options.mipmaps = false;
+        }
+        else if (strcmp(argv[i], "--pack") == 0)
+        {
+            options.pack = true;
+        }
+        else if (argv[i][0] == '-')
+        {
+            aero3d::PrintUsage();
+            return 1;
+        }
+        else
+        {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    if (paths.size() != 2)
+    {
+        aero3d::PrintUsage();
+        return 1;
+    }
+
+    options.input = paths[0];
+    options.output = paths[1];
+
+    if (options.pack)
+        return aero3d::WritePak(options.input, options.output) ? 0 : 1;
+
+    return aero3d::CookTexture(options) ? 0 : 1;
+}